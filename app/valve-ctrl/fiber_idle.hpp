@@ -0,0 +1,85 @@
+/*
+//////////////////////////////////////////////////////////////////////
+// _   _                                       _                    //
+//| | | |_   _ _ __   ___   ___ __ _ _   _ ___| |_ _   _ _ __ ___   //
+//| |_| | | | | '_ \ / _ \ / __/ _` | | | / __| __| | | | '_ ` _ \  //
+//|  _  | |_| | |_) | (_) | (_| (_| | |_| \__ \ |_| |_| | | | | | | //
+//|_| |_|\__, | .__/ \___/ \___\__,_|\__,_|___/\__|\__,_|_| |_| |_| //
+//       |___/|_|                                                   //
+//////////////////////////////////////////////////////////////////////
+
+A under floor heating control system for DC-Mootor Vales like HmIP VDMOT
+This project is based on the modm library.
+
+Copyright(C) 2024 Alexander Evers
+
+This program is free software;
+you can redistribute it and / or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation;
+either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program;
+if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110 - 1301, USA
+*/
+#ifndef FIBER_IDLE_HPP
+#define FIBER_IDLE_HPP
+
+#include <algorithm>
+#include <stdint.h>
+#include <modm/platform/device.hpp>
+
+/**
+ * Idle hook of the fiber scheduler that sleeps until the next fiber is due.
+ *
+ * The timer counts microseconds in one-pulse mode and its update interrupt
+ * wakes the core from WFI. The 16-bit counter limits a sleep to 65.5ms, the
+ * scheduler then calls the hook again. Call `handleInterrupt()` from the
+ * update interrupt of the timer and `sleep()` from `modm_fiber_idle()`.
+ */
+template< class Timer >
+class FiberIdle
+{
+public:
+	/// @param	prescaler	timer clock in MHz, so that the counter runs at 1MHz
+	static void
+	initialize(uint16_t prescaler, uint32_t isrPriority)
+	{
+		Timer::enable();
+		Timer::setMode(Timer::Mode::OneShotUpCounter);
+		Timer::setPrescaler(prescaler);
+		Timer::enableInterrupt(Timer::Interrupt::Update);
+		Timer::enableInterruptVector(Timer::Interrupt::Update, true, isrPriority);
+	}
+
+	/// Called with interrupts disabled, a pending interrupt still ends the WFI.
+	static void
+	sleep(uint32_t duration)
+	{
+		// the counter does not run with an overflow of zero
+		if (duration < 2) return;
+		if (duration != 0xffff'ffff)
+		{
+			Timer::setOverflow(std::min<uint32_t>(duration, 0x1'0000) - 1);
+			// loads prescaler and overflow without setting the update flag
+			Timer::applyAndReset();
+			Timer::start();
+		}
+		__WFI();
+		Timer::pause();
+	}
+
+	static void
+	handleInterrupt()
+	{
+		Timer::acknowledgeInterruptFlags(Timer::InterruptFlag::Update);
+	}
+};
+
+#endif // FIBER_IDLE_HPP
@@ -34,19 +34,96 @@ if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth F
 #include <modm/processing.hpp>
 #include <modm/platform.hpp>
 
+#include "fiber_idle.hpp"
+
 
 // ----------------------------------------------------------------------------
 // Set the log level
 #undef MODM_LOG_LEVEL
 #define MODM_LOG_LEVEL modm::log::INFO
 
+// RTT channel 0: text log, channel 1: binary telemetry, channel 2: commands,
+// channel 3: deferred binary log
 																												 Rtt rtt(0);
 modm::IODeviceObjectWrapper<Rtt, modm::IOBuffer::DiscardIfFull> rtt_device(rtt);
-// Set all four logger streams to use RTT
-modm::log::Logger modm::log::debug(rtt_device);
-modm::log::Logger modm::log::info(rtt_device);
-modm::log::Logger modm::log::warning(rtt_device);
-modm::log::Logger modm::log::error(rtt_device);
+// All log streams write records into lock-free rings, which are drained to
+// RTT by a low priority fiber, so that interrupts can log without blocking
+modm::log::Ring<2048> log_ring;
+modm::log::RingDevice<decltype(log_ring)> log_debug_device(log_ring, modm::log::DEBUG);
+modm::log::RingDevice<decltype(log_ring)> log_info_device(log_ring, modm::log::INFO);
+modm::log::RingDevice<decltype(log_ring)> log_warning_device(log_ring, modm::log::WARNING);
+modm::log::RingDevice<decltype(log_ring)> log_error_device(log_ring, modm::log::ERROR);
+modm::log::Logger modm::log::debug(log_debug_device);
+modm::log::Logger modm::log::info(log_info_device);
+modm::log::Logger modm::log::warning(log_warning_device);
+modm::log::Logger modm::log::error(log_error_device);
+
+Rtt rtt_deferred(3);
+modm::IODeviceObjectWrapper<Rtt, modm::IOBuffer::DiscardIfFull> rtt_deferred_device(rtt_deferred);
+modm::log::Ring<1024> deferred_ring;
+modm::log::RingBlockDevice<decltype(deferred_ring)> deferred_device(deferred_ring, modm::log::DEBUG);
+modm::log::DeferredLogger modm::log::deferred(deferred_device);
+
+modm::Fiber<> log_fiber([]
+{
+	while (true)
+	{
+		log_ring.drain(rtt_device);
+		deferred_ring.drainPayload(rtt_deferred_device);
+		// the rings buffer the records in between
+		modm::this_fiber::sleep_for(std::chrono::milliseconds(5));
+	}
+}, modm::fiber::Start::Now, modm::fiber::PriorityLowest);
+
+MODM_LOG_ZONE(app, modm::log::INFO);
+
+// Parameter protocol on RTT channel 2, see modm_tools.parameter
+Rtt rtt_command(2);
+modm::telemetry::ParameterServer parameter_server({});
+
+modm::Fiber<> command_fiber([]
+{
+	while (true)
+	{
+		parameter_server.update(rtt_command);
+		// polling every 10ms is fast enough for interactive commands
+		modm::this_fiber::sleep_for(std::chrono::milliseconds(10));
+	}
+});
+
+// CPU time and stack usage of the fibers every 10s on the text log
+extern modm::telemetry::FiberReport fiber_report;
+
+modm::Fiber<> report_fiber([]
+{
+	while (true)
+	{
+		modm::this_fiber::sleep_for(std::chrono::seconds(10));
+		fiber_report.print(modm::log::info);
+	}
+});
+
+modm::telemetry::FiberEntry fibers[] = {
+	{"log", &log_fiber},
+	{"command", &command_fiber},
+	{"report", &report_fiber},
+};
+modm::telemetry::FiberReport fiber_report(fibers);
+
+// Timer1 wakes the core when the next fiber is due, so the scheduler sleeps
+// in WFI instead of polling the clock in between the 4Hz SysTick interrupts
+using FiberIdleTimer = FiberIdle<Timer1>;
+
+MODM_ISR(TIM1_UP_TIM10)
+{
+	FiberIdleTimer::handleInterrupt();
+}
+
+extern "C" void
+modm_fiber_idle(uint32_t duration)
+{
+	FiberIdleTimer::sleep(duration);
+}
 
 // ----------------------------------------------------------------------------
 using namespace modm::literals;
@@ -66,13 +143,14 @@ main()
 	Adc1::connect<GpioC0::In10>();
 	Adc1::initialize<Board::SystemClock, 21_MHz, 0.1f>();
 
-	MODM_LOG_INFO << "Current Control Test" << modm::endl;
+	MODM_LOG_INFO_ZONE(app) << "Current Control Test" << modm::endl;
 
+	FiberIdleTimer::initialize(Board::SystemClock::Timer1 / 1'000'000, 15);
 
-	while (true)
-	{
+	// the fibers have not run yet, so their stacks can be watermarked
+	for (auto &entry : fibers) entry.task->stack_watermark();
 
-	}
+	modm::fiber::Scheduler::run();
 
 	return 0;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@ __all__ = [
     "bmp",
     "build_id",
     "crashdebug",
+    "deferred_log",
     "elf2uf2",
     "find_files",
     "gdb",
@@ -11,8 +12,11 @@ __all__ = [
     "itm",
     "jlink",
     "openocd",
+    "parameter",
     "rtt",
+    "sample_stream",
     "size",
+    "stack_usage",
     "utils",
 ]
 
@@ -20,6 +24,7 @@ from . import backend
 from . import bmp
 from . import build_id
 from . import crashdebug
+from . import deferred_log
 from . import elf2uf2
 from . import find_files
 from . import gdb
@@ -27,8 +32,11 @@ from . import info
 from . import itm
 from . import jlink
 from . import openocd
+from . import parameter
 from . import rtt
+from . import sample_stream
 from . import size
+from . import stack_usage
 from . import utils
 import sys, warnings
 if not sys.warnoptions:
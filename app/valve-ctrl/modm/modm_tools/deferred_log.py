@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright (c) 2024, Alexander Evers
+#
+# This file is part of the modm project.
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+# -----------------------------------------------------------------------------
+
+r"""
+### Deferred Logging
+
+The `modm::log::DeferredLogger` only transmits the address of the format
+string and the binary encoded arguments. This decoder reads the format strings
+from the ELF file and formats the messages on the host.
+
+Connect to the RTT channel of the deferred logger via OpenOCD:
+
+```sh
+python3 -m modm_tools.deferred_log path/to/project.elf --channel 3 openocd -f modm/openocd.cfg
+```
+
+Or decode a recorded binary stream:
+
+```sh
+python3 -m modm_tools.deferred_log path/to/project.elf --file capture.bin
+[    12.345678] I main.cpp:74  valve 2 at -120 steps, current 0.41 A
+```
+
+(\* *only ARM Cortex-M targets*)
+"""
+
+import re
+import struct
+import socket
+import time
+from elftools.elf.elffile import ELFFile
+
+from . import openocd
+
+LEVELS = {"D": "DEBUG", "I": "INFO", "W": "WARNING", "E": "ERROR"}
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)((?:\.\d+)?)(?:hh|h|ll|l|j|z|t|L)?([diouxXcpfFeEgGaAs%])")
+
+
+# -----------------------------------------------------------------------------
+def cobs_decode(data):
+    """Decodes a COBS frame without the zero delimiter, returns None if invalid."""
+    output = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        if code == 0 or index + code > len(data):
+            return None
+        output += data[index + 1:index + code]
+        index += code
+        if code < 0xff and index < len(data):
+            output.append(0)
+    return bytes(output)
+
+
+def cobs_frames(chunks):
+    """Splits a stream of byte chunks at zero bytes and yields decoded frames."""
+    buffer = bytearray()
+    for chunk in chunks:
+        buffer += chunk
+        while (end := buffer.find(0)) >= 0:
+            frame = cobs_decode(bytes(buffer[:end]))
+            del buffer[:end + 1]
+            if frame:
+                yield frame
+
+
+def read_varint(data, index):
+    value = shift = 0
+    while True:
+        byte = data[index]
+        value |= (byte & 0x7f) << shift
+        index += 1
+        shift += 7
+        if not byte & 0x80:
+            return value, index
+
+
+def zigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+# -----------------------------------------------------------------------------
+class Decoder:
+    def __init__(self, elf):
+        self.sections = []
+        self.strings = {}
+        with open(elf, "rb") as file:
+            for section in ELFFile(file).iter_sections():
+                if section["sh_type"] == "SHT_NOBITS" or not section["sh_size"]:
+                    continue
+                # The interned strings are not loaded, but located at address 0
+                if section.name == ".modm_log_strings" or section["sh_flags"] & 0x2:
+                    self.sections.append((section["sh_addr"], section.data(), section.name))
+        self.sections.sort(key=lambda s: s[2] != ".modm_log_strings")
+        self.timestamp = None
+        self.epoch = 0
+
+    def string(self, address):
+        if address in self.strings:
+            return self.strings[address]
+        for start, data, _ in self.sections:
+            if start <= address < start + len(data):
+                end = data.find(b"\0", address - start)
+                text = data[address - start:end].decode("utf-8", errors="replace")
+                parts = text.split("\x1f", 2)
+                if len(parts) == 3 and parts[0] in LEVELS:
+                    self.strings[address] = parts
+                    return parts
+        return None
+
+    def _unwrap(self, timestamp):
+        if self.timestamp is not None and timestamp < self.timestamp:
+            self.epoch += 1 << 32
+        self.timestamp = timestamp
+        return (self.epoch + timestamp) / 1e6
+
+    def decode(self, frame):
+        """Decodes one frame, returns (time, level, location, message) or None."""
+        if sum(frame) & 0xff:
+            return None
+        try:
+            address, index = read_varint(frame, 0)
+            timestamp, index = read_varint(frame, index)
+            record = self.string(address)
+            if record is None:
+                return None
+            level, location, fmt = record
+            message = []
+            position = 0
+            for match in CONVERSION.finditer(fmt):
+                message.append(fmt[position:match.start()])
+                position = match.end()
+                flags, width, precision, kind = match.groups()
+                if kind == "%":
+                    message.append("%")
+                    continue
+                if kind == "s":
+                    length, index = read_varint(frame, index)
+                    value = frame[index:index + length].decode("utf-8", errors="replace")
+                    index += length
+                elif kind in "fFeEgGaA":
+                    value, = struct.unpack_from("<f", frame, index)
+                    index += 4
+                else:
+                    value, index = read_varint(frame, index)
+                    if kind in "di":
+                        value = zigzag(value)
+                if kind == "p":
+                    message.append("0x{:08x}".format(value))
+                elif kind in "aA":
+                    message.append(float(value).hex())
+                elif kind == "c":
+                    message.append("%{}{}c".format(flags, width) % chr(value))
+                else:
+                    kind = "d" if kind == "u" else kind
+                    message.append("%{}{}{}{}".format(flags, width, precision, kind) % value)
+            message.append(fmt[position:])
+            # the checksum must be the only remaining byte
+            if index != len(frame) - 1:
+                return None
+        except (IndexError, struct.error, ValueError, OverflowError):
+            return None
+        return self._unwrap(timestamp), LEVELS[level], location, "".join(message)
+
+    def format(self, frame):
+        result = self.decode(frame)
+        if result is None:
+            return None
+        return "[{:14.6f}] {:7} {}  {}".format(*result)
+
+
+# -----------------------------------------------------------------------------
+def decode_stream(decoder, chunks):
+    for frame in cobs_frames(chunks):
+        line = decoder.format(frame)
+        print(line if line is not None else "<corrupted frame>", flush=True)
+
+
+def socket_chunks(port, host="localhost"):
+    with socket.create_connection((host, port)) as connection:
+        while (chunk := connection.recv(4096)):
+            yield chunk
+
+
+def file_chunks(path):
+    with open(path, "rb") as file:
+        while (chunk := file.read(4096)):
+            yield chunk
+
+
+def rtt(decoder, backend, channel):
+    backend.commands.append("modm_rtt")
+    # Start OpenOCD in the background
+    with backend.scope():
+        time.sleep(0.5)
+        try:
+            decode_stream(decoder, socket_chunks(9090 + channel))
+        except KeyboardInterrupt:
+            pass
+
+
+# -----------------------------------------------------------------------------
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Decode deferred binary logging.")
+    parser.add_argument(
+            dest="elf",
+            metavar="ELF",
+            help="The image containing the interned format strings.")
+    parser.add_argument(
+            "--channel",
+            dest="channel",
+            type=int,
+            default=3,
+            help="The RTT channel of the deferred logger.")
+    parser.add_argument(
+            "--file",
+            dest="file",
+            default=None,
+            help="Decode a recorded binary stream instead.")
+
+    subparsers = parser.add_subparsers(title="Backend", dest="backend")
+    openocd.add_subparser(subparsers)
+
+    args = parser.parse_args()
+    decoder = Decoder(args.elf)
+
+    if args.file is not None:
+        decode_stream(decoder, file_chunks(args.file))
+    elif args.backend is not None:
+        rtt(decoder, args.backend(args), args.channel)
+    else:
+        parser.error("Either a backend or --file is required!")
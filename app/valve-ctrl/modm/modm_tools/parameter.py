@@ -0,0 +1,455 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright (c) 2024, Alexander Evers
+#
+# This file is part of the modm project.
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+# -----------------------------------------------------------------------------
+
+r"""
+### Parameters
+
+Client of the `modm::telemetry::ParameterServer` protocol to read and write
+parameters at runtime. Connect to the command RTT channel via OpenOCD, to a
+running OpenOCD RTT server or to a serial port (requires `pyserial`):
+
+```sh
+python3 -m modm_tools.parameter --openocd modm/openocd.cfg list
+python3 -m modm_tools.parameter --port 9092 get current.kp current.ki
+python3 -m modm_tools.parameter --serial /dev/ttyUSB0 set current.kp=0.8 current.ki=0.05
+python3 -m modm_tools.parameter --port 9092 zone valve debug
+python3 -m modm_tools.parameter --serial /dev/ttyACM0 --json snapshot
+```
+
+The `snapshot` command reads the complete controller state of a
+`modm::telemetry::Snapshot` in one transfer and decodes it with the schema,
+which is fetched once and again whenever the schema id of a record changes.
+
+All values of a `set` command are written at once. The `--loopback` option
+connects to a device emulation on the host instead, which implements the same
+protocol and allows to test host scripts without hardware:
+
+```sh
+python3 -m modm_tools.parameter --loopback list
+```
+
+(\* *only ARM Cortex-M targets*)
+"""
+
+import json
+import socket
+import struct
+import time
+
+from . import openocd
+from .deferred_log import cobs_decode
+
+
+# -----------------------------------------------------------------------------
+LIST, GET, SET, SNAPSHOT, SCHEMA, LOG_ZONE = 0x01, 0x02, 0x03, 0x04, 0x05, 0x10
+SNAPSHOT_VERSION = 1
+STATUS = ["ok", "unknown command", "unknown parameter", "type mismatch",
+          "read-only", "malformed", "overflow"]
+TYPES = ["bool", "uint8", "int8", "uint16", "int16", "uint32", "int32", "float"]
+FORMATS = ["<?", "<B", "<b", "<H", "<h", "<I", "<i", "<f"]
+LEVELS = ["debug", "info", "warning", "error", "off"]
+
+
+def crc16(data, crc=0xffff):
+    """CRC-16/CCITT as `modm::math::crc16_ccitt`."""
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ (0x8408 if crc & 1 else 0)
+    return crc
+
+
+def cobs_encode(data):
+    output = bytearray([0])
+    code = 0
+    for byte in data:
+        if byte:
+            output.append(byte)
+        if not byte or len(output) - code == 0xff:
+            output[code] = len(output) - code
+            code = len(output)
+            output.append(0)
+    output[code] = len(output) - code
+    return bytes(output) + b"\0"
+
+
+def schema_id(fields):
+    """CRC-16 of the (name, type, count) fields as `modm::telemetry::Snapshot`."""
+    return crc16(b"".join(struct.pack("<BH", type, count) + name.encode()
+                          for name, type, count in fields))
+
+
+def frame(command, sequence, payload):
+    data = bytes([command, sequence]) + payload
+    return cobs_encode(data + struct.pack("<H", crc16(data)))
+
+
+class ProtocolError(Exception):
+    pass
+
+
+class Parameter:
+    def __init__(self, id, name, type, writable):
+        self.id, self.name, self.type, self.writable = id, name, type, writable
+
+    def encode(self, value):
+        if TYPES[self.type] == "float":
+            value = float(value)
+        elif TYPES[self.type] == "bool":
+            value = value if isinstance(value, bool) else value.lower() in ("1", "true", "on")
+        else:
+            value = int(value, 0) if isinstance(value, str) else int(value)
+        return struct.pack(FORMATS[self.type], value)
+
+    def __repr__(self):
+        return "{:5} {:24} {:7} {}".format(self.id, self.name, TYPES[self.type],
+                                            "rw" if self.writable else "ro")
+
+
+# -----------------------------------------------------------------------------
+class SocketTransport:
+    def __init__(self, port, host="localhost"):
+        self.connection = socket.create_connection((host, port))
+
+    def write(self, data):
+        self.connection.sendall(data)
+
+    def read(self, timeout):
+        self.connection.settimeout(timeout)
+        try:
+            return self.connection.recv(4096)
+        except socket.timeout:
+            return b""
+
+
+class SerialTransport:
+    def __init__(self, port, baudrate):
+        import serial
+        self.serial = serial.Serial(port, baudrate)
+
+    def write(self, data):
+        self.serial.write(data)
+
+    def read(self, timeout):
+        self.serial.timeout = timeout
+        return self.serial.read(max(1, self.serial.in_waiting))
+
+
+class Client:
+    def __init__(self, transport, timeout=0.5, retries=3):
+        self.transport = transport
+        self.timeout = timeout
+        self.retries = retries
+        self.sequence = 0
+        self.buffer = bytearray()
+        self._parameters = None
+        self._schema = None
+
+    def request(self, command, payload=b""):
+        """Sends a request and returns the response payload, raises ProtocolError."""
+        for _ in range(self.retries):
+            self.sequence = (self.sequence + 1) & 0xff
+            self.transport.write(frame(command, self.sequence, payload))
+            deadline = time.monotonic() + self.timeout
+            while (remaining := deadline - time.monotonic()) > 0:
+                self.buffer += self.transport.read(remaining)
+                while (end := self.buffer.find(0)) >= 0:
+                    data = cobs_decode(bytes(self.buffer[:end]))
+                    del self.buffer[:end + 1]
+                    if (not data or len(data) < 5 or crc16(data[:-2]) != struct.unpack("<H", data[-2:])[0]
+                            or data[0] != command | 0x80 or data[1] != self.sequence):
+                        continue
+                    status, payload = data[2], data[3:-2]
+                    if status:
+                        detail = " (id {})".format(struct.unpack_from("<H", payload)[0]) if len(payload) >= 2 else ""
+                        raise ProtocolError((STATUS[status] if status < len(STATUS) else str(status)) + detail)
+                    return payload
+        raise ProtocolError("no response")
+
+    def list(self):
+        if self._parameters is None:
+            parameters, index = [], 0
+            while index != 0xffff:
+                payload = self.request(LIST, struct.pack("<H", index))
+                index, = struct.unpack_from("<H", payload)
+                position = 2
+                while position < len(payload):
+                    id, type, length = struct.unpack_from("<HBB", payload, position)
+                    name = payload[position + 4:position + 4 + length].decode()
+                    parameters.append(Parameter(id, name, type & 0x7f, bool(type & 0x80)))
+                    position += 4 + length
+            self._parameters = {p.name: p for p in parameters}
+        return list(self._parameters.values())
+
+    def parameter(self, key):
+        self.list()
+        if isinstance(key, int):
+            return next(p for p in self._parameters.values() if p.id == key)
+        if key not in self._parameters:
+            raise ProtocolError("unknown parameter '{}'".format(key))
+        return self._parameters[key]
+
+    def get(self, *keys):
+        """Reads the parameters by name or id in one request, returns a dict."""
+        parameters = [self.parameter(key) for key in keys]
+        payload = self.request(GET, b"".join(struct.pack("<H", p.id) for p in parameters))
+        values, position = {}, 0
+        for parameter in parameters:
+            id, type = struct.unpack_from("<HB", payload, position)
+            value, = struct.unpack_from(FORMATS[type], payload, position + 3)
+            values[parameter.name] = value
+            position += 3 + struct.calcsize(FORMATS[type])
+        return values
+
+    def set(self, values):
+        """Writes a dict of parameter names or ids to values in one request."""
+        payload = b""
+        for key, value in values.items():
+            parameter = self.parameter(key)
+            payload += struct.pack("<HB", parameter.id, parameter.type) + parameter.encode(value)
+        self.request(SET, payload)
+
+    def schema(self):
+        """Reads the snapshot schema, returns (schema id, [(name, type, count)])."""
+        fields, index, id = [], 0, None
+        while index != 0xffff:
+            payload = self.request(SCHEMA, struct.pack("<H", index))
+            version, page_id, index = struct.unpack_from("<BHH", payload)
+            if version != SNAPSHOT_VERSION:
+                raise ProtocolError("unsupported snapshot version {}".format(version))
+            if id is not None and page_id != id:
+                # the firmware changed while reading, start over
+                fields, index, id = [], 0, None
+                continue
+            id, position = page_id, 5
+            while position < len(payload):
+                type, count, length = struct.unpack_from("<BHB", payload, position)
+                fields.append((payload[position + 4:position + 4 + length].decode(), type, count))
+                position += 4 + length
+        self._schema = (id, fields)
+        return self._schema
+
+    def snapshot(self):
+        """Reads the complete state, returns (time in ms, {name: value or list})."""
+        payload = self.request(SNAPSHOT)
+        version, id, timestamp = struct.unpack_from("<BHI", payload)
+        if version != SNAPSHOT_VERSION:
+            raise ProtocolError("unsupported snapshot version {}".format(version))
+        if self._schema is None or self._schema[0] != id:
+            self.schema()
+            if self._schema[0] != id:
+                raise ProtocolError("schema changed during snapshot")
+        values, position = {}, 7
+        for name, type, count in self._schema[1]:
+            format = "<{}{}".format(count, FORMATS[type][1])
+            if position + struct.calcsize(format) > len(payload):
+                raise ProtocolError("snapshot shorter than schema")
+            value = list(struct.unpack_from(format, payload, position))
+            values[name] = value[0] if count == 1 else value
+            position += struct.calcsize(format)
+        return timestamp, values
+
+    def log_zone(self, zone, level):
+        self.request(LOG_ZONE, bytes([LEVELS.index(level)]) + zone.encode())
+
+
+# -----------------------------------------------------------------------------
+class Emulator:
+    """Device side of the protocol on the host with an example table."""
+    def __init__(self):
+        self.table = [
+            [1, "current.kp", 7, True, 0.5],
+            [2, "current.ki", 7, True, 0.01],
+            [3, "current.limit", 4, True, 800],
+            [4, "valve.enabled", 0, True, True],
+            [5, "firmware", 3, False, 1],
+        ]
+        self.zones = {"app": 1}
+        self.state = [
+            ["zone.setpoint", 7, [21.0, 21.0, 19.5, 22.0]],
+            ["zone.temperature", 7, [20.5, 21.25, 19.0, 21.5]],
+            ["zone.valve", 1, [40, 55, 0, 80]],
+            ["zone.integrator", 7, [1.5, 0.25, -0.5, 3.0]],
+            ["zone.faults", 3, [0, 0, 2, 0]],
+            ["uptime", 5, [12345]],
+        ]
+        self.start = time.monotonic()
+        self.buffer = bytearray()
+        self.output = bytearray()
+
+    def write(self, data):
+        self.buffer += data
+        while (end := self.buffer.find(0)) >= 0:
+            request = cobs_decode(bytes(self.buffer[:end]))
+            del self.buffer[:end + 1]
+            if (request and len(request) >= 4 and
+                    crc16(request[:-2]) == struct.unpack("<H", request[-2:])[0]):
+                status, payload = self.handle(request[0], request[2:-2])
+                self.output += frame(request[0] | 0x80, request[1], bytes([status]) + payload)
+
+    def read(self, timeout):
+        data, self.output = bytes(self.output), bytearray()
+        return data
+
+    def find(self, id):
+        return next((entry for entry in self.table if entry[0] == id), None)
+
+    def handle(self, command, payload):
+        if command == LIST:
+            output = struct.pack("<H", 0xffff)
+            for id, name, type, writable, _ in self.table:
+                output += struct.pack("<HBB", id, type | (0x80 if writable else 0), len(name)) + name.encode()
+            return 0, output
+        if command == GET:
+            output = b""
+            for position in range(0, len(payload), 2):
+                id, = struct.unpack_from("<H", payload, position)
+                if (entry := self.find(id)) is None:
+                    return 2, struct.pack("<H", id)
+                output += struct.pack("<HB", id, entry[2]) + struct.pack(FORMATS[entry[2]], entry[4])
+            return 0, output
+        if command == SET:
+            values, position = [], 0
+            while position < len(payload):
+                id, type = struct.unpack_from("<HB", payload, position)
+                entry = self.find(id)
+                if entry is None:
+                    return 2, struct.pack("<H", id)
+                if entry[2] != type:
+                    return 3, struct.pack("<H", id)
+                if not entry[3]:
+                    return 4, struct.pack("<H", id)
+                value, = struct.unpack_from(FORMATS[type], payload, position + 3)
+                values.append((entry, value))
+                position += 3 + struct.calcsize(FORMATS[type])
+            for entry, value in values:
+                entry[4] = value
+            return 0, b""
+        if command == SNAPSHOT:
+            fields = [(name, type, len(values)) for name, type, values in self.state]
+            output = struct.pack("<BHI", SNAPSHOT_VERSION, schema_id(fields),
+                                 int((time.monotonic() - self.start) * 1000) & 0xffffffff)
+            for _, type, values in self.state:
+                output += struct.pack("<{}{}".format(len(values), FORMATS[type][1]), *values)
+            return 0, output
+        if command == SCHEMA:
+            index, = struct.unpack_from("<H", payload)
+            fields = [(name, type, len(values)) for name, type, values in self.state]
+            output = struct.pack("<BHH", SNAPSHOT_VERSION, schema_id(fields), 0xffff)
+            for name, type, count in fields[index:]:
+                output += struct.pack("<BHB", type, count, len(name)) + name.encode()
+            return 0, output
+        if command == LOG_ZONE:
+            name = payload[1:].decode()
+            if name != "*" and name not in self.zones:
+                return 2, b""
+            for zone in self.zones if name == "*" else [name]:
+                self.zones[zone] = payload[0]
+            return 0, b""
+        return 1, b""
+
+
+# -----------------------------------------------------------------------------
+def run(client, command, arguments, as_json=False):
+    if command == "list":
+        for parameter in client.list():
+            print(parameter)
+    elif command == "get":
+        for name, value in client.get(*arguments).items():
+            print("{} = {}".format(name, value))
+    elif command == "set":
+        client.set(dict(argument.split("=", 1) for argument in arguments))
+    elif command == "zone":
+        client.log_zone(*arguments)
+    elif command == "snapshot":
+        timestamp, values = client.snapshot()
+        if as_json:
+            print(json.dumps({"time": timestamp, "values": values}))
+        else:
+            print("time = {} ms".format(timestamp))
+            for name, value in values.items():
+                print("{} = {}".format(name, value))
+
+
+def main(args):
+    if args.loopback:
+        run(Client(Emulator()), args.command, args.arguments, args.json)
+    elif args.serial is not None:
+        run(Client(SerialTransport(args.serial, args.baudrate)), args.command, args.arguments, args.json)
+    elif args.port is not None:
+        run(Client(SocketTransport(args.port)), args.command, args.arguments, args.json)
+    elif args.openocd is not None:
+        backend = openocd.OpenOcdBackend(commands="modm_rtt", config=args.openocd)
+        # Start OpenOCD in the background
+        with backend.scope():
+            time.sleep(0.5)
+            run(Client(SocketTransport(9090 + args.channel)), args.command, args.arguments, args.json)
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Read and write device parameters.")
+    parser.add_argument(
+            "--openocd",
+            dest="openocd",
+            action="append",
+            help="Start OpenOCD with these config files and use its RTT server.")
+    parser.add_argument(
+            "--channel",
+            dest="channel",
+            type=int,
+            default=2,
+            help="The RTT channel of the command protocol.")
+    parser.add_argument(
+            "--port",
+            dest="port",
+            type=int,
+            default=None,
+            help="Connect to a running RTT server on this TCP port.")
+    parser.add_argument(
+            "--serial",
+            dest="serial",
+            default=None,
+            help="Connect to this serial port instead.")
+    parser.add_argument(
+            "--baudrate",
+            dest="baudrate",
+            type=int,
+            default=115200,
+            help="Baudrate of the serial port.")
+    parser.add_argument(
+            "--loopback",
+            dest="loopback",
+            action="store_true",
+            help="Connect to a device emulation on the host.")
+    parser.add_argument(
+            "--json",
+            dest="json",
+            action="store_true",
+            help="Print the snapshot as JSON.")
+    parser.add_argument(
+            dest="command",
+            choices=["list", "get", "set", "zone", "snapshot"])
+    parser.add_argument(
+            dest="arguments",
+            nargs="*",
+            help="Parameter names for get, NAME=VALUE for set, ZONE LEVEL for zone.")
+
+    args = parser.parse_args()
+    if not (args.loopback or args.serial or args.port or args.openocd):
+        parser.error("Either --openocd, --port, --serial or --loopback is required!")
+
+    try:
+        main(args)
+    except ProtocolError as error:
+        parser.exit(1, "Error: {}\n".format(error))
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright (c) 2024, Alexander Evers
+#
+# This file is part of the modm project.
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+# -----------------------------------------------------------------------------
+
+r"""
+### Sample Stream
+
+Decodes the compressed ADC samples of a `modm::telemetry::SampleStream` to
+CSV or to a NumPy `.npy` file with one column per channel.
+
+Record the telemetry RTT channel via OpenOCD until interrupted:
+
+```sh
+python3 -m modm_tools.sample_stream --channel 1 -o current.csv openocd -f modm/openocd.cfg
+```
+
+Or decode a recorded binary stream:
+
+```sh
+python3 -m modm_tools.sample_stream --file capture.bin -o current.npy
+```
+
+Dropped frames are reported on stderr, the samples of the following frames
+are appended without a gap.
+
+(\* *only ARM Cortex-M targets*)
+"""
+
+import sys
+import time
+
+from . import openocd
+from .deferred_log import cobs_frames, read_varint, zigzag, socket_chunks, file_chunks
+
+
+# -----------------------------------------------------------------------------
+def decode_frame(frame):
+    """Decodes one frame, returns (sequence, rows) or None if it is invalid."""
+    if len(frame) < 5 or sum(frame) & 0xff:
+        return None
+    try:
+        sequence, channels, mode = frame[0], frame[1], frame[2]
+        if not channels:
+            return None
+        count, index = read_varint(frame, 3)
+        if count % channels:
+            return None
+        samples = []
+        for _ in range(min(channels, count)):
+            value, index = read_varint(frame, index)
+            samples.append(value)
+        deltas = count - len(samples)
+        if mode & 0x80:
+            width = mode & 0x7f
+            bits = deltas * width
+            payload = frame[index:index + (bits + 7) // 8]
+            index += (bits + 7) // 8
+            accumulator = int.from_bytes(payload, "little")
+            mask = (1 << width) - 1
+            for ii in range(deltas):
+                delta = zigzag((accumulator >> (ii * width)) & mask)
+                samples.append(samples[-channels] + delta)
+        else:
+            for _ in range(deltas):
+                value, index = read_varint(frame, index)
+                samples.append(samples[-channels] + zigzag(value))
+        # the checksum must be the only remaining byte
+        if index != len(frame) - 1:
+            return None
+    except IndexError:
+        return None
+    rows = [samples[ii:ii + channels] for ii in range(0, count, channels)]
+    return sequence, rows
+
+
+def decode_stream(chunks):
+    """Yields the sample rows of all valid frames and reports gaps on stderr."""
+    expected = None
+    for frame in cobs_frames(chunks):
+        result = decode_frame(frame)
+        if result is None:
+            print("Corrupted frame dropped", file=sys.stderr)
+            continue
+        sequence, rows = result
+        if expected is not None and sequence != expected:
+            print("{} frame(s) lost".format((sequence - expected) & 0xff), file=sys.stderr)
+        expected = (sequence + 1) & 0xff
+        yield from rows
+
+
+# -----------------------------------------------------------------------------
+def write_csv(rows, output):
+    file = sys.stdout if output is None else open(output, "w")
+    try:
+        for row in rows:
+            file.write(",".join(map(str, row)) + "\n")
+    finally:
+        if output is not None:
+            file.close()
+
+
+def write_numpy(rows, output):
+    import numpy
+    numpy.save(output, numpy.array(list(rows), dtype=numpy.uint16))
+
+
+def write(rows, output):
+    if output is not None and output.endswith(".npy"):
+        write_numpy(rows, output)
+    else:
+        write_csv(rows, output)
+
+
+def rtt(backend, channel, output):
+    backend.commands.append("modm_rtt")
+    # Start OpenOCD in the background
+    with backend.scope():
+        time.sleep(0.5)
+        rows = []
+        try:
+            for row in decode_stream(socket_chunks(9090 + channel)):
+                rows.append(row)
+        except KeyboardInterrupt:
+            pass
+        write(rows, output)
+
+
+# -----------------------------------------------------------------------------
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Decode a compressed ADC sample stream.")
+    parser.add_argument(
+            "--channel",
+            dest="channel",
+            type=int,
+            default=1,
+            help="The RTT channel of the sample stream.")
+    parser.add_argument(
+            "--file",
+            dest="file",
+            default=None,
+            help="Decode a recorded binary stream instead.")
+    parser.add_argument(
+            "-o", "--output",
+            dest="output",
+            default=None,
+            help="Output file, NumPy for *.npy, otherwise CSV. Default: CSV on stdout.")
+
+    subparsers = parser.add_subparsers(title="Backend", dest="backend")
+    openocd.add_subparser(subparsers)
+
+    args = parser.parse_args()
+
+    if args.file is not None:
+        write(decode_stream(file_chunks(args.file)), args.output)
+    elif args.backend is not None:
+        rtt(args.backend(args), args.channel, args.output)
+    else:
+        parser.error("Either a backend or --file is required!")
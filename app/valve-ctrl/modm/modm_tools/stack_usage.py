@@ -0,0 +1,326 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright (c) 2024, Alexander Evers
+#
+# This file is part of the modm project.
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+# -----------------------------------------------------------------------------
+
+r"""
+### Stack Usage
+
+Computes the worst-case stack usage of fiber entry functions from the files
+that GCC writes next to every object file when compiling with
+`-fstack-usage -fcallgraph-info=su`: The `.su` files contain the frame size of
+every function and the `.ci` files the call graph. The deepest path through
+the call graph is added to the register frame that an interrupt pushes onto
+the fiber stack and the two words the fiber keeps at the top of its stack.
+
+Without entries, the functions that are not called directly by any other
+function are listed, which includes the fiber functions, interrupts and
+`main`:
+
+```sh
+python3 -m modm_tools.stack_usage path/to/build
+
+Function                                            Calls  Total
+task_impl.hpp:53:17  _ZZN4modm5fiber4TaskC4ILj1024EN9log_fib    236    348 +
+main.cpp:112:1  int main()                                 48    160 +
+...
+```
+
+Select the fibers by a regular expression, which is matched against the
+function name and its symbol, or by a `file:line` range of the fiber function.
+The range also finds the fiber function if it was inlined into the entry of
+`modm::fiber::Task`, as long as it calls a function. The symbol of this entry
+contains the name of the fiber variable, if the fiber is a global:
+
+```sh
+python3 -m modm_tools.stack_usage path/to/build --entry log_fiber --entry "main.cpp:81-88"
+
+Fiber             Calls  Total  Stack
+log_fiber           236    348    352
+  Task<...>::_FUN(void*) 24 > modm::log::Ring<2048>::drain(...) 32 > ... > memcpy ?
+  incomplete: memcpy unknown
+```
+
+`Calls` is the deepest call path, `Total` adds the interrupt frame and the
+fiber storage and `Stack` rounds it up to the stack alignment. The result is
+a lower bound if the call graph contains recursion, indirect calls,
+functions compiled without `-fstack-usage`, like the C library, or
+unbounded dynamic allocations. These are listed as `incomplete`; you can pass
+known frame sizes with `--frame name=bytes`.
+
+(\* *only ARM Cortex-M targets*)
+"""
+
+import re
+from pathlib import Path
+
+NODE = re.compile(r'node: \{ title: "(?P<title>(?:[^"\\]|\\.)*)" label: "(?P<label>(?:[^"\\]|\\.)*)"')
+EDGE = re.compile(r'edge: \{ sourcename: "(?P<source>(?:[^"\\]|\\.)*)" targetname: "(?P<target>(?:[^"\\]|\\.)*)" label: "(?P<site>[^"]*)"')
+USAGE = re.compile(r"^(?P<location>.*?:\d+:\d+):(?P<name>.*)\t(?P<bytes>\d+)\t(?P<qualifier>[\w,]+)$")
+FRAME = re.compile(r"^(?P<bytes>\d+) bytes \((?P<qualifier>[\w,]+)\)$")
+RANGE = re.compile(r"^(?P<file>.+):(?P<first>\d+)(?:-(?P<last>\d+))?$")
+
+INDIRECT = "__indirect_call"
+# Cortex-M4F: the extended exception frame is pushed onto the process stack
+EXCEPTION_FRAME = 104
+# fiber function and its argument at the top of every fiber stack
+FIBER_STORAGE = 8
+STACK_ALIGNMENT = 8
+# hand-written assembly without stack usage information
+FRAMES = {
+    # r4-r11, lr and d8-d15 of the fiber that is suspended
+    "modm_context_jump": 100,
+}
+
+
+# -----------------------------------------------------------------------------
+class Function:
+    def __init__(self, title, name, location=None, frame=None, qualifier="static"):
+        self.title = title
+        self.name = name
+        self.location = location
+        self.frame = frame
+        self.qualifier = qualifier
+        self.calls = []
+        self.sites = []
+        self.callers = 0
+
+    @property
+    def defined(self):
+        return self.frame is not None
+
+    def __str__(self):
+        return self.name
+
+
+class Result:
+    def __init__(self, calls=0, path=None, incomplete=None):
+        self.calls = calls
+        self.path = path or []
+        self.incomplete = incomplete or {}
+
+
+def _unescape(text):
+    return text.replace('\\"', '"').replace("\\\\", "\\")
+
+
+def _location(location):
+    """Splits `file:line:col` and only keeps the file name."""
+    file, line, _ = location.rsplit(":", 2)
+    return Path(file).name, int(line)
+
+
+# -----------------------------------------------------------------------------
+class CallGraph:
+    def __init__(self, paths, frames=None):
+        self.functions = {}
+        self.frames = dict(FRAMES, **(frames or {}))
+        self.memo = {}
+        for path in paths:
+            path = Path(path)
+            files = [path] if path.is_file() else sorted(path.rglob("*.ci"))
+            for ci in files:
+                self._parse(ci)
+        for function in self.functions.values():
+            for callee in function.calls:
+                self.resolve(callee).callers += 1
+
+    def _parse(self, ci):
+        # the frame sizes of -fstack-usage in the same order as the definitions
+        usage = []
+        su = ci.with_suffix(".su")
+        if su.exists():
+            for line in su.read_text(errors="replace").splitlines():
+                if (match := USAGE.match(line)):
+                    usage.append((match["location"], int(match["bytes"]), match["qualifier"]))
+        usage.reverse()
+
+        local = {}
+        edges = []
+        for line in ci.read_text(errors="replace").splitlines():
+            if (match := NODE.match(line)):
+                title = _unescape(match["title"])
+                label = _unescape(match["label"]).split("\\n")
+                frame = FRAME.match(label[2]) if len(label) > 2 else None
+                if frame is None:
+                    # declaration of a function of another translation unit
+                    local.setdefault(title, None)
+                    continue
+                bytes, qualifier = int(frame["bytes"]), frame["qualifier"]
+                # template instances share their location, so match them in order
+                if usage and usage[-1][0] == label[1]:
+                    _, bytes, qualifier = usage.pop()
+                function = Function(title, label[0], label[1], bytes, qualifier)
+                local[title] = function
+                # static functions with the same name may exist in other units
+                if title not in self.functions or not self.functions[title].defined:
+                    self.functions[title] = function
+            elif (match := EDGE.match(line)):
+                edges.append((_unescape(match["source"]), _unescape(match["target"]), match["site"]))
+
+        for source, target, site in edges:
+            caller = local.get(source)
+            if caller is None:
+                continue
+            caller.sites.append(site)
+            callee = local.get(target) or self.functions.get(target)
+            if callee is None:
+                callee = self.functions[target] = Function(target, target)
+            if callee not in caller.calls:
+                caller.calls.append(callee)
+
+    def resolve(self, function):
+        """Returns the definition of a function declared in another unit."""
+        if not function.defined:
+            function = self.functions.get(function.title, function)
+        return function
+
+    def frame(self, function):
+        for key in (function.title, function.name):
+            if key in self.frames:
+                return self.frames[key]
+        return function.frame
+
+    def worst(self, function, active=None):
+        """Returns the deepest call path starting at the function."""
+        active = set() if active is None else active
+        function = self.resolve(function)
+        if id(function) in self.memo:
+            return self.memo[id(function)]
+        frame = self.frame(function)
+        if function.title == INDIRECT:
+            return Result(0, [function], {"indirect calls": None})
+        if frame is None:
+            return Result(0, [function], {function.name: "unknown"})
+        if id(function) in active:
+            return Result(0, [function], {function.name: "recursion"})
+
+        active.add(id(function))
+        incomplete = {}
+        if "dynamic" in function.qualifier and "bounded" not in function.qualifier:
+            incomplete[function.name] = "dynamic"
+        deepest = Result()
+        for callee in function.calls:
+            result = self.worst(callee, active)
+            incomplete.update(result.incomplete)
+            if result.calls > deepest.calls or not deepest.path:
+                deepest = result
+        active.discard(id(function))
+
+        result = Result(frame + deepest.calls, [function] + deepest.path, incomplete)
+        # results inside a recursion depend on the path, do not reuse them
+        if "recursion" not in incomplete.values():
+            self.memo[id(function)] = result
+        return result
+
+    def roots(self):
+        return [f for f in self.functions.values() if f.defined and not f.callers]
+
+    def entries(self, pattern):
+        """Finds the functions of a `file:line[-line]` range or a name pattern."""
+        if (match := RANGE.match(pattern)) and "." in match["file"]:
+            file = Path(match["file"]).name
+            first = int(match["first"])
+            last = int(match["last"] or first)
+            def inside(location):
+                name, line = _location(location)
+                return name == file and first <= line <= last
+            found = [f for f in self.functions.values() if f.defined and inside(f.location)]
+            if found:
+                return found
+            # the fiber function was inlined into the entry of the fiber
+            return [f for f in self.roots() if f.sites and any(inside(s) for s in f.sites)]
+        expression = re.compile(pattern)
+        return [f for f in self.functions.values() if f.defined and
+                (expression.search(f.name) or expression.search(f.title))]
+
+
+# -----------------------------------------------------------------------------
+def _path(graph, result):
+    steps = []
+    for function in result.path:
+        frame = graph.frame(graph.resolve(function))
+        steps.append("{} {}".format(function.name, "?" if frame is None else frame))
+    return " > ".join(steps)
+
+
+def _incomplete(result):
+    return ", ".join(name if kind is None else "{} {}".format(name, kind)
+                     for name, kind in sorted(result.incomplete.items()))
+
+
+def total(calls, exception_frame=EXCEPTION_FRAME):
+    total = calls + exception_frame + FIBER_STORAGE
+    return total, (total + STACK_ALIGNMENT - 1) & ~(STACK_ALIGNMENT - 1)
+
+
+def format(graph, entries, exception_frame=EXCEPTION_FRAME, count=30):
+    lines = []
+    if not entries:
+        results = [(graph.worst(f), f) for f in graph.roots()]
+        results.sort(key=lambda r: -r[0].calls)
+        names = [(f.location, f.name) for f in graph.roots()]
+        lines.append("{:50} {:>6} {:>6}".format("Function", "Calls", "Total"))
+        for result, function in results[:count]:
+            # template instances like the fiber entries only differ in their symbol
+            unique = names.count((function.location, function.name)) == 1
+            name = "{}  {}".format(function.location, function.name if unique else function.title)
+            lines.append("{:50.50} {:6} {:6}{}".format(name, result.calls,
+                         total(result.calls, exception_frame)[0], " +" if result.incomplete else ""))
+        return "\n".join(lines)
+
+    lines.append("{:16} {:>6} {:>6} {:>6}".format("Fiber", "Calls", "Total", "Stack"))
+    for entry in entries:
+        functions = graph.entries(entry)
+        if not functions:
+            lines.append("{:16} not found".format(entry))
+            continue
+        result = max((graph.worst(f) for f in functions), key=lambda r: r.calls)
+        size, stack = total(result.calls, exception_frame)
+        lines.append("{:16} {:6} {:6} {:6}".format(entry, result.calls, size, stack))
+        lines.append("  " + _path(graph, result))
+        if result.incomplete:
+            lines.append("  incomplete: " + _incomplete(result))
+    return "\n".join(lines)
+
+
+# -----------------------------------------------------------------------------
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Compute the worst-case stack usage of fibers.")
+    parser.add_argument(
+            dest="paths",
+            metavar="PATH",
+            nargs="+",
+            help="Build directories or .ci files compiled with -fstack-usage -fcallgraph-info=su.")
+    parser.add_argument(
+            "--entry",
+            dest="entries",
+            action="append",
+            default=[],
+            help="Fiber function as name pattern or file:line[-line] range.")
+    parser.add_argument(
+            "--frame",
+            dest="frames",
+            action="append",
+            default=[],
+            help="Frame size of a function without stack usage information as name=bytes.")
+    parser.add_argument(
+            "--exception-frame",
+            dest="exception_frame",
+            type=int,
+            default=EXCEPTION_FRAME,
+            help="Bytes pushed by an interrupt, 32 without FPU.")
+
+    args = parser.parse_args()
+    frames = {name: int(size) for name, size in (f.rsplit("=", 1) for f in args.frames)}
+    graph = CallGraph(args.paths, frames)
+    print(format(graph, args.entries, args.exception_frame))
@@ -31,6 +31,7 @@ def build_target(env, sources):
 	# The executable depends on the linkerscript
 	env.Depends(target=program, dependency="$BASEPATH/modm/link/linkerscript.ld")
 	env.Alias("size", env.Size(chosen_program))
+	env.Alias("stack-usage", env.StackUsage(chosen_program))
 	env.Alias("uf2", env.UF2(chosen_program))
 
 	env.Alias("log-itm", env.LogItmOpenOcd())
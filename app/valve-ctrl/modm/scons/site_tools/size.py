@@ -24,6 +24,12 @@
 #         {"name": "ccm", "start": 0x10000000, "size": 65536, "access": "rw"},
 #         {"name": "sram1", "start": 0x20000000, "size": 163840, "access": "rwx"}
 #     ]
+#
+# The stack usage report computes the worst-case stack usage of the fibers in
+# MODM_FIBER_ENTRIES from the .su and .ci files of the build, see
+# modm_tools.stack_usage for the format of the entries:
+#
+#     env["MODM_FIBER_ENTRIES"] = ["log_fiber", "main.cpp:81-88"]
 
 from SCons.Script import *
 
@@ -44,8 +50,19 @@ def show_size(env, source):
 
     return env.AlwaysBuild(env.Alias("__size", source, action))
 
+def show_stack_usage(env, source):
+    # the .su and .ci files of -fstack-usage -fcallgraph-info=su
+    def stack_usage_action(target, source, env):
+        from modm_tools import stack_usage
+        graph = stack_usage.CallGraph([env.subst("$BUILDPATH")])
+        print(stack_usage.format(graph, env.get("MODM_FIBER_ENTRIES", [])))
+        return 0
+    action = Action(stack_usage_action, cmdstr="$SIZECOMSTR")
+    return env.AlwaysBuild(env.Alias("__stack_usage", source, action))
+
 def generate(env, **kw):
     env.AddMethod(show_size, "Size")
+    env.AddMethod(show_stack_usage, "StackUsage")
 
 def exists(env):
     return True
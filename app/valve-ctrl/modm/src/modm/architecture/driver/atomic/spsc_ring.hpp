@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_SPSC_RING_HPP
+#define MODM_SPSC_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <stdint.h>
+#include <type_traits>
+
+#include <modm/architecture/detect.hpp>
+
+namespace modm
+{
+
+/// @cond
+namespace spsc_ring_detail
+{
+#ifdef MODM_OS_HOSTED
+// keep the producer and the consumer indices on separate cache lines
+static constexpr std::size_t IndexAlignment = 64;
+#else
+// single core without data cache, padding would only waste RAM
+static constexpr std::size_t IndexAlignment = alignof(uint32_t);
+#endif
+}
+/// @endcond
+
+/**
+ * Lock-free ring buffer with one producer and one consumer.
+ *
+ * The producer and the consumer may run in different contexts, e.g. an
+ * interrupt and a fiber, or two threads on a hosted target, without disabling
+ * interrupts. Each index is only written by one side and published with
+ * release semantics, the other side reads it with acquire semantics. The
+ * indices run freely and are masked into the buffer, so all `N` elements can
+ * be used and no division is needed.
+ *
+ * Each side also keeps the last index it has read from the other side, so
+ * that it only loads the shared index again when it seems to lack space or
+ * elements.
+ *
+ * Besides single elements, the ring hands out the contiguous free and used
+ * parts of the buffer as spans, so that DMA or `memcpy` can write and read
+ * them directly:
+ *
+ * @code
+ * modm::SpscRing<uint16_t, 512> samples;
+ *
+ * // producer: fill the contiguous free space, then publish it
+ * std::span<uint16_t> space = samples.reserve();
+ * const std::size_t count = adc_copy(space.data(), space.size());
+ * samples.commit(count);
+ *
+ * // consumer: process the contiguous data, then free it
+ * std::span<const uint16_t> data = samples.peek();
+ * process(data);
+ * samples.consume(data.size());
+ * @endcode
+ *
+ * @tparam	T	element type, must be default constructible
+ * @tparam	N	number of elements, must be a power of two
+ *
+ * @ingroup	modm_architecture_atomic
+ */
+template< typename T, std::size_t N >
+class SpscRing
+{
+	static_assert(std::has_single_bit(N) and N <= (1ul << 31),
+				  "The ring size must be a power of two of at most 2^31!");
+	static_assert(std::is_default_constructible_v<T>,
+				  "The ring elements must be default constructible!");
+	static constexpr uint32_t Mask = N - 1;
+
+public:
+	SpscRing() = default;
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	static constexpr std::size_t
+	getMaxSize()
+	{ return N; }
+
+	/// Number of stored elements, may be outdated when called by a third context.
+	std::size_t
+	getSize() const
+	{
+		const uint32_t tail = consumer.index.load(std::memory_order_acquire);
+		return producer.index.load(std::memory_order_acquire) - tail;
+	}
+
+	bool
+	isEmpty() const
+	{ return getSize() == 0; }
+
+	bool
+	isFull() const
+	{ return getSize() == N; }
+
+	// Producer -----------------------------------------------------------
+	/// @return	`false` if the ring is full.
+	bool
+	push(const T &value)
+	{
+		const uint32_t head = producer.index.load(std::memory_order_relaxed);
+		if (space(head, 1) == 0) return false;
+		buffer[head & Mask] = value;
+		producer.index.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Copies as many elements as fit into the ring in at most two chunks.
+	/// @return	number of copied elements.
+	std::size_t
+	push(std::span<const T> values)
+	{
+		const uint32_t head = producer.index.load(std::memory_order_relaxed);
+		const std::size_t count = std::min<std::size_t>(values.size(), space(head, values.size()));
+		const std::size_t chunk = std::min<std::size_t>(count, N - (head & Mask));
+		std::copy_n(values.begin(), chunk, buffer + (head & Mask));
+		std::copy_n(values.begin() + chunk, count - chunk, buffer);
+		producer.index.store(head + count, std::memory_order_release);
+		return count;
+	}
+
+	/**
+	 * Returns the contiguous free space up to the end of the buffer.
+	 *
+	 * The space may be shorter than the total free space, if it wraps around.
+	 * Write into it and then publish the written elements with `commit()`.
+	 */
+	std::span<T>
+	reserve()
+	{
+		const uint32_t head = producer.index.load(std::memory_order_relaxed);
+		const uint32_t contiguous = N - (head & Mask);
+		const std::size_t count = std::min(space(head, contiguous), contiguous);
+		return {buffer + (head & Mask), count};
+	}
+
+	/// Publishes `count` elements written into the reserved space.
+	void
+	commit(std::size_t count)
+	{
+		const uint32_t head = producer.index.load(std::memory_order_relaxed);
+		producer.index.store(head + count, std::memory_order_release);
+	}
+
+	// Consumer -----------------------------------------------------------
+	/// @return	`false` if the ring is empty.
+	bool
+	pop(T &value)
+	{
+		const uint32_t tail = consumer.index.load(std::memory_order_relaxed);
+		if (stored(tail, 1) == 0) return false;
+		value = std::move(buffer[tail & Mask]);
+		consumer.index.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Moves as many elements as are stored out of the ring in at most two chunks.
+	/// @return	number of moved elements.
+	std::size_t
+	pop(std::span<T> values)
+	{
+		const uint32_t tail = consumer.index.load(std::memory_order_relaxed);
+		const std::size_t count = std::min<std::size_t>(values.size(), stored(tail, values.size()));
+		const std::size_t chunk = std::min<std::size_t>(count, N - (tail & Mask));
+		std::move(buffer + (tail & Mask), buffer + (tail & Mask) + chunk, values.begin());
+		std::move(buffer, buffer + (count - chunk), values.begin() + chunk);
+		consumer.index.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+	/**
+	 * Returns the contiguous stored elements up to the end of the buffer.
+	 *
+	 * The span may be shorter than the total number of stored elements, if
+	 * they wrap around. Read them and then free them with `consume()`.
+	 */
+	std::span<const T>
+	peek()
+	{
+		const uint32_t tail = consumer.index.load(std::memory_order_relaxed);
+		const uint32_t contiguous = N - (tail & Mask);
+		const std::size_t count = std::min(stored(tail, contiguous), contiguous);
+		return {buffer + (tail & Mask), count};
+	}
+
+	/// Frees `count` elements that have been read from the peeked span.
+	void
+	consume(std::size_t count)
+	{
+		const uint32_t tail = consumer.index.load(std::memory_order_relaxed);
+		consumer.index.store(tail + count, std::memory_order_release);
+	}
+
+private:
+	/// Free elements seen by the producer, reloads the tail only if fewer are wanted.
+	uint32_t
+	space(uint32_t head, std::size_t wanted)
+	{
+		uint32_t count = N - (head - producer.cached);
+		if (count < wanted)
+		{
+			producer.cached = consumer.index.load(std::memory_order_acquire);
+			count = N - (head - producer.cached);
+		}
+		return count;
+	}
+
+	/// Stored elements seen by the consumer, reloads the head only if fewer are wanted.
+	uint32_t
+	stored(uint32_t tail, std::size_t wanted)
+	{
+		uint32_t count = consumer.cached - tail;
+		if (count < wanted)
+		{
+			consumer.cached = producer.index.load(std::memory_order_acquire);
+			count = consumer.cached - tail;
+		}
+		return count;
+	}
+
+	struct alignas(spsc_ring_detail::IndexAlignment) Side
+	{
+		/// written by this side only
+		std::atomic<uint32_t> index{0};
+		/// last index read from the other side
+		uint32_t cached{0};
+	};
+
+	Side producer;
+	Side consumer;
+	T buffer[N]{};
+};
+
+}	// namespace modm
+
+#endif	// MODM_SPSC_RING_HPP
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <modm/architecture/interface/clock.hpp>
+#include <algorithm>
 #include <utility>
 #include <type_traits>
 
@@ -53,6 +54,35 @@ yield();
 modm::fiber::id
 get_id();
 
+/// @cond
+namespace detail
+{
+
+/// Suspends the current fiber until the `micro_clock` reaches the wakeup time,
+/// which must be less than 2^31us in the future.
+void
+sleep(modm::chrono::micro_clock::time_point wakeup);
+
+/// Returns the signed duration until the time point. The modm clocks use
+/// unsigned durations, which wrap for time points in the past.
+template< class Clock, class Duration >
+auto
+until(std::chrono::time_point<Clock, Duration> time)
+{
+	const auto remaining = time - Clock::now();
+	using Rep = typename decltype(remaining)::rep;
+	if constexpr (std::is_unsigned_v<Rep>)
+	{
+		using Signed = std::make_signed_t<Rep>;
+		using Period = typename decltype(remaining)::period;
+		return std::chrono::duration<Signed, Period>(Signed(remaining.count()));
+	}
+	else return remaining;
+}
+
+} // namespace detail
+/// @endcond
+
 /// Yields the current fiber until `bool condition()` returns true.
 /// @warning If `bool condition()` is true on first call, no yield is performed!
 template< class Function >
@@ -134,32 +164,49 @@ poll_until(std::chrono::time_point<Clock, Duration> sleep_time, Function &&condi
 }
 
 /**
- * Yields the current fiber until the time duration has elapsed.
+ * Suspends the current fiber until the time duration has elapsed.
+ *
+ * The fiber is not resumed before it is due, so sleeping fibers do not cost
+ * any CPU time and the scheduler can put the core to sleep while all fibers
+ * are sleeping.
  *
  * @note For nanosecond delays, use `modm::delay(ns)`.
- * @note Due to the overhead of `yield()` and the scheduling other fibers, the
- *       sleep duration may be longer without any guarantee of an upper limit.
+ * @note The duration is rounded up to full microseconds. Due to the scheduling
+ *       of other fibers, the sleep duration may be longer without any
+ *       guarantee of an upper limit.
  * @see https://en.cppreference.com/w/cpp/thread/sleep_for
  */
 template< class Rep, class Period >
 void
 sleep_for(std::chrono::duration<Rep, Period> sleep_duration)
 {
-	(void) poll_for(sleep_duration, []{ return false; });
+	auto remaining = std::chrono::ceil<std::chrono::duration<int64_t, std::micro>>(sleep_duration).count();
+	if (remaining <= 0) return modm::this_fiber::yield();
+
+	// Long durations are split into steps that keep the 32-bit deadlines comparable
+	constexpr int64_t max_step = 1ll << 30;
+	auto wakeup = modm::chrono::micro_clock::now();
+	while (remaining > 0)
+	{
+		const auto step = std::min(remaining, max_step);
+		wakeup += modm::chrono::micro_clock::duration(step);
+		detail::sleep(wakeup);
+		remaining -= step;
+	}
 }
 
 /**
- * Yields the current fiber until the sleep time has been reached.
+ * Suspends the current fiber until the sleep time has been reached.
  *
- * @note Due to the overhead of `yield()` and the scheduling other fibers, the
- *       sleep duration may be longer without any guarantee of an upper limit.
+ * @note Due to the scheduling of other fibers, the sleep duration may be
+ *       longer without any guarantee of an upper limit.
  * @see https://en.cppreference.com/w/cpp/thread/sleep_until
  */
 template< class Clock, class Duration >
 void
 sleep_until(std::chrono::time_point<Clock, Duration> sleep_time)
 {
-	(void) poll_until(sleep_time, []{ return false; });
+	sleep_for(detail::until(sleep_time));
 }
 
 /// @}
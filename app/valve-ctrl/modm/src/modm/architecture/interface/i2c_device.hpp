@@ -75,7 +75,7 @@ public:
 
 		RF_WAIT_UNTIL( transaction.configurePing() and startTransaction() );
 
-		RF_WAIT_WHILE( isTransactionRunning() );
+		transaction.wait();
 
 		RF_END_RETURN( wasTransactionSuccessful() );
 	}
@@ -89,7 +89,7 @@ public:
 
 		RF_WAIT_UNTIL( startWriteRead(writeBuffer, writeSize, readBuffer, readSize) );
 
-		RF_WAIT_WHILE( isTransactionRunning() );
+		transaction.wait();
 
 		RF_END_RETURN( wasTransactionSuccessful() );
 	}
@@ -102,7 +102,7 @@ public:
 
 		RF_WAIT_UNTIL( startWrite(buffer, size) );
 
-		RF_WAIT_WHILE( isTransactionRunning() );
+		transaction.wait();
 
 		RF_END_RETURN( wasTransactionSuccessful() );
 	}
@@ -115,7 +115,7 @@ public:
 
 		RF_WAIT_UNTIL( startRead(buffer, size) );
 
-		RF_WAIT_WHILE( isTransactionRunning() );
+		transaction.wait();
 
 		RF_END_RETURN( wasTransactionSuccessful() );
 	}
@@ -183,7 +183,7 @@ protected:
 
 		RF_WAIT_UNTIL( startTransaction() );
 
-		RF_WAIT_WHILE( isTransactionRunning() );
+		transaction.wait();
 
 		RF_END_RETURN( wasTransactionSuccessful() );
 	}
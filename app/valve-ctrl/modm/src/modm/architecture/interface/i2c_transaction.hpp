@@ -13,6 +13,7 @@
 #define MODM_INTERFACE_I2C_TRANSACTION_HPP
 
 #include "i2c.hpp"
+#include <modm/processing/fiber/event_flags.hpp>
 
 namespace modm
 {
@@ -117,6 +118,32 @@ public:
 		return (state == TransactionState::Busy);
 	}
 
+	/**
+	 * Suspends the calling fiber until the transaction is detached.
+	 *
+	 * The I2C interrupt resumes the fiber when it detaches the transaction,
+	 * so the fiber does not poll the state in between. Only one fiber may
+	 * wait for a transaction.
+	 */
+	void inline
+	wait()
+	{
+		// a flag left over from the previous transaction returns immediately
+		while (isBusy()) detached.wait_any(1);
+	}
+
+	/// @return `false` if the timeout expired before the transaction was detached.
+	template< class Rep, class Period >
+	bool
+	wait_for(std::chrono::duration<Rep, Period> timeout)
+	{
+		const auto deadline = modm::chrono::micro_clock::now() +
+				std::chrono::ceil<modm::chrono::micro_clock::duration>(timeout);
+		while (isBusy())
+			if (not detached.wait_any_until(1, deadline)) return not isBusy();
+		return true;
+	}
+
 	/**
 	 * Initializes the adapter to only send the address without payload.
 	 *
@@ -218,11 +245,14 @@ public:
 	detaching(DetachCause cause)
 	{
 		state = (cause == DetachCause::NormalStop) ? TransactionState::Idle : TransactionState::Error;
+		detached.set(1);
 	}
 
 protected:
 	uint8_t address;
 	volatile TransactionState state;
+	/// set by `detaching()` to resume the fiber waiting in `wait()`
+	modm::fiber::event_flags detached;
 };
 
 /**
@@ -16,5 +16,6 @@
 #define MODM_DEBUG_HPP
 
 #include "debug/logger.hpp"
+#include "debug/telemetry.hpp"
 
 #endif	// MODM_DEBUG_HPP
@@ -14,4 +14,7 @@
 // ----------------------------------------------------------------------------
 
 #include "logger/logger.hpp"
+#include "logger/deferred.hpp"
+#include "logger/ring.hpp"
+#include "logger/zone.hpp"
 #include "logger/style.hpp"
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#include "deferred.hpp"
+
+#include <modm/architecture/interface/clock.hpp>
+
+namespace modm::log
+{
+
+uint32_t
+DeferredLogger::timestamp()
+{
+	return modm::chrono::micro_clock::now().time_since_epoch().count();
+}
+
+void
+DeferredLogger::send(deferred_detail::Frame &frame)
+{
+	uint8_t checksum = 0;
+	for (std::size_t ii = 0; ii < frame.size; ii++) checksum += frame.data[ii];
+	frame.append(uint8_t(-checksum));
+	if (frame.overflow) return;
+
+	// COBS encoding adds one byte per 254 bytes plus the zero delimiter
+	constexpr std::size_t Capacity = deferred_detail::Frame::Capacity;
+	char encoded[Capacity + Capacity / 254 + 2];
+	std::size_t code = 0, size = 1;
+	for (std::size_t ii = 0; ii < frame.size; ii++)
+	{
+		if (frame.data[ii])
+			encoded[size++] = char(frame.data[ii]);
+		if (not frame.data[ii] or size - code == 0xff)
+		{
+			encoded[code] = char(size - code);
+			code = size++;
+		}
+	}
+	encoded[code] = char(size - code);
+	encoded[size++] = 0;
+
+	device.write(encoded, size);
+}
+
+} // namespace modm::log
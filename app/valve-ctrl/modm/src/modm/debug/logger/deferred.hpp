@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_LOG_DEFERRED_HPP
+#define MODM_LOG_DEFERRED_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdint.h>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <modm/architecture/utils.hpp>
+#include <modm/io/iodevice.hpp>
+
+#include "logger.hpp"
+#include "zone.hpp"
+
+namespace modm::log
+{
+
+/// @cond
+namespace deferred_detail
+{
+
+enum class
+Argument : uint8_t
+{
+	Signed,
+	Unsigned,
+	Float,
+	String,
+	Invalid,
+};
+
+template< std::size_t N >
+struct Format
+{
+	char data[N];
+
+	consteval
+	Format(const char (&format)[N])
+	{ std::copy_n(format, N, data); }
+};
+
+consteval bool
+contains(std::string_view set, char c)
+{ return set.find(c) != std::string_view::npos; }
+
+/// Visits the conversions of a printf format string in order.
+template< typename Function >
+consteval void
+parse(const char *format, Function&& function)
+{
+	for (const char *c = format; *c; c++)
+	{
+		if (*c != '%') continue;
+		if (*++c == '%') continue;
+		while (contains("-+ #0", *c)) c++;
+		while (contains("0123456789.", *c)) c++;
+		while (contains("hljztL", *c)) c++;
+		if (contains("di", *c)) function(Argument::Signed);
+		else if (contains("uoxXcp", *c)) function(Argument::Unsigned);
+		else if (contains("fFeEgGaA", *c)) function(Argument::Float);
+		else if (*c == 's') function(Argument::String);
+		else { function(Argument::Invalid); if (not *c) return; }
+	}
+}
+
+template< Format F >
+consteval std::size_t
+count()
+{
+	std::size_t count = 0;
+	parse(F.data, [&](Argument) { count++; });
+	return count;
+}
+
+template< Format F >
+consteval auto
+conversions()
+{
+	std::array<Argument, count<F>()> result{};
+	std::size_t index = 0;
+	parse(F.data, [&](Argument argument) { result[index++] = argument; });
+	return result;
+}
+
+template< typename T >
+constexpr bool isString = std::is_convertible_v<const T&, std::string_view>;
+
+template< typename T >
+constexpr bool isInteger = not isString<T> and
+		(std::is_integral_v<T> or std::is_enum_v<T> or std::is_pointer_v<T>);
+
+template< Argument A, typename T >
+consteval bool
+matches()
+{
+	switch (A)
+	{
+		case Argument::Signed:
+		case Argument::Unsigned:
+			return isInteger<T>;
+		case Argument::Float:
+			return std::is_floating_point_v<T>;
+		case Argument::String:
+			return isString<T>;
+		default:
+			return false;
+	}
+}
+
+/// Binary log frame before COBS encoding.
+class Frame
+{
+public:
+	static constexpr std::size_t Capacity = 64;
+
+	void
+	varint(uint32_t value)
+	{
+		while (value >= 0x80 and size < Capacity) {
+			data[size++] = uint8_t(value) | 0x80;
+			value >>= 7;
+		}
+		append(uint8_t(value));
+	}
+
+	void
+	varint(uint64_t value)
+	{
+		while (value > UINT32_MAX and size < Capacity) {
+			data[size++] = uint8_t(value) | 0x80;
+			value >>= 7;
+		}
+		varint(uint32_t(value));
+	}
+
+	template< Argument A, typename T >
+	void
+	add(const T &value)
+	{
+		if constexpr (A == Argument::String)
+		{
+			const std::string_view string{value};
+			// keep room for the length and the checksum
+			const std::size_t length = std::min<std::size_t>(string.size(),
+					(size + 2 < Capacity) ? Capacity - size - 2 : 0);
+			varint(uint32_t(length));
+			for (std::size_t ii = 0; ii < length; ii++) append(uint8_t(string[ii]));
+		}
+		else if constexpr (A == Argument::Float)
+		{
+			const float number = float(value);
+			const auto *bytes = reinterpret_cast<const uint8_t*>(&number);
+			for (std::size_t ii = 0; ii < sizeof(float); ii++) append(bytes[ii]);
+		}
+		else
+		{
+			const auto number = integer(value);
+			using I = decltype(number);
+			using Wire = std::conditional_t<(sizeof(I) > 4), uint64_t, uint32_t>;
+			if constexpr (A == Argument::Signed)
+			{
+				// zigzag encoding, so that small negative values stay short
+				const auto sign = std::make_signed_t<Wire>(number);
+				varint(Wire((Wire(sign) << 1) ^ Wire(sign >> (sizeof(Wire) * 8 - 1))));
+			}
+			else varint(Wire(std::make_unsigned_t<I>(number)));
+		}
+	}
+
+	void
+	append(uint8_t byte)
+	{
+		if (size < Capacity) data[size++] = byte;
+		else overflow = true;
+	}
+
+	uint8_t data[Capacity];
+	std::size_t size{0};
+	bool overflow{false};
+
+private:
+	template< typename T >
+	static auto
+	integer(const T &value)
+	{
+		if constexpr (std::is_pointer_v<T>) return reinterpret_cast<uintptr_t>(value);
+		else if constexpr (std::is_enum_v<T>) return std::underlying_type_t<T>(value);
+		else if constexpr (std::is_same_v<T, bool>) return uint8_t(value);
+		else return value;
+	}
+};
+
+} // namespace deferred_detail
+/// @endcond
+
+/**
+ * Deferred binary logger.
+ *
+ * In contrast to the `Logger` the message is not formatted on the target.
+ * The format string is interned into the `.modm_log_strings` section, which
+ * is not loaded into the device, and only its address plus the binary encoded
+ * arguments are transmitted. The `modm_tools.deferred_log` decoder reads the
+ * strings from the ELF file and formats the messages on the host.
+ *
+ * A message is encoded into a frame on the stack, then written with a single
+ * block write. Use a `modm::log::RingBlockDevice` as output to log from interrupts
+ * and fibers concurrently without any locking. The frame contains:
+ *
+ * - the string address as varint,
+ * - the `modm::chrono::micro_clock` timestamp as varint,
+ * - the arguments: integers as varint (`%d`/`%i` zigzag encoded), floats
+ *   as four byte little-endian IEEE754 and strings as varint length plus
+ *   the characters,
+ * - a checksum that makes the sum of all frame bytes zero.
+ *
+ * The frame is COBS encoded and terminated with a zero byte, so that the
+ * decoder can resynchronize after frames that were dropped or truncated by a
+ * full output buffer. The arguments are limited to 64 bytes per frame,
+ * longer messages are dropped.
+ *
+ * The format string uses printf conversions, which are checked against the
+ * argument types at compile time. Integers are transmitted as the conversion
+ * requires, e.g. `%x` sends a negative `int` as its unsigned bit pattern.
+ *
+ * @code
+ * modm::log::Ring<1024> deferred_ring;
+ * modm::log::RingBlockDevice<decltype(deferred_ring)> deferred_device(deferred_ring, modm::log::DEBUG);
+ * modm::log::DeferredLogger modm::log::deferred(deferred_device);
+ * // deferred_ring.drainPayload() to RTT channel 3 in a fiber
+ *
+ * MODM_DLOG_INFO("valve %u at %d steps, current %.2f A", valve, position, current);
+ * @endcode
+ *
+ * @ingroup modm_debug
+ */
+class DeferredLogger
+{
+public:
+	DeferredLogger(IODevice &device) :
+		device(device)
+	{}
+
+	DeferredLogger(const DeferredLogger&) = delete;
+
+	DeferredLogger&
+	operator = (const DeferredLogger&) = delete;
+
+	/// Use the `MODM_DLOG_*` macros instead, which intern the format string.
+	template< deferred_detail::Format F, typename... Args >
+	void
+	log(const char *format, const Args&... args)
+	{
+		using namespace deferred_detail;
+		static constexpr auto arguments = conversions<F>();
+		static_assert(arguments.size() == sizeof...(Args),
+				"The number of arguments does not match the deferred log format string!");
+		static_assert([]<std::size_t... I>(std::index_sequence<I...>)
+				{ return (matches<arguments[I], std::remove_cvref_t<Args>>() and ...); }
+				(std::index_sequence_for<Args...>{}),
+				"The argument types do not match the deferred log format string!");
+
+		Frame frame;
+		frame.varint(uint32_t(reinterpret_cast<uintptr_t>(format)));
+		frame.varint(timestamp());
+		[&]<std::size_t... I>(std::index_sequence<I...>)
+		{ (frame.template add<arguments[I]>(args), ...); }
+		(std::index_sequence_for<Args...>{});
+		send(frame);
+	}
+
+private:
+	static uint32_t
+	timestamp();
+
+	void
+	send(deferred_detail::Frame &frame);
+
+	IODevice &device;
+};
+
+/// Deferred log output, must be defined by the application.
+/// @ingroup modm_debug
+extern DeferredLogger deferred;
+
+} // namespace modm::log
+
+/// @cond
+#define MODM_DLOG_STRING(tag, format) \
+	([]() -> const char* { \
+		modm_section(".modm_log_strings." MODM_STRINGIFY(__COUNTER__)) modm_used \
+		static const char string[] = tag "\037" FILENAME ":" MODM_STRINGIFY(__LINE__) "\037" format; \
+		return string; }())
+
+#define MODM_DLOG(level, tag, format, ...) \
+	if (MODM_LOG_LEVEL > level){} \
+	else modm::log::deferred.log<format>(MODM_DLOG_STRING(tag, format) __VA_OPT__(,) __VA_ARGS__)
+
+#define MODM_DLOG_ZONE(zone, level, tag, format, ...) \
+	MODM_LOG_ZONE_IF(zone, level) \
+	modm::log::deferred.log<format>(MODM_DLOG_STRING(tag, format) __VA_OPT__(,) __VA_ARGS__)
+/// @endcond
+
+/**
+ * Deferred debug message with printf format string and arguments.
+ * @ingroup modm_debug
+ */
+#define MODM_DLOG_DEBUG(format, ...) MODM_DLOG(modm::log::DEBUG, "D", format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * Deferred info message with printf format string and arguments.
+ * @ingroup modm_debug
+ */
+#define MODM_DLOG_INFO(format, ...) MODM_DLOG(modm::log::INFO, "I", format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * Deferred warning with printf format string and arguments.
+ * @ingroup modm_debug
+ */
+#define MODM_DLOG_WARNING(format, ...) MODM_DLOG(modm::log::WARNING, "W", format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * Deferred error message with printf format string and arguments.
+ * @ingroup modm_debug
+ */
+#define MODM_DLOG_ERROR(format, ...) MODM_DLOG(modm::log::ERROR, "E", format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * Deferred debug message of a log zone.
+ * @ingroup modm_debug
+ */
+#define MODM_DLOG_DEBUG_ZONE(zone, format, ...) MODM_DLOG_ZONE(zone, modm::log::DEBUG, "D", format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * Deferred info message of a log zone.
+ * @ingroup modm_debug
+ */
+#define MODM_DLOG_INFO_ZONE(zone, format, ...) MODM_DLOG_ZONE(zone, modm::log::INFO, "I", format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * Deferred warning of a log zone.
+ * @ingroup modm_debug
+ */
+#define MODM_DLOG_WARNING_ZONE(zone, format, ...) MODM_DLOG_ZONE(zone, modm::log::WARNING, "W", format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * Deferred error message of a log zone.
+ * @ingroup modm_debug
+ */
+#define MODM_DLOG_ERROR_ZONE(zone, format, ...) MODM_DLOG_ZONE(zone, modm::log::ERROR, "E", format __VA_OPT__(,) __VA_ARGS__)
+
+#endif // MODM_LOG_DEFERRED_HPP
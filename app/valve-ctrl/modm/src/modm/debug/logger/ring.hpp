@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_LOG_RING_HPP
+#define MODM_LOG_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <stdint.h>
+#include <utility>
+
+#include <modm/architecture/interface/clock.hpp>
+#include <modm/architecture/interface/fiber.hpp>
+#include <modm/io/iodevice.hpp>
+
+#include "level.hpp"
+
+namespace modm::log
+{
+
+/**
+ * Lock-free multi-producer single-consumer ring of log records.
+ *
+ * Producers reserve a contiguous record with a single compare-and-swap, copy
+ * their message into it and commit it. This never blocks and never disables
+ * interrupts, so interrupts, fibers and threads may log concurrently with a
+ * bounded latency. If the ring is full, the record is dropped and counted.
+ *
+ * A single consumer, usually a low-priority fiber, drains the committed
+ * records in reservation order. It stops at the first record that is
+ * reserved but not committed yet, i.e. a producer that was interrupted while
+ * copying delays the later records, but does not corrupt them.
+ *
+ * Every record carries the `micro_clock` timestamp of the reservation and a
+ * log level. Records are aligned to 8 bytes and do not wrap around the end of
+ * the ring, a padding record fills the rest of the ring instead.
+ *
+ * @code
+ * modm::log::Ring<2048> log_ring;
+ *
+ * // any context
+ * if (auto record = log_ring.reserve(length, modm::log::INFO)) {
+ *     std::memcpy(record, message, length);
+ *     log_ring.commit(record);
+ * }
+ * // drain fiber
+ * modm::Fiber<> log_fiber([] {
+ *     while (true) { log_ring.drain(rtt_device); modm::this_fiber::sleep_for(5ms); }
+ * }, modm::fiber::Start::Now, modm::fiber::PriorityLowest);
+ * @endcode
+ *
+ * @tparam	Size	ring size in bytes, must be a power of two
+ *
+ * @ingroup modm_debug
+ */
+template< std::size_t Size >
+class Ring
+{
+	static_assert(std::has_single_bit(Size) and Size >= 64,
+				  "The log ring size must be a power of two of at least 64 bytes!");
+	static constexpr uint32_t Mask = Size - 1;
+	static constexpr uint8_t Padding = 0xff;
+
+public:
+	struct Record
+	{
+		uint32_t timestamp;	///< `micro_clock` time of the reservation
+		uint16_t length;	///< payload length in bytes
+		uint8_t level;		///< `modm::log::Level`
+		uint8_t committed;
+
+		uint8_t*
+		data()
+		{ return reinterpret_cast<uint8_t*>(this + 1); }
+
+		const uint8_t*
+		data() const
+		{ return reinterpret_cast<const uint8_t*>(this + 1); }
+	};
+	static_assert(sizeof(Record) == 8);
+
+	/// Largest payload of a single record.
+	static constexpr std::size_t MaxLength = Size / 2 - sizeof(Record);
+
+	/**
+	 * Reserves a record with space for `length` bytes.
+	 *
+	 * @return	pointer to the payload, or `nullptr` if the ring is full.
+	 */
+	uint8_t*
+	reserve(std::size_t length, Level level)
+	{
+		if (length > MaxLength) { dropped.fetch_add(1, std::memory_order_relaxed); return nullptr; }
+		const uint32_t size = align(sizeof(Record) + length);
+		uint32_t head = reserved.load(std::memory_order_relaxed);
+		uint32_t padding;
+		do
+		{
+			const uint32_t offset = head & Mask;
+			padding = (offset + size > Size) ? Size - offset : 0;
+			if (head + padding + size - released.load(std::memory_order_acquire) > Size)
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+		}
+		while (not reserved.compare_exchange_weak(head, head + padding + size,
+				std::memory_order_acquire, std::memory_order_relaxed));
+
+		if (padding)
+		{
+			Record &pad = at(head);
+			pad.length = padding - sizeof(Record);
+			pad.level = Padding;
+			publish(pad);
+			head += padding;
+		}
+		Record &record = at(head);
+		record.timestamp = modm::chrono::micro_clock::now().time_since_epoch().count();
+		record.length = length;
+		record.level = level;
+		return record.data();
+	}
+
+	/// Makes a reserved record visible to the consumer.
+	void
+	commit(uint8_t *data)
+	{
+		publish(reinterpret_cast<Record*>(data)[-1]);
+	}
+
+	/// Reserves, copies and commits a record in one go.
+	bool
+	write(std::span<const uint8_t> message, Level level)
+	{
+		uint8_t *data = reserve(message.size(), level);
+		if (data == nullptr) return false;
+		std::memcpy(data, message.data(), message.size());
+		commit(data);
+		return true;
+	}
+
+	/**
+	 * Passes all committed records in order to `function(const Record&)`,
+	 * then releases their space. Must only be called from one context.
+	 *
+	 * @return	number of drained records.
+	 */
+	template< typename Function >
+	requires std::invocable<Function, const Record&>
+	std::size_t
+	drain(Function &&function)
+	{
+		std::size_t count = 0;
+		uint32_t tail = released.load(std::memory_order_relaxed);
+		while (tail != reserved.load(std::memory_order_acquire))
+		{
+			Record &record = at(tail);
+			if (not std::atomic_ref(record.committed).load(std::memory_order_acquire)) break;
+			const uint32_t size = align(sizeof(Record) + record.length);
+			if (record.level != Padding) { function(std::as_const(record)); count++; }
+			// Zero the record, so that a new header at any offset reads as uncommitted
+			std::memset(&record, 0, size);
+			tail += size;
+			released.store(tail, std::memory_order_release);
+		}
+		return count;
+	}
+
+	/**
+	 * Writes all committed records to the device as text.
+	 *
+	 * Every line starts with the timestamp of its record in seconds and the
+	 * first letter of its level, e.g. `12.345678 I message`. Records that
+	 * continue a line without a newline are not prefixed again.
+	 */
+	std::size_t
+	drain(IODevice &device)
+	{
+		return drain([&](const Record &record)
+		{
+			if (lineStart)
+			{
+				char prefix[20];
+				const int length = snprintf(prefix, sizeof(prefix), "%lu.%06lu %c ",
+						(unsigned long)(record.timestamp / 1'000'000),
+						(unsigned long)(record.timestamp % 1'000'000),
+						record.level < DISABLED ? "DIWE"[record.level] : '?');
+				device.write(prefix, length);
+			}
+			device.write(reinterpret_cast<const char*>(record.data()), record.length);
+			lineStart = record.length and record.data()[record.length - 1] == '\n';
+		});
+	}
+
+	/// Writes only the payload of all committed records, e.g. binary frames.
+	std::size_t
+	drainPayload(IODevice &device)
+	{
+		return drain([&](const Record &record)
+		{ device.write(reinterpret_cast<const char*>(record.data()), record.length); });
+	}
+
+	bool
+	isEmpty() const
+	{ return released.load(std::memory_order_relaxed) == reserved.load(std::memory_order_relaxed); }
+
+	/// Number of records dropped, since the ring was full.
+	uint32_t
+	getDropped() const
+	{ return dropped.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr uint32_t
+	align(std::size_t size)
+	{ return (size + 7) & ~7ul; }
+
+	Record&
+	at(uint32_t index)
+	{ return *reinterpret_cast<Record*>(buffer + (index & Mask)); }
+
+	static void
+	publish(Record &record)
+	{ std::atomic_ref(record.committed).store(1, std::memory_order_release); }
+
+	alignas(8) uint8_t buffer[Size]{};
+	std::atomic<uint32_t> reserved{0};
+	std::atomic<uint32_t> released{0};
+	std::atomic<uint32_t> dropped{0};
+	/// only used by the consumer
+	bool lineStart{true};
+};
+
+/**
+ * Text output device that writes every line into a log ring as one record.
+ *
+ * A log stream calls the device once per `<<` element, so the device collects
+ * the elements of each calling context, i.e. fiber or interrupt, in a line
+ * buffer and writes the line as one record at the newline of `modm::endl` or
+ * at `flush()`. Lines from concurrent contexts therefore never interleave.
+ *
+ * A context claims one of the `Lines` buffers with a compare-and-swap on its
+ * first write of a line and releases it when the line is written. If all
+ * buffers are in use, e.g. by deeply nested interrupts, the elements are
+ * written as separate records instead. Lines longer than `LineLength` are
+ * split into several records.
+ *
+ * Use one device per log level, so that the records carry the level of their
+ * logger.
+ *
+ * @code
+ * modm::log::RingDevice<decltype(log_ring)> info_device(log_ring, modm::log::INFO);
+ * modm::log::Logger modm::log::info(info_device);
+ * @endcode
+ *
+ * @tparam	Ring		`modm::log::Ring`
+ * @tparam	LineLength	size of a line buffer in bytes
+ * @tparam	Lines		number of contexts that can write a line at the same time
+ *
+ * @ingroup modm_debug
+ */
+template< class Ring, std::size_t LineLength = 80, uint8_t Lines = 2 >
+class RingDevice : public IODevice
+{
+	static_assert(LineLength <= Ring::MaxLength, "The line must fit into a ring record!");
+
+public:
+	RingDevice(Ring &ring, Level level) :
+		ring(ring), level(level)
+	{}
+
+	void
+	write(char c) override
+	{ write(&c, 1); }
+
+	void
+	write(const char *str) override
+	{ write(str, std::strlen(str)); }
+
+	void
+	write(const char *data, std::size_t length) override
+	{
+		Line *line = acquire();
+		if (line == nullptr)
+		{
+			ring.write({reinterpret_cast<const uint8_t*>(data), length}, level);
+			return;
+		}
+		while (length)
+		{
+			const char *newline = static_cast<const char*>(std::memchr(data, '\n', length));
+			std::size_t count = newline ? newline - data + 1 : length;
+			count = std::min(count, LineLength - line->length);
+			std::memcpy(line->data + line->length, data, count);
+			line->length += count;
+			data += count;
+			length -= count;
+			if (line->length == LineLength or line->data[line->length - 1] == '\n')
+				commit(*line);
+		}
+		if (line->length == 0) release(*line);
+	}
+
+	void
+	flush() override
+	{
+		if (Line *line = find(context()))
+		{
+			commit(*line);
+			release(*line);
+		}
+	}
+
+	bool
+	read(char&) override
+	{ return false; }
+
+private:
+	struct Line
+	{
+		/// context that writes this line, zero if unused
+		std::atomic<uintptr_t> owner{0};
+		uint16_t length{0};
+		char data[LineLength];
+	};
+
+	/// Fibers and interrupts have different IDs, the offset keeps zero free.
+	static uintptr_t
+	context()
+	{ return uintptr_t(modm::this_fiber::get_id()) + 1; }
+
+	Line*
+	find(uintptr_t owner)
+	{
+		for (Line &line : lines)
+			if (line.owner.load(std::memory_order_relaxed) == owner) return &line;
+		return nullptr;
+	}
+
+	Line*
+	acquire()
+	{
+		const uintptr_t owner = context();
+		if (Line *line = find(owner)) return line;
+		for (Line &line : lines)
+		{
+			uintptr_t expected = 0;
+			if (line.owner.compare_exchange_strong(expected, owner, std::memory_order_acquire))
+				return &line;
+		}
+		return nullptr;
+	}
+
+	void
+	commit(Line &line)
+	{
+		if (line.length)
+			ring.write({reinterpret_cast<const uint8_t*>(line.data), line.length}, level);
+		line.length = 0;
+	}
+
+	static void
+	release(Line &line)
+	{ line.owner.store(0, std::memory_order_release); }
+
+	Ring &ring;
+	const Level level;
+	Line lines[Lines];
+};
+
+/**
+ * Output device that writes every block into a log ring as one record.
+ *
+ * Meant for binary frames that are written with a single block write, like
+ * the ones of the `modm::log::DeferredLogger`. Drain the ring with
+ * `Ring::drainPayload()`, so that the frames are not prefixed.
+ *
+ * @ingroup modm_debug
+ */
+template< class Ring >
+class RingBlockDevice : public IODevice
+{
+public:
+	RingBlockDevice(Ring &ring, Level level) :
+		ring(ring), level(level)
+	{}
+
+	void
+	write(char c) override
+	{ write(&c, 1); }
+
+	void
+	write(const char *str) override
+	{ write(str, std::strlen(str)); }
+
+	void
+	write(const char *data, std::size_t length) override
+	{ ring.write({reinterpret_cast<const uint8_t*>(data), length}, level); }
+
+	void
+	flush() override {}
+
+	bool
+	read(char&) override
+	{ return false; }
+
+private:
+	Ring &ring;
+	const Level level;
+};
+
+} // namespace modm::log
+
+#endif // MODM_LOG_RING_HPP
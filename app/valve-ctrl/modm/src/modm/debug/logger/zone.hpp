@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_LOG_ZONE_HPP
+#define MODM_LOG_ZONE_HPP
+
+#include <atomic>
+#include <stdint.h>
+#include <string_view>
+
+#include "level.hpp"
+
+namespace modm::log
+{
+
+/**
+ * Log zone with a runtime log level.
+ *
+ * A zone groups the log messages of one module, e.g. the valve driver. Its
+ * level can be changed at runtime, e.g. via the command channel, to enable
+ * the debug messages of a single zone while investigating a problem.
+ *
+ * The compile-time `MODM_LOG_LEVEL` remains the floor: messages below it are
+ * removed completely including the evaluation of their arguments. Messages
+ * above it cost a single load and compare of the zone level.
+ *
+ * @code
+ * MODM_LOG_ZONE(valve, modm::log::INFO);
+ *
+ * MODM_LOG_DEBUG_ZONE(valve) << "position " << position << modm::endl;
+ * MODM_DLOG_DEBUG_ZONE(valve, "position %d", position);
+ *
+ * modm::log::Zone::setLevel("valve", modm::log::DEBUG);
+ * @endcode
+ *
+ * All zones register themselves in a list on construction, so zones must be
+ * objects with static storage duration.
+ *
+ * @ingroup modm_debug
+ */
+class Zone
+{
+public:
+	Zone(const char *name, Level level = INFO) :
+		name(name), level(level), next(first)
+	{ first = this; }
+
+	Zone(const Zone&) = delete;
+
+	Zone&
+	operator = (const Zone&) = delete;
+
+	/// `true` if messages of this level are currently enabled.
+	bool
+	isEnabled(Level level) const
+	{ return level >= this->level.load(std::memory_order_relaxed); }
+
+	Level
+	getLevel() const
+	{ return Level(level.load(std::memory_order_relaxed)); }
+
+	void
+	setLevel(Level level)
+	{ this->level.store(level, std::memory_order_relaxed); }
+
+	const char*
+	getName() const
+	{ return name; }
+
+	/// @return	zone with this name, or `nullptr` if there is none.
+	static Zone*
+	find(std::string_view name)
+	{
+		for (Zone *zone = first; zone; zone = zone->next)
+			if (name == zone->name) return zone;
+		return nullptr;
+	}
+
+	/// Sets the level of the named zone, or of all zones for the name `*`.
+	/// @return	`false` if there is no zone with this name.
+	static bool
+	setLevel(std::string_view name, Level level)
+	{
+		if (name == "*")
+		{
+			for (Zone *zone = first; zone; zone = zone->next) zone->setLevel(level);
+			return true;
+		}
+		Zone *zone = find(name);
+		if (zone) zone->setLevel(level);
+		return zone;
+	}
+
+	/// Calls `function(Zone&)` for all zones.
+	template< typename Function >
+	static void
+	forEach(Function &&function)
+	{
+		for (Zone *zone = first; zone; zone = zone->next) function(*zone);
+	}
+
+private:
+	const char *const name;
+	std::atomic<uint8_t> level;
+	Zone *const next;
+
+	static inline constinit Zone *first{nullptr};
+};
+
+} // namespace modm::log
+
+/**
+ * Defines a log zone with a default runtime level.
+ * @ingroup modm_debug
+ */
+#define MODM_LOG_ZONE(zone, ...) \
+	modm::log::Zone zone{#zone __VA_OPT__(,) __VA_ARGS__}
+
+/// @cond
+#define MODM_LOG_ZONE_IF(zone, level) \
+	if constexpr (MODM_LOG_LEVEL > level){} \
+	else if (not (zone).isEnabled(level)){} \
+	else
+/// @endcond
+
+/**
+ * Output stream for debug messages of a zone
+ * @ingroup modm_debug
+ */
+#define MODM_LOG_DEBUG_ZONE(zone) \
+	MODM_LOG_ZONE_IF(zone, modm::log::DEBUG) modm::log::debug
+
+/**
+ * Output stream for info messages of a zone
+ * @ingroup modm_debug
+ */
+#define MODM_LOG_INFO_ZONE(zone) \
+	MODM_LOG_ZONE_IF(zone, modm::log::INFO) modm::log::info
+
+/**
+ * Output stream for warnings of a zone
+ * @ingroup modm_debug
+ */
+#define MODM_LOG_WARNING_ZONE(zone) \
+	MODM_LOG_ZONE_IF(zone, modm::log::WARNING) modm::log::warning
+
+/**
+ * Output stream for error messages of a zone
+ * @ingroup modm_debug
+ */
+#define MODM_LOG_ERROR_ZONE(zone) \
+	MODM_LOG_ZONE_IF(zone, modm::log::ERROR) modm::log::error
+
+#endif // MODM_LOG_ZONE_HPP
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_TELEMETRY_HPP
+#define MODM_TELEMETRY_HPP
+
+#include "telemetry/fiber_report.hpp"
+#include "telemetry/parameter.hpp"
+#include "telemetry/sample_stream.hpp"
+#include "telemetry/snapshot.hpp"
+
+#endif // MODM_TELEMETRY_HPP
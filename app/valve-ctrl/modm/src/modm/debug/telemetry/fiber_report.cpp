@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#include "fiber_report.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+
+#include <modm/architecture/interface/clock.hpp>
+#include <modm/platform/device.hpp>
+
+namespace modm::telemetry
+{
+
+void
+FiberReport::print(IOStream &stream)
+{
+	const uint32_t now = modm::chrono::micro_clock::now().time_since_epoch().count();
+	const uint64_t elapsed = uint64_t(now - last) * SystemCoreClock / 1'000'000;
+	last = now;
+	if (elapsed == 0) return;
+
+	// one record per line, since the log streams may be lock-free rings
+	char line[64];
+	const auto row = [&](const char *name, const fiber::CpuTime &cpu, const fiber::Task *task = nullptr)
+	{
+		const uint32_t permille = std::min<uint64_t>(cpu.cycles * 1000 / elapsed, 1000);
+		const uint32_t slice = uint64_t(cpu.longest_slice) * 1'000'000 / SystemCoreClock;
+		int length = snprintf(line, sizeof(line), "%-12.12s %3lu.%lu%% %8lu %8lu us", name,
+							  permille / 10, permille % 10, cpu.switches, slice);
+		if (task)
+		{
+			length += snprintf(line + length, sizeof(line) - length, "  %5zu/%zu",
+							   task->stack_usage(), task->stack_size());
+		}
+		snprintf(line + length, sizeof(line) - length, "\n");
+		stream << line;
+	};
+
+	stream << "fiber          load  resumed   max slice  stack\n";
+	uint64_t accounted = 0;
+	for (const FiberEntry &entry : fibers)
+	{
+		const fiber::CpuTime cpu = entry.task->cpu_time();
+		entry.task->cpu_time_reset();
+		accounted += cpu.cycles;
+		row(entry.name, cpu, entry.task);
+	}
+	const fiber::CpuTime idle = fiber::Scheduler::getIdleTime();
+	fiber::Scheduler::resetIdleTime();
+	accounted += idle.cycles;
+	row("idle", idle);
+	row("other", {elapsed - std::min(accounted, elapsed), 0, 0});
+}
+
+} // namespace modm::telemetry
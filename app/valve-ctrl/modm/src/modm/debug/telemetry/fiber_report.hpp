@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_TELEMETRY_FIBER_REPORT_HPP
+#define MODM_TELEMETRY_FIBER_REPORT_HPP
+
+#include <span>
+#include <stdint.h>
+
+#include <modm/io/iostream.hpp>
+#include <modm/processing/fiber.hpp>
+
+namespace modm::telemetry
+{
+
+/// Named fiber of a `FiberReport`.
+/// @ingroup modm_debug
+struct FiberEntry
+{
+	const char *name;
+	modm::fiber::Task *task;
+};
+
+/**
+ * Text report of the CPU time and stack usage of fibers.
+ *
+ * Prints one line per fiber with its share of the CPU time, the number of
+ * times it was resumed and its longest run between two scheduling points in
+ * microseconds since the previous report, then resets the counters. The
+ * time spent in the idle hook, asleep or polling, follows as `idle`, the
+ * cycles of fibers that are not listed and of the scheduler itself as `other`.
+ *
+ * The last column shows the stack usage and the stack size of each fiber in
+ * bytes. The stacks must be watermarked before the scheduler runs, otherwise
+ * the usage is meaningless.
+ *
+ * @code
+ * modm::telemetry::FiberEntry fibers[] = {
+ *     {"control", &control_fiber},
+ *     {"log", &log_fiber},
+ * };
+ * modm::telemetry::FiberReport fiber_report(fibers);
+ * // in main() before modm::fiber::Scheduler::run()
+ * for (auto &entry : fibers) entry.task->stack_watermark();
+ *
+ * modm::Fiber<> report_fiber([]
+ * {
+ *     while (true) { modm::this_fiber::sleep_for(10s); fiber_report.print(modm::log::info); }
+ * });
+ * @endcode
+ *
+ * @ingroup modm_debug
+ */
+class FiberReport
+{
+public:
+	FiberReport(std::span<const FiberEntry> fibers) :
+		fibers(fibers)
+	{}
+
+	/// Prints the CPU time since the previous call and resets it.
+	void
+	print(IOStream &stream);
+
+private:
+	std::span<const FiberEntry> fibers;
+	/// `micro_clock` time of the previous report
+	uint32_t last{0};
+};
+
+} // namespace modm::telemetry
+
+#endif // MODM_TELEMETRY_FIBER_REPORT_HPP
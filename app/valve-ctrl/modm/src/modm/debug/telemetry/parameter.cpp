@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#include "parameter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#include <modm/architecture/interface/atomic_lock.hpp>
+#include <modm/math/utils/crc.hpp>
+
+#include "../logger/zone.hpp"
+
+namespace modm::telemetry
+{
+
+namespace
+{
+
+uint16_t
+load16(const uint8_t *data)
+{
+	return uint16_t(data[0] | (data[1] << 8));
+}
+
+void
+store16(uint8_t *&output, uint16_t value)
+{
+	*output++ = uint8_t(value);
+	*output++ = uint8_t(value >> 8);
+}
+
+uint16_t
+crc(std::span<const uint8_t> data)
+{
+	return modm::math::crc16_ccitt_update<modm::math::CrcLookup::Bitwise>(
+			modm::math::crc16_ccitt_init, data);
+}
+
+}
+
+bool
+ParameterServer::next(std::span<const uint8_t> &response)
+{
+	while (scanned < rx_size and rx[scanned]) scanned++;
+	if (scanned == rx_size)
+	{
+		// a frame that does not fit is dropped up to the next delimiter
+		if (rx_size == sizeof(rx)) {
+			rx_size = scanned = 0;
+			discard = true;
+		}
+		return false;
+	}
+
+	const std::size_t end = scanned;
+	response = {};
+	if (not discard and end)
+	{
+		// COBS decode in place, the output never overtakes the input
+		std::size_t index = 0, size = 0;
+		bool valid = true;
+		while (index < end)
+		{
+			const uint8_t code = rx[index];
+			if (index + code > end) { valid = false; break; }
+			for (uint8_t ii = 1; ii < code; ii++) rx[size++] = rx[index + ii];
+			index += code;
+			if (code < 0xff and index < end) rx[size++] = 0;
+		}
+		if (valid and size <= MaxFrameSize)
+		{
+			if (const std::size_t length = handle({rx, size}); length)
+			{
+				std::size_t code = 0, encoded = 1;
+				for (std::size_t ii = 0; ii < length; ii++)
+				{
+					if (frame[ii]) tx[encoded++] = frame[ii];
+					if (not frame[ii] or encoded - code == 0xff)
+					{
+						tx[code] = uint8_t(encoded - code);
+						code = encoded++;
+					}
+				}
+				tx[code] = uint8_t(encoded - code);
+				tx[encoded++] = 0;
+				response = {tx, encoded};
+			}
+		}
+	}
+	discard = false;
+
+	std::memmove(rx, rx + end + 1, rx_size - end - 1);
+	rx_size -= end + 1;
+	scanned = 0;
+	return true;
+}
+
+std::size_t
+ParameterServer::handle(std::span<const uint8_t> request)
+{
+	if (request.size() < 4) return 0;
+	const std::size_t length = request.size() - 2;
+	if (crc(request.first(length)) != load16(request.data() + length)) return 0;
+
+	frame[0] = request[0] | 0x80;
+	frame[1] = request[1];
+	uint8_t *output = frame + 3;
+	const auto payload = request.subspan(2, length - 2);
+
+	Status status;
+	switch (Command(request[0]))
+	{
+		case Command::List:
+			status = list(payload, output);
+			break;
+		case Command::Get:
+			status = get(payload, output);
+			break;
+		case Command::Set:
+			status = set(payload, output);
+			break;
+		case Command::Snapshot:
+			if (snapshot == nullptr) { status = Status::UnknownCommand; break; }
+			if (not payload.empty()) { status = Status::Malformed; break; }
+			// the record is streamed by update()
+			snapshot_requested = true;
+			snapshot_sequence = request[1];
+			return 0;
+		case Command::Schema:
+			status = schema(payload, output);
+			break;
+		case Command::LogZone:
+			status = logZone(payload);
+			break;
+		default:
+			status = Status::UnknownCommand;
+			break;
+	}
+	frame[2] = uint8_t(status);
+
+	store16(output, crc({frame, std::size_t(output - frame)}));
+	return output - frame;
+}
+
+ParameterServer::Status
+ParameterServer::list(std::span<const uint8_t> payload, uint8_t *&output)
+{
+	if (payload.size() != 2) return Status::Malformed;
+	std::size_t index = load16(payload.data());
+	// keep room for the next index and the CRC
+	const uint8_t *const end = frame + MaxFrameSize - 2 - 2;
+	uint8_t *position = output;
+	output += 2;
+
+	for (; index < parameters.size(); index++)
+	{
+		const Parameter &parameter = parameters[index];
+		const std::size_t length = std::min<std::size_t>(std::strlen(parameter.name), 64);
+		if (output + 4 + length > end) break;
+		store16(output, parameter.id);
+		*output++ = uint8_t(parameter.type) | (parameter.writable ? 0x80 : 0);
+		*output++ = uint8_t(length);
+		output = std::copy_n(parameter.name, length, output);
+	}
+	store16(position, index < parameters.size() ? uint16_t(index) : 0xffff);
+	return Status::Ok;
+}
+
+ParameterServer::Status
+ParameterServer::get(std::span<const uint8_t> payload, uint8_t *&output)
+{
+	if (payload.size() % 2) return Status::Malformed;
+	const uint8_t *const end = frame + MaxFrameSize - 2;
+	uint8_t *const start = output;
+
+	modm::atomic::Lock lock;
+	for (std::size_t ii = 0; ii < payload.size(); ii += 2)
+	{
+		const uint16_t id = load16(payload.data() + ii);
+		const Parameter *parameter = find(id);
+		Status status = Status::Ok;
+		if (parameter == nullptr) status = Status::UnknownParameter;
+		else if (output + 3 + parameter->size() > end) status = Status::Overflow;
+		if (status != Status::Ok)
+		{
+			output = start;
+			store16(output, id);
+			return status;
+		}
+		store16(output, id);
+		*output++ = uint8_t(parameter->type);
+		output = std::copy_n(static_cast<const uint8_t*>(parameter->value), parameter->size(), output);
+	}
+	return Status::Ok;
+}
+
+ParameterServer::Status
+ParameterServer::set(std::span<const uint8_t> payload, uint8_t *&output)
+{
+	// check the complete request before writing anything
+	for (std::size_t ii = 0; ii < payload.size(); )
+	{
+		if (payload.size() - ii < 3) return Status::Malformed;
+		const uint16_t id = load16(payload.data() + ii);
+		const Parameter *parameter = find(id);
+		Status status = Status::Ok;
+		if (parameter == nullptr) status = Status::UnknownParameter;
+		else if (uint8_t(parameter->type) != payload[ii + 2]) status = Status::TypeMismatch;
+		else if (not parameter->writable) status = Status::ReadOnly;
+		else if (payload.size() - ii - 3 < parameter->size()) status = Status::Malformed;
+		if (status != Status::Ok)
+		{
+			store16(output, id);
+			return status;
+		}
+		ii += 3 + parameter->size();
+	}
+
+	modm::atomic::Lock lock;
+	for (std::size_t ii = 0; ii < payload.size(); )
+	{
+		const Parameter *parameter = find(load16(payload.data() + ii));
+		const uint8_t *value = payload.data() + ii + 3;
+		if (parameter->type == ParameterType::Bool)
+			*static_cast<bool*>(parameter->value) = *value;
+		else
+			std::memcpy(parameter->value, value, parameter->size());
+		ii += 3 + parameter->size();
+	}
+	return Status::Ok;
+}
+
+ParameterServer::Status
+ParameterServer::schema(std::span<const uint8_t> payload, uint8_t *&output)
+{
+	if (snapshot == nullptr) return Status::UnknownCommand;
+	if (payload.size() != 2) return Status::Malformed;
+	const auto fields = snapshot->getFields();
+	std::size_t index = load16(payload.data());
+	const uint8_t *const end = frame + MaxFrameSize - 2;
+	*output++ = Snapshot::Version;
+	store16(output, snapshot->getSchemaId());
+	uint8_t *position = output;
+	output += 2;
+
+	for (; index < fields.size(); index++)
+	{
+		const SnapshotField &field = fields[index];
+		const std::size_t length = std::min<std::size_t>(std::strlen(field.name), 64);
+		if (output + 4 + length > end) break;
+		*output++ = uint8_t(field.type);
+		store16(output, field.count);
+		*output++ = uint8_t(length);
+		output = std::copy_n(field.name, length, output);
+	}
+	store16(position, index < fields.size() ? uint16_t(index) : 0xffff);
+	return Status::Ok;
+}
+
+ParameterServer::Status
+ParameterServer::logZone(std::span<const uint8_t> payload)
+{
+	if (payload.empty() or payload[0] > modm::log::DISABLED) return Status::Malformed;
+	const std::string_view name(reinterpret_cast<const char*>(payload.data() + 1), payload.size() - 1);
+	return modm::log::Zone::setLevel(name, modm::log::Level(payload[0])) ?
+			Status::Ok : Status::UnknownParameter;
+}
+
+const Parameter*
+ParameterServer::find(uint16_t id) const
+{
+	for (const Parameter &parameter : parameters)
+		if (parameter.id == id) return &parameter;
+	return nullptr;
+}
+
+} // namespace modm::telemetry
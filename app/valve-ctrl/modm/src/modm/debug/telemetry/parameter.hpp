@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_TELEMETRY_PARAMETER_HPP
+#define MODM_TELEMETRY_PARAMETER_HPP
+
+#include <cstddef>
+#include <span>
+#include <stdint.h>
+#include <type_traits>
+
+#include "parameter_type.hpp"
+#include "snapshot.hpp"
+
+namespace modm::telemetry
+{
+
+/**
+ * Entry of a parameter table.
+ *
+ * The type is deduced from the referenced variable, `const` variables are
+ * read-only.
+ *
+ * @code
+ * float kp{0.5f};
+ * const uint16_t firmware{3};
+ *
+ * constexpr modm::telemetry::Parameter parameters[] = {
+ *     {1, "current.kp", kp},
+ *     {2, "firmware", firmware},
+ * };
+ * @endcode
+ *
+ * @ingroup modm_debug
+ */
+struct Parameter
+{
+	template< typename T >
+	constexpr
+	Parameter(uint16_t id, const char *name, T &value) :
+		value(const_cast<std::remove_const_t<T>*>(&value)), name(name), id(id),
+		type(parameterTypeOf<std::remove_const_t<T>>()), writable(not std::is_const_v<T>)
+	{}
+
+	/// Size of the value in bytes.
+	constexpr std::size_t
+	size() const
+	{ return sizeOf(type); }
+
+	void *value;
+	const char *name;
+	uint16_t id;
+	ParameterType type;
+	bool writable;
+};
+
+/**
+ * Binary request/response protocol to read and write a parameter table.
+ *
+ * Every frame is COBS encoded and terminated by a zero byte. The decoded
+ * frame contains the command, a sequence number that is echoed in the
+ * response, the payload and a little-endian CRC-16/CCITT of all previous
+ * bytes (`modm::math::crc16_ccitt` with the initial value 0xffff). Multi-byte
+ * values are little-endian. A response has the command with bit 7 set, the
+ * sequence number, a `Status` byte and the payload:
+ *
+ * | Command   | Request payload               | Response payload                        |
+ * |-----------|-------------------------------|-----------------------------------------|
+ * | `List`    | u16 first table index         | u16 next index or 0xffff, then entries of u16 id, u8 type (bit 7: writable), u8 name length, name |
+ * | `Get`     | u16 ids                       | u16 id, u8 type, value for each id      |
+ * | `Set`     | u16 id, u8 type, value, ...   | nothing                                 |
+ * | `Snapshot`| nothing                       | record of all `Snapshot` fields         |
+ * | `Schema`  | u16 first field index         | u8 version, u16 schema id, u16 next index or 0xffff, then entries of u8 type, u16 count, u8 name length, name |
+ * | `LogZone` | u8 level, zone name or `*`    | nothing                                 |
+ *
+ * A `Set` request is checked completely before any value is written, and all
+ * values are written with interrupts disabled, so a table of related
+ * parameters, e.g. controller gains, changes consistently. On errors the
+ * response payload contains the offending parameter id.
+ *
+ * The optional `Snapshot` returns the complete controller state in a single
+ * response, which is streamed directly to the device and may be larger than
+ * `MaxFrameSize`, see `Snapshot` for the record format.
+ *
+ * Received bytes are read in bulk directly into the frame buffer, where
+ * they are COBS decoded and parsed in place. Values are copied once, from
+ * the frame into the parameter. Call `update()` periodically, e.g. in a
+ * fiber. The `modm_tools.parameter` module is the matching host client.
+ *
+ * @code
+ * modm::platform::Rtt rtt_command(2);
+ * modm::telemetry::ParameterServer parameter_server(parameters);
+ *
+ * modm::Fiber<> command_fiber([]
+ * {
+ *     while (true) { parameter_server.update(rtt_command); modm::this_fiber::sleep_for(10ms); }
+ * });
+ * @endcode
+ *
+ * @ingroup modm_debug
+ */
+class ParameterServer
+{
+public:
+	/// Largest decoded frame including the header and the CRC.
+	static constexpr std::size_t MaxFrameSize = 256;
+
+	enum class
+	Command : uint8_t
+	{
+		List = 0x01,
+		Get = 0x02,
+		Set = 0x03,
+		Snapshot = 0x04,
+		Schema = 0x05,
+		LogZone = 0x10,
+	};
+
+	enum class
+	Status : uint8_t
+	{
+		Ok = 0,
+		UnknownCommand = 1,
+		UnknownParameter = 2,
+		TypeMismatch = 3,
+		ReadOnly = 4,
+		Malformed = 5,
+		Overflow = 6,
+	};
+
+	ParameterServer(std::span<const Parameter> parameters, const Snapshot *snapshot = nullptr) :
+		parameters(parameters), snapshot(snapshot)
+	{}
+
+	/**
+	 * Reads all available bytes from the device, handles complete requests
+	 * and writes their responses back to the device.
+	 *
+	 * If the device does not accept a complete response, the rest is kept
+	 * and written first on the next call, before any further request is
+	 * handled. A device buffer of `EncodedSize` bytes takes any response at
+	 * once.
+	 *
+	 * @tparam	Device	class with `std::size_t read(uint8_t*, std::size_t)` and
+	 * 					`std::size_t write(const uint8_t*, std::size_t)`, e.g.
+	 * 					`modm::platform::Rtt` or a UART.
+	 */
+	template< class Device >
+	void
+	update(Device &device)
+	{
+		if (not send(device)) return;
+		while (true)
+		{
+			while (next(pending))
+				if (not send(device)) return;
+			const std::size_t length = device.read(rx + rx_size, sizeof(rx) - rx_size);
+			if (length == 0) break;
+			rx_size += length;
+		}
+	}
+
+	/// Largest COBS encoded frame including the delimiter.
+	static constexpr std::size_t EncodedSize = MaxFrameSize + MaxFrameSize / 254 + 2;
+
+private:
+	/// Writes the pending response and then a requested snapshot.
+	/// @return	`false` if the device did not accept the complete response.
+	template< class Device >
+	bool
+	send(Device &device)
+	{
+		if (not pending.empty())
+		{
+			pending = pending.subspan(device.write(pending.data(), pending.size()));
+			if (not pending.empty()) return false;
+		}
+		if (snapshot_requested)
+		{
+			snapshot_requested = false;
+			snapshot->write(device, snapshot_sequence);
+		}
+		return true;
+	}
+
+	/// Handles the next complete request in the receive buffer.
+	/// @return	`false` if there is none.
+	bool
+	next(std::span<const uint8_t> &response);
+
+	std::size_t
+	handle(std::span<const uint8_t> request);
+
+	Status
+	list(std::span<const uint8_t> payload, uint8_t *&output);
+
+	Status
+	get(std::span<const uint8_t> payload, uint8_t *&output);
+
+	Status
+	set(std::span<const uint8_t> payload, uint8_t *&output);
+
+	Status
+	schema(std::span<const uint8_t> payload, uint8_t *&output);
+
+	Status
+	logZone(std::span<const uint8_t> payload);
+
+	const Parameter*
+	find(uint16_t id) const;
+
+	static_assert(Snapshot::Response == (uint8_t(Command::Snapshot) | 0x80));
+
+	std::span<const Parameter> parameters;
+	const Snapshot *snapshot;
+	uint8_t rx[EncodedSize];
+	uint8_t frame[MaxFrameSize];
+	uint8_t tx[EncodedSize];
+	/// part of the response in `tx` that the device has not accepted yet
+	std::span<const uint8_t> pending;
+	std::size_t rx_size{0};
+	std::size_t scanned{0};
+	bool discard{false};
+	bool snapshot_requested{false};
+	uint8_t snapshot_sequence;
+};
+
+} // namespace modm::telemetry
+
+#endif // MODM_TELEMETRY_PARAMETER_HPP
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_TELEMETRY_PARAMETER_TYPE_HPP
+#define MODM_TELEMETRY_PARAMETER_TYPE_HPP
+
+#include <cstddef>
+#include <stdint.h>
+#include <type_traits>
+
+namespace modm::telemetry
+{
+
+/// Wire type of a parameter value.
+/// @ingroup modm_debug
+enum class
+ParameterType : uint8_t
+{
+	Bool,
+	Uint8,
+	Int8,
+	Uint16,
+	Int16,
+	Uint32,
+	Int32,
+	Float,
+};
+
+/// Size of a value in bytes.
+/// @ingroup modm_debug
+constexpr std::size_t
+sizeOf(ParameterType type)
+{
+	switch (type)
+	{
+		case ParameterType::Bool:
+		case ParameterType::Uint8:
+		case ParameterType::Int8:
+			return 1;
+		case ParameterType::Uint16:
+		case ParameterType::Int16:
+			return 2;
+		default:
+			return 4;
+	}
+}
+
+/// Wire type of a C++ type.
+/// @ingroup modm_debug
+template< typename T >
+consteval ParameterType
+parameterTypeOf()
+{
+	if constexpr (std::is_same_v<T, bool>) return ParameterType::Bool;
+	else if constexpr (std::is_same_v<T, uint8_t>) return ParameterType::Uint8;
+	else if constexpr (std::is_same_v<T, int8_t>) return ParameterType::Int8;
+	else if constexpr (std::is_same_v<T, uint16_t>) return ParameterType::Uint16;
+	else if constexpr (std::is_same_v<T, int16_t>) return ParameterType::Int16;
+	else if constexpr (std::is_same_v<T, uint32_t>) return ParameterType::Uint32;
+	else if constexpr (std::is_same_v<T, int32_t>) return ParameterType::Int32;
+	else if constexpr (std::is_same_v<T, float>) return ParameterType::Float;
+	else static_assert(std::is_same_v<T, float>, "Unsupported parameter type!");
+}
+
+} // namespace modm::telemetry
+
+#endif // MODM_TELEMETRY_PARAMETER_TYPE_HPP
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_TELEMETRY_SAMPLE_STREAM_HPP
+#define MODM_TELEMETRY_SAMPLE_STREAM_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <stdint.h>
+
+namespace modm::telemetry
+{
+
+/**
+ * Compressed stream of ADC samples.
+ *
+ * Encodes blocks of interleaved 16-bit samples, e.g. the halves of an ADC DMA
+ * buffer, into self-contained frames. Every channel is delta encoded against
+ * its previous sample and the deltas are zigzag encoded, so that the slowly
+ * changing values of a 12-bit ADC mostly fit into one byte. Each frame uses
+ * the smaller of two encodings:
+ *
+ * - varint: 7 bits per byte, best for mostly small deltas with outliers,
+ * - bit-packed: all deltas with the bit width of the largest one.
+ *
+ * The cost is two passes over the block and a fixed worst case frame size,
+ * so the encoder may run in the DMA half-transfer interrupt. Frames are COBS
+ * encoded and enclosed in zero bytes. A frame that is truncated by a full
+ * output buffer is detected and dropped by the decoder, the sequence number
+ * reveals the gap.
+ *
+ * The frame contains:
+ *
+ * - the sequence number, the number of channels and the encoding as bytes:
+ *   0 for varint or 0x80 plus the bit width for bit-packed,
+ * - the number of samples as varint,
+ * - the first sample of every channel as varint,
+ * - the zigzag encoded deltas of the remaining samples,
+ * - a checksum that makes the sum of all frame bytes zero.
+ *
+ * The `modm_tools.sample_stream` decoder converts the stream to CSV or NumPy.
+ *
+ * @code
+ * modm::platform::Rtt rtt_telemetry(1);
+ * modm::telemetry::SampleStream<2, 128> current_stream;
+ *
+ * // DMA half and full transfer interrupt
+ * const auto frame = current_stream.encode(std::span{adc_buffer}.subspan(offset, 128));
+ * rtt_telemetry.write(frame.data(), frame.size());
+ * @endcode
+ *
+ * @tparam	Channels	number of interleaved channels
+ * @tparam	MaxSamples	maximum number of samples per block over all channels
+ *
+ * @ingroup modm_debug
+ */
+template< std::size_t Channels, std::size_t MaxSamples >
+class SampleStream
+{
+	static_assert(Channels >= 1 and Channels < 256, "SampleStream supports 1 to 255 channels!");
+	static_assert(MaxSamples >= Channels and MaxSamples % Channels == 0,
+				  "The block size must be a multiple of the number of channels!");
+
+	// header, count, first samples, bit-packed 17-bit deltas and checksum
+	static constexpr std::size_t MaxRawSize = 3 + 3 + Channels * 3 +
+			((MaxSamples - Channels) * 17 + 7) / 8 + 1;
+
+public:
+	/// Largest encoded frame including the COBS overhead and both delimiters.
+	static constexpr std::size_t MaxFrameSize = MaxRawSize + MaxRawSize / 254 + 3;
+
+	/**
+	 * Encodes a block of interleaved samples into a frame.
+	 *
+	 * Samples beyond `MaxSamples` and an incomplete last sample set are
+	 * ignored. The first sample set of each block is sent verbatim, so that
+	 * every frame can be decoded independently.
+	 *
+	 * @return	encoded frame, valid until the next call.
+	 */
+	std::span<const uint8_t>
+	encode(std::span<const uint16_t> samples)
+	{
+		std::size_t count = std::min(samples.size(), MaxSamples);
+		count -= count % Channels;
+		samples = samples.first(count);
+
+		// first pass: size of both encodings
+		std::size_t varint_size = 0;
+		uint32_t bits = 0;
+		for (std::size_t ii = Channels; ii < count; ii++)
+		{
+			const uint32_t value = delta(samples, ii);
+			varint_size += varintSize(value);
+			bits |= value;
+		}
+		const uint8_t width = std::bit_width(bits);
+		const bool packed = ((count - Channels) * width + 7) / 8 < varint_size;
+
+		// second pass: encode the frame
+		Writer writer{frame};
+		writer.put(sequence++);
+		writer.put(Channels);
+		writer.put(packed ? 0x80 | width : 0);
+		writer.varint(count);
+		for (std::size_t ii = 0; ii < Channels and ii < count; ii++)
+			writer.varint(samples[ii]);
+		if (packed)
+		{
+			uint32_t accumulator = 0;
+			uint8_t filled = 0;
+			for (std::size_t ii = Channels; ii < count; ii++)
+			{
+				accumulator |= delta(samples, ii) << filled;
+				filled += width;
+				while (filled >= 8)
+				{
+					writer.put(accumulator);
+					accumulator >>= 8;
+					filled -= 8;
+				}
+			}
+			if (filled) writer.put(accumulator);
+		}
+		else
+		{
+			for (std::size_t ii = Channels; ii < count; ii++)
+				writer.varint(delta(samples, ii));
+		}
+		return writer.finish();
+	}
+
+	/// Number of encoded frames, modulo 256.
+	uint8_t
+	getSequence() const
+	{ return sequence; }
+
+private:
+	static uint32_t
+	delta(std::span<const uint16_t> samples, std::size_t index)
+	{
+		const int32_t value = int32_t(samples[index]) - int32_t(samples[index - Channels]);
+		return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+	}
+
+	static constexpr std::size_t
+	varintSize(uint32_t value)
+	{ return value < (1u << 7) ? 1 : (value < (1u << 14) ? 2 : 3); }
+
+	/// Writes the COBS encoded frame with a running checksum.
+	class Writer
+	{
+	public:
+		Writer(uint8_t *buffer) :
+			buffer(buffer)
+		{ buffer[0] = 0; }
+
+		void
+		put(uint8_t byte)
+		{
+			checksum += byte;
+			encode(byte);
+		}
+
+		void
+		varint(uint32_t value)
+		{
+			while (value >= 0x80)
+			{
+				put(uint8_t(value) | 0x80);
+				value >>= 7;
+			}
+			put(value);
+		}
+
+		std::span<const uint8_t>
+		finish()
+		{
+			encode(-checksum);
+			buffer[code] = run + 1;
+			buffer[size++] = 0;
+			return {buffer, size};
+		}
+
+	private:
+		void
+		encode(uint8_t byte)
+		{
+			if (byte) { buffer[size++] = byte; run++; }
+			if (not byte or run == 0xfe)
+			{
+				buffer[code] = run + 1;
+				code = size++;
+				run = 0;
+			}
+		}
+
+		uint8_t *const buffer;
+		// the leading zero terminates a previously truncated frame
+		std::size_t code{1};
+		std::size_t size{2};
+		uint8_t run{0};
+		uint8_t checksum{0};
+	};
+
+	uint8_t frame[MaxFrameSize];
+	uint8_t sequence{0};
+};
+
+} // namespace modm::telemetry
+
+#endif // MODM_TELEMETRY_SAMPLE_STREAM_HPP
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#include "snapshot.hpp"
+
+namespace modm::telemetry
+{
+
+Snapshot::Snapshot(std::span<const SnapshotField> fields) :
+	fields(fields)
+{
+	uint16_t crc = modm::math::crc16_ccitt_init;
+	for (const SnapshotField &field : fields)
+	{
+		value_size += field.size();
+		crc = modm::math::crc16_ccitt_update(crc, uint8_t(field.type));
+		crc = modm::math::crc16_ccitt_update(crc, uint8_t(field.count));
+		crc = modm::math::crc16_ccitt_update(crc, uint8_t(field.count >> 8));
+		for (const char *c = field.name; *c; c++)
+			crc = modm::math::crc16_ccitt_update(crc, uint8_t(*c));
+	}
+	schema_id = crc;
+}
+
+} // namespace modm::telemetry
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_TELEMETRY_SNAPSHOT_HPP
+#define MODM_TELEMETRY_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdint.h>
+#include <type_traits>
+
+#include <modm/architecture/interface/atomic_lock.hpp>
+#include <modm/architecture/interface/clock.hpp>
+#include <modm/architecture/interface/fiber.hpp>
+#include <modm/math/utils/crc.hpp>
+
+#include "parameter_type.hpp"
+
+namespace modm::telemetry
+{
+
+/**
+ * Entry of a snapshot schema: a scalar or an array of the controller state.
+ *
+ * Type and element count are deduced from the referenced variable, so the
+ * field list of a struct of arrays is checked at compile time and cannot get
+ * out of sync with the storage.
+ *
+ * @ingroup modm_debug
+ */
+struct SnapshotField
+{
+	template< typename T, std::size_t N >
+	constexpr
+	SnapshotField(const char *name, const T (&values)[N]) :
+		data(values), name(name), count(N), type(parameterTypeOf<T>())
+	{ static_assert(N <= 0xffff, "Snapshot fields are limited to 65535 elements!"); }
+
+	template< typename T, std::size_t N >
+	constexpr
+	SnapshotField(const char *name, const std::array<T, N> &values) :
+		data(values.data()), name(name), count(N), type(parameterTypeOf<T>())
+	{ static_assert(N <= 0xffff, "Snapshot fields are limited to 65535 elements!"); }
+
+	template< typename T > requires std::is_arithmetic_v<T>
+	constexpr
+	SnapshotField(const char *name, const T &value) :
+		data(&value), name(name), count(1), type(parameterTypeOf<T>())
+	{}
+
+	/// Size of the values in bytes.
+	constexpr std::size_t
+	size() const
+	{ return count * sizeOf(type); }
+
+	const void *data;
+	const char *name;
+	uint16_t count;
+	ParameterType type;
+};
+
+/**
+ * Binary record of the complete controller state described by a schema.
+ *
+ * The schema is the list of fields with their type, element count and name.
+ * Its CRC-16 is the schema id, which is sent with every record, so a host
+ * detects a firmware with a different state layout and fetches the schema
+ * again. The record format itself is versioned by `Version`.
+ *
+ * A record is a `ParameterServer` response frame of the `Snapshot` command:
+ *
+ * | Offset | Content                                           |
+ * |--------|---------------------------------------------------|
+ * | 0      | `Snapshot` command with bit 7 set, sequence, status |
+ * | 3      | u8 version, u16 schema id, u32 `modm::Clock` time in ms |
+ * | 10     | values of all fields in schema order, little-endian |
+ * | end    | u16 CRC-16/CCITT                                    |
+ *
+ * The values are streamed from the storage through the COBS encoder into the
+ * device, there is no record buffer. The fields are copied in chunks of
+ * `ChunkSize` bytes with interrupts disabled, so a field of up to `ChunkSize`
+ * bytes that is updated by interrupts is consistent, larger arrays are
+ * consistent per chunk. The device is only written with interrupts enabled.
+ * When the device buffer is full, the writer yields until the host has read
+ * enough, since a truncated frame would fail the CRC. A device buffer of
+ * `encodedSize()` bytes takes the record without waiting.
+ *
+ * @code
+ * struct Zones
+ * {
+ *     float setpoint[8];
+ *     float temperature[8];
+ *     uint8_t valve[8];
+ *     float integrator[8];
+ *     uint16_t faults[8];
+ * } zones;
+ *
+ * constexpr modm::telemetry::SnapshotField state[] = {
+ *     {"zone.setpoint", zones.setpoint},
+ *     {"zone.temperature", zones.temperature},
+ *     {"zone.valve", zones.valve},
+ *     {"zone.integrator", zones.integrator},
+ *     {"zone.faults", zones.faults},
+ * };
+ * modm::telemetry::Snapshot snapshot(state);
+ * modm::telemetry::ParameterServer parameter_server(parameters, &snapshot);
+ * @endcode
+ *
+ * @ingroup modm_debug
+ */
+class Snapshot
+{
+public:
+	/// Version of the record format.
+	static constexpr uint8_t Version = 1;
+	/// Size of the record header after the response header.
+	static constexpr std::size_t HeaderSize = 7;
+	/// `ParameterServer::Command::Snapshot` with bit 7 set.
+	static constexpr uint8_t Response = 0x84;
+	/// Bytes of a field copied at once with interrupts disabled.
+	static constexpr std::size_t ChunkSize = 64;
+
+	Snapshot(std::span<const SnapshotField> fields);
+
+	std::span<const SnapshotField>
+	getFields() const
+	{ return fields; }
+
+	/// CRC-16 of the types, counts and names of all fields.
+	uint16_t
+	getSchemaId() const
+	{ return schema_id; }
+
+	/// Size of all values in bytes.
+	std::size_t
+	getValueSize() const
+	{ return value_size; }
+
+	/// Worst case size of a COBS encoded record frame.
+	std::size_t
+	encodedSize() const
+	{
+		const std::size_t size = 3 + HeaderSize + value_size + 2;
+		return size + size / 254 + 2;
+	}
+
+	/**
+	 * Writes one record frame to the device.
+	 *
+	 * Call it from a fiber, it yields while the device buffer is full.
+	 *
+	 * @param	sequence	sequence number of the request, 0 for unsolicited records.
+	 */
+	template< class Device >
+	void
+	write(Device &device, uint8_t sequence = 0) const;
+
+private:
+	std::span<const SnapshotField> fields;
+	std::size_t value_size{0};
+	uint16_t schema_id;
+};
+
+/// @cond
+namespace snapshot_detail
+{
+
+/// COBS encoder with CRC that writes to the device in blocks of 254 bytes.
+template< class Device >
+class FrameWriter
+{
+public:
+	FrameWriter(Device &device) :
+		device(device)
+	{}
+
+	void
+	put(const uint8_t *data, std::size_t length)
+	{
+		while (length--)
+		{
+			crc = modm::math::crc16_ccitt_update(crc, *data);
+			push(*data++);
+		}
+	}
+
+	void
+	finish()
+	{
+		const uint16_t value = crc;
+		push(uint8_t(value));
+		push(uint8_t(value >> 8));
+		flush();
+		static constexpr uint8_t delimiter = 0;
+		write(&delimiter, 1);
+	}
+
+private:
+	void
+	push(uint8_t byte)
+	{
+		if (byte) block[size++] = byte;
+		if (not byte or size == 0xff) flush();
+	}
+
+	void
+	flush()
+	{
+		block[0] = size;
+		write(block, size);
+		size = 1;
+	}
+
+	/// Yields until the device has accepted all bytes, a partial frame fails the CRC.
+	void
+	write(const uint8_t *data, std::size_t length)
+	{
+		while (true)
+		{
+			const std::size_t written = device.write(data, length);
+			data += written;
+			length -= written;
+			if (not length) break;
+			modm::this_fiber::yield();
+		}
+	}
+
+	Device &device;
+	uint16_t crc{modm::math::crc16_ccitt_init};
+	uint8_t size{1};
+	uint8_t block[255];
+};
+
+} // namespace snapshot_detail
+/// @endcond
+
+template< class Device >
+void
+Snapshot::write(Device &device, uint8_t sequence) const
+{
+	snapshot_detail::FrameWriter<Device> writer(device);
+	const uint32_t time = modm::Clock::now().time_since_epoch().count();
+	const uint8_t header[3 + HeaderSize] = {
+		Response, sequence, 0, Version,
+		uint8_t(schema_id), uint8_t(schema_id >> 8),
+		uint8_t(time), uint8_t(time >> 8), uint8_t(time >> 16), uint8_t(time >> 24)};
+	writer.put(header, sizeof(header));
+	// the writer may yield, so it must not be called with interrupts disabled
+	uint8_t chunk[ChunkSize];
+	for (const SnapshotField &field : fields)
+	{
+		const uint8_t *data = static_cast<const uint8_t*>(field.data);
+		for (std::size_t offset = 0, size = field.size(); offset < size; )
+		{
+			const std::size_t length = std::min(ChunkSize, size - offset);
+			{
+				modm::atomic::Lock lock;
+				std::memcpy(chunk, data + offset, length);
+			}
+			writer.put(chunk, length);
+			offset += length;
+		}
+	}
+	writer.finish();
+}
+
+} // namespace modm::telemetry
+
+#endif // MODM_TELEMETRY_SNAPSHOT_HPP
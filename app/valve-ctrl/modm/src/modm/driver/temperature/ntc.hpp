@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_NTC_HPP
+#define MODM_NTC_HPP
+
+#include <array>
+#include <cstddef>
+#include <stdint.h>
+#include <bit>
+
+namespace modm
+{
+
+/// @ingroup modm_driver_ntc
+struct ntc
+{
+	/// Position of the NTC in the voltage divider
+	enum class
+	Divider : uint8_t
+	{
+		LowSide,	///< NTC between ADC input and ground, series resistor to reference
+		HighSide,	///< NTC between reference and ADC input, series resistor to ground
+	};
+
+	enum class
+	Interpolation : uint8_t
+	{
+		Linear,		///< (Segments + 1) nodes, one multiply-add per conversion
+		Cubic,		///< Segments * 4 coefficients, three multiply-adds per conversion
+	};
+
+	/// Natural logarithm usable at compile time.
+	static constexpr double
+	log(double x)
+	{
+		// reduce to [1, 2], the scaling by two is exact
+		int exponent = 0;
+		while (x >= 2.0) { x /= 2.0; exponent++; }
+		while (x < 1.0) { x *= 2.0; exponent--; }
+		// ln(x) = 2 atanh(y) with y = (x-1)/(x+1) in [0, 1/3]
+		const double y = (x - 1.0) / (x + 1.0);
+		const double y2 = y * y;
+		double term = y, sum = 0.0;
+		for (int n = 1; n < 64; n += 2, term *= y2) sum += term / n;
+		return 2.0 * sum + exponent * 0.6931471805599453094;
+	}
+
+	/// NTC described by its nominal resistance and B-value.
+	struct Beta
+	{
+		double resistance;			///< Resistance at the nominal temperature in Ohm
+		double beta;				///< B-value in Kelvin
+		double temperature{25.0};	///< Nominal temperature in °C
+
+		constexpr double
+		celsius(double r) const
+		{
+			return 1.0 / (1.0 / (temperature + 273.15) + log(r / resistance) / beta) - 273.15;
+		}
+	};
+
+	/// NTC described by the Steinhart-Hart coefficients.
+	struct SteinhartHart
+	{
+		double a;
+		double b;
+		double c;
+
+		constexpr double
+		celsius(double r) const
+		{
+			const double l = log(r);
+			return 1.0 / (a + b * l + c * l * l * l) - 273.15;
+		}
+	};
+
+	struct Point
+	{
+		double temperature;	///< in °C
+		double resistance;	///< in Ohm
+	};
+
+	/**
+	 * NTC described by the R/T curve of the datasheet.
+	 *
+	 * The points must be sorted by ascending temperature. Between points
+	 * `1/T` is interpolated linearly over `ln(R)`, which is exact for a B-value
+	 * model and the curve is extrapolated beyond the first and last point.
+	 */
+	template< std::size_t N >
+	struct Curve
+	{
+		static_assert(N >= 2, "The R/T curve needs at least two points!");
+		std::array<Point, N> points;
+
+		constexpr double
+		celsius(double r) const
+		{
+			const double l = log(r);
+			std::size_t ii = 1;
+			while (ii < N - 1 and r < points[ii].resistance) ii++;
+			const double l0 = log(points[ii - 1].resistance);
+			const double l1 = log(points[ii].resistance);
+			const double i0 = 1.0 / (points[ii - 1].temperature + 273.15);
+			const double i1 = 1.0 / (points[ii].temperature + 273.15);
+			return 1.0 / (i0 + (i1 - i0) * (l - l0) / (l1 - l0)) - 273.15;
+		}
+	};
+};
+
+/**
+ * NTC linearisation with a lookup table generated at compile time.
+ *
+ * The ADC range of `2^Resolution` counts is divided into `Segments` segments
+ * of equal width. At compile time the temperature at each node is computed
+ * from the NTC model and the voltage divider, so that at runtime the
+ * conversion is a table lookup plus interpolation without any `log()`.
+ *
+ * The ADC is assumed to be ratiometric to the divider supply, with
+ * `ratio = counts / 2^Resolution`. The extreme counts of the range are
+ * clamped to half a count, since the temperature diverges there.
+ *
+ * For a 10kOhm B3950 NTC with a 10kOhm series resistor on a 12-bit ADC the
+ * maximum error between -20°C and 100°C is:
+ *
+ * | Segments | Linear  | Cubic   |
+ * |----------|---------|---------|
+ * | 32       |         | 0.33 K  |
+ * | 64       | 0.26 K  | 0.032 K |
+ * | 128      | 0.074 K |         |
+ * | 256      | 0.017 K |         |
+ *
+ * The default of 64 segments with cubic interpolation stays within ±0.05 K
+ * with a table of 1 KiB. Linear interpolation needs 256 segments for that.
+ *
+ * @code
+ * using FloorNtc = modm::Ntc<modm::ntc::Beta{10'000, 3950}, 10'000.0, Adc1::Resolution>;
+ * const float celsius = FloorNtc::celsius(Adc1::getValue());
+ * @endcode
+ *
+ * @tparam	Model			ntc::Beta, ntc::SteinhartHart or ntc::Curve
+ * @tparam	SeriesResistance	resistance of the divider resistor in Ohm
+ * @tparam	Resolution		resolution of the ADC in bits, e.g. `Adc1::Resolution`
+ * @tparam	Segments		number of table segments, must be a power of two
+ *
+ * @ingroup modm_driver_ntc
+ */
+template< auto Model, double SeriesResistance, uint8_t Resolution,
+		  std::size_t Segments = 64,
+		  ntc::Interpolation Interpolation = ntc::Interpolation::Cubic,
+		  ntc::Divider Divider = ntc::Divider::LowSide >
+class Ntc
+{
+	static constexpr uint32_t Counts = 1ul << Resolution;
+	static_assert(std::has_single_bit(Segments), "Segments must be a power of two!");
+	static_assert(Segments >= 2 and Segments < Counts, "Segments must be smaller than the ADC range!");
+	static constexpr uint32_t Step = Counts / Segments;
+	static constexpr uint8_t Shift = std::countr_zero(Step);
+	static constexpr float InvStep = 1.f / Step;
+
+public:
+	/// Exact conversion from ADC counts to °C using the NTC model.
+	/// This is slow at runtime and meant for the table generation and testing.
+	static constexpr double
+	reference(double counts)
+	{
+		const double half = 0.5 / Counts;
+		double ratio = counts / Counts;
+		if (ratio < half) ratio = half;
+		if (ratio > 1.0 - half) ratio = 1.0 - half;
+		const double r = (Divider == ntc::Divider::LowSide) ?
+				SeriesResistance * ratio / (1.0 - ratio) :
+				SeriesResistance * (1.0 - ratio) / ratio;
+		return Model.celsius(r);
+	}
+
+	/// Converts ADC counts to °C with table lookup and interpolation.
+	static constexpr float
+	celsius(uint16_t counts)
+	{
+		if (counts >= Counts) counts = Counts - 1;
+		const uint32_t index = counts >> Shift;
+		const float fraction = float(counts & (Step - 1)) * InvStep;
+		if constexpr (Interpolation == ntc::Interpolation::Linear)
+		{
+			return table[index] + (table[index + 1] - table[index]) * fraction;
+		}
+		else
+		{
+			const auto &c = table[index];
+			return ((c[3] * fraction + c[2]) * fraction + c[1]) * fraction + c[0];
+		}
+	}
+
+private:
+	static constexpr auto
+	generate()
+	{
+		if constexpr (Interpolation == ntc::Interpolation::Linear)
+		{
+			std::array<float, Segments + 1> nodes{};
+			for (std::size_t ii = 0; ii <= Segments; ii++)
+				nodes[ii] = float(reference(double(ii * Step)));
+			return nodes;
+		}
+		else
+		{
+			// Catmull-Rom spline through the nodes, the outer nodes are
+			// extrapolated linearly.
+			std::array<double, Segments + 3> p{};
+			for (std::size_t ii = 0; ii <= Segments; ii++)
+				p[ii + 1] = reference(double(ii * Step));
+			p[0] = 2 * p[1] - p[2];
+			p[Segments + 2] = 2 * p[Segments + 1] - p[Segments];
+
+			std::array<std::array<float, 4>, Segments> coefficients{};
+			for (std::size_t ii = 0; ii < Segments; ii++)
+			{
+				const double p0 = p[ii], p1 = p[ii + 1], p2 = p[ii + 2], p3 = p[ii + 3];
+				coefficients[ii] = {
+					float(p1),
+					float(0.5 * (p2 - p0)),
+					float(0.5 * (2 * p0 - 5 * p1 + 4 * p2 - p3)),
+					float(0.5 * (3 * (p1 - p2) + p3 - p0)),
+				};
+			}
+			return coefficients;
+		}
+	}
+
+	static constexpr auto table = generate();
+};
+
+} // namespace modm
+
+#endif // MODM_NTC_HPP
@@ -14,6 +14,8 @@
 #ifndef MODM_IODEVICE_HPP
 #define MODM_IODEVICE_HPP
 
+#include <cstddef>
+
 namespace modm
 {
 
@@ -41,6 +43,13 @@ public:
 		while ( (c = *str++) ) write(c);
 	}
 
+	/// Write a block of characters, override this to copy the whole block at once
+	virtual inline void
+	write(const char* data, std::size_t length)
+	{
+		while (length--) write(*data++);
+	}
+
 	virtual void
 	flush() = 0;
 
@@ -16,6 +16,7 @@
 #define MODM_IODEVICE_WRAPPER_HPP
 
 #include <stdint.h>
+#include <cstring>
 
 #include "iodevice.hpp"
 
@@ -41,7 +42,6 @@ class IODeviceWrapper : public IODevice
 {
 public:
 	IODeviceWrapper() = default;
-	using IODevice::write;
 
 	void
 	write(char c) override
@@ -54,6 +54,25 @@ public:
 		while(behavior == IOBuffer::BlockIfFull and not written);
 	}
 
+	void
+	write(const char* str) override
+	{
+		write(str, std::strlen(str));
+	}
+
+	void
+	write(const char* data, std::size_t length) override
+	{
+		const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+		do
+		{
+			const std::size_t written = Device::write(ptr, length);
+			ptr += written;
+			length -= written;
+		}
+		while(behavior == IOBuffer::BlockIfFull and length);
+	}
+
 	void
 	flush() override
 	{
@@ -74,7 +93,6 @@ class IODeviceObjectWrapper : public IODevice
 	Device &device;
 public:
 	IODeviceObjectWrapper(Device& device) : device{device} {}
-	using IODevice::write;
 
 	void
 	write(char c) override
@@ -87,6 +105,25 @@ public:
 		while(behavior == IOBuffer::BlockIfFull and not written);
 	}
 
+	void
+	write(const char* str) override
+	{
+		write(str, std::strlen(str));
+	}
+
+	void
+	write(const char* data, std::size_t length) override
+	{
+		const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+		do
+		{
+			const std::size_t written = device.write(ptr, length);
+			ptr += written;
+			length -= written;
+		}
+		while(behavior == IOBuffer::BlockIfFull and length);
+	}
+
 	void
 	flush() override
 	{
@@ -70,6 +70,10 @@ public:
 	write(char c)
 	{ device->write(c); return *this; }
 
+	inline IOStream&
+	write(const char* data, size_t length)
+	{ device->write(data, length); return *this; }
+
 	static constexpr char eof = -1;
 
 	/// Reads one character and returns it if available. Otherwise, returns IOStream::eof.
@@ -237,8 +241,7 @@ protected:
 	void writeInteger(uint32_t value);
 	void writeInteger(int64_t value);
 	void writeInteger(uint64_t value);
-	inline void writeFloat(float value)
-	{ writeDouble(static_cast<double>(value)); }
+	void writeFloat(float value);
 	void writeDouble(const double& value);
 	void writePointer(const void* value);
 	void writeHex(uint8_t value);
@@ -261,7 +264,6 @@ private:
 	Mode mode = Mode::Ascii;
 	static void out_char(char c, void* arg)
 	{ if (c) reinterpret_cast<modm::IOStream*>(arg)->write(c); }
-	printf_output_gadget_t output_gadget{out_char, this, NULL, 0, INT_MAX};
 };
 
 /// @ingroup modm_io
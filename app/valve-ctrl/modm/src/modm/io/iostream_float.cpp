@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#include <bit>
+#include <iterator>
+#include <stdint.h>
+#include "iostream.hpp"
+
+// The float is formatted with integer arithmetic only, the output matches
+// the `%.5e` formatting of `writeDouble()`.
+
+namespace
+{
+
+constexpr int PowerMin = -34;
+
+// 10^k = power[k - PowerMin] * 2^(floor(k * log2(10)) - 63), rounded to
+// nearest, which is exact for 0 <= k <= 27.
+constexpr uint64_t power[] =
+{
+	0x84ec3c97da624ab5ull, 0xa6274bbdd0fadd62ull, 0xcfb11ead453994baull,
+	0x81ceb32c4b43fcf5ull, 0xa2425ff75e14fc32ull, 0xcad2f7f5359a3b3eull,
+	0xfd87b5f28300ca0eull, 0x9e74d1b791e07e48ull, 0xc612062576589ddbull,
+	0xf79687aed3eec551ull, 0x9abe14cd44753b53ull, 0xc16d9a0095928a27ull,
+	0xf1c90080baf72cb1ull, 0x971da05074da7befull, 0xbce5086492111aebull,
+	0xec1e4a7db69561a5ull, 0x9392ee8e921d5d07ull, 0xb877aa3236a4b449ull,
+	0xe69594bec44de15bull, 0x901d7cf73ab0acd9ull, 0xb424dc35095cd80full,
+	0xe12e13424bb40e13ull, 0x8cbccc096f5088ccull, 0xafebff0bcb24aaffull,
+	0xdbe6fecebdedd5bfull, 0x89705f4136b4a597ull, 0xabcc77118461cefdull,
+	0xd6bf94d5e57a42bcull, 0x8637bd05af6c69b6ull, 0xa7c5ac471b478423ull,
+	0xd1b71758e219652cull, 0x83126e978d4fdf3bull, 0xa3d70a3d70a3d70aull,
+	0xcccccccccccccccdull, 0x8000000000000000ull, 0xa000000000000000ull,
+	0xc800000000000000ull, 0xfa00000000000000ull, 0x9c40000000000000ull,
+	0xc350000000000000ull, 0xf424000000000000ull, 0x9896800000000000ull,
+	0xbebc200000000000ull, 0xee6b280000000000ull, 0x9502f90000000000ull,
+	0xba43b74000000000ull, 0xe8d4a51000000000ull, 0x9184e72a00000000ull,
+	0xb5e620f480000000ull, 0xe35fa931a0000000ull, 0x8e1bc9bf04000000ull,
+	0xb1a2bc2ec5000000ull, 0xde0b6b3a76400000ull, 0x8ac7230489e80000ull,
+	0xad78ebc5ac620000ull, 0xd8d726b7177a8000ull, 0x878678326eac9000ull,
+	0xa968163f0a57b400ull, 0xd3c21bcecceda100ull, 0x84595161401484a0ull,
+	0xa56fa5b99019a5c8ull, 0xcecb8f27f4200f3aull, 0x813f3978f8940984ull,
+	0xa18f07d736b90be5ull, 0xc9f2c9cd04674edfull, 0xfc6f7c4045812296ull,
+	0x9dc5ada82b70b59eull, 0xc5371912364ce305ull, 0xf684df56c3e01bc7ull,
+	0x9a130b963a6c115cull, 0xc097ce7bc90715b3ull, 0xf0bdc21abb48db20ull,
+	0x96769950b50d88f4ull, 0xbc143fa4e250eb31ull, 0xeb194f8e1ae525fdull,
+	0x92efd1b8d0cf37beull, 0xb7abc627050305aeull, 0xe596b7b0c643c719ull,
+	0x8f7e32ce7bea5c70ull, 0xb35dbf821ae4f38cull, 0xe0352f62a19e306full,
+	0x8c213d9da502de45ull, 0xaf298d050e4395d7ull, 0xdaf3f04651d47b4cull,
+	0x88d8762bf324cd10ull, 0xab0e93b6efee0054ull
+};
+
+constexpr uint64_t power10[] =
+{
+	1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+	100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+};
+
+/// Rounds m * 2^e2 * 10^k to the nearest integer, ties to even.
+uint32_t
+scale(uint32_t mantissa, int e2, int k)
+{
+	const uint64_t c = power[k - PowerMin];
+	const int e = ((k * 1741647) >> 19) - 63;	// floor(k * log2(10)) - 63
+	// 24x64 bit multiplication with two 32x32=64 bit multiplications
+	const uint64_t low = uint64_t(mantissa) * uint32_t(c);
+	const uint64_t product = uint64_t(mantissa) * uint32_t(c >> 32) + (low >> 32);
+	const int shift = -(e2 + e + 32);
+
+	const uint64_t result = product >> shift;
+	const uint64_t remainder = product & ((1ull << shift) - 1);
+	const uint64_t half = 1ull << (shift - 1);
+	bool up = (remainder > half) or (remainder == half and uint32_t(low));
+	if (remainder == half and not uint32_t(low) and k >= 0)
+	{
+		// exact tie, since the power of ten is exact
+		up = result & 1;
+	}
+	else if (k < 0 and -k < int(std::size(power10)) and e2 < 38)
+	{
+		// integers may be exact ties despite the inexact 10^-k
+		const int e = e2 + 1;
+		if (e >= 0 or (e > -24 and not (mantissa & ((1ul << -e) - 1))))
+		{
+			const uint64_t twice = (e >= 0) ? (uint64_t(mantissa) << e) : (mantissa >> -e);
+			if (twice == (2 * result + 1) * power10[-k]) up = result & 1;
+		}
+	}
+	return uint32_t(result) + up;
+}
+
+} // namespace
+
+namespace modm
+{
+
+void
+IOStream::writeFloat(float value)
+{
+	char buffer[16];
+	char *str = buffer;
+
+	const uint32_t bits = std::bit_cast<uint32_t>(value);
+	const uint32_t biased = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+	if (biased == 0xff and mantissa)
+	{
+		device->write("nan", 3);
+		return;
+	}
+	if (bits >> 31) *str++ = '-';
+	if (biased == 0xff)
+	{
+		*str++ = 'i'; *str++ = 'n'; *str++ = 'f';
+		device->write(buffer, str - buffer);
+		return;
+	}
+
+	uint32_t digits = 0;
+	int e10 = 0;
+	if (biased or mantissa)
+	{
+		int e2 = -149;
+		if (biased) {
+			mantissa |= 1ul << 23;
+			e2 = int(biased) - 150;
+		}
+		// floor(log10(2^E)) is the decimal exponent or one less
+		const int exponent = e2 + 31 - std::countl_zero(mantissa);
+		e10 = (exponent * 78913) >> 18;
+		digits = scale(mantissa, e2, 5 - e10);
+		if (digits >= 1'000'000) digits = scale(mantissa, e2, 5 - ++e10);
+	}
+
+	*str++ = '0' + digits / 100'000;
+	*str++ = '.';
+	for (char *fraction = str + 4; fraction >= str; fraction--, digits /= 10)
+		*fraction = '0' + digits % 10;
+	str += 5;
+
+	*str++ = 'e';
+	*str++ = (e10 < 0) ? '-' : '+';
+	if (e10 < 0) e10 = -e10;
+	*str++ = '0' + e10 / 10;
+	*str++ = '0' + e10 % 10;
+
+	device->write(buffer, str - buffer);
+}
+
+} // namespace modm
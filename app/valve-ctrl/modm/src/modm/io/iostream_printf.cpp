@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <modm/architecture/interface/accessor.hpp>
+#include <algorithm>
 #include <cmath>
 #include "iostream.hpp"
 
@@ -58,47 +59,76 @@ IOStream::vprintf(const char *fmt, va_list ap)
 	vfctprintf(&out_char, this, fmt, ap);
 	return *this;
 }
+namespace
+{
+// Formats into a small stack buffer first, so that the device can copy the
+// number as one block instead of one virtual call per character.
+template< typename Function >
+void
+writeBlock(IODevice& device, Function&& format)
+{
+	char buffer[32];
+	printf_output_gadget_t gadget{nullptr, nullptr, buffer, 0, sizeof(buffer)};
+	format(&gadget);
+	device.write(buffer, std::min<size_t>(gadget.pos, sizeof(buffer)));
+}
+}
+
 void
 IOStream::writeInteger(int16_t value)
 {
-	print_integer(&output_gadget, uint16_t(value < 0 ? -value : value),
-	              value < 0, 10, 0, 0, FLAGS_SHORT);
+	writeBlock(*device, [=](auto* gadget) {
+		print_integer(gadget, uint16_t(value < 0 ? -value : value),
+		              value < 0, 10, 0, 0, FLAGS_SHORT);
+	});
 }
 
 void
 IOStream::writeInteger(uint16_t value)
 {
-	print_integer(&output_gadget, value, false, 10, 0, 0, FLAGS_SHORT);
+	writeBlock(*device, [=](auto* gadget) {
+		print_integer(gadget, value, false, 10, 0, 0, FLAGS_SHORT);
+	});
 }
 
 void
 IOStream::writeInteger(int32_t value)
 {
-	print_integer(&output_gadget, uint32_t(value < 0 ? -value : value),
-	              value < 0, 10, 0, 0, FLAGS_LONG);
+	writeBlock(*device, [=](auto* gadget) {
+		print_integer(gadget, uint32_t(value < 0 ? -value : value),
+		              value < 0, 10, 0, 0, FLAGS_LONG);
+	});
 }
 
 void
 IOStream::writeInteger(uint32_t value)
 {
-	print_integer(&output_gadget, value, false, 10, 0, 0, FLAGS_LONG);
+	writeBlock(*device, [=](auto* gadget) {
+		print_integer(gadget, value, false, 10, 0, 0, FLAGS_LONG);
+	});
 }
 
 void
 IOStream::writeInteger(int64_t value)
 {
-	print_integer(&output_gadget, uint64_t(value < 0 ? -value : value),
-	              value < 0, 10, 0, 0, FLAGS_LONG_LONG);
+	writeBlock(*device, [=](auto* gadget) {
+		print_integer(gadget, uint64_t(value < 0 ? -value : value),
+		              value < 0, 10, 0, 0, FLAGS_LONG_LONG);
+	});
 }
 
 void
 IOStream::writeInteger(uint64_t value)
 {
-	print_integer(&output_gadget, value, false, 10, 0, 0, FLAGS_LONG_LONG);
+	writeBlock(*device, [=](auto* gadget) {
+		print_integer(gadget, value, false, 10, 0, 0, FLAGS_LONG_LONG);
+	});
 }
 void
 IOStream::writeDouble(const double& value)
 {
-	print_floating_point(&output_gadget, value, 0, 0, 0, true);
+	writeBlock(*device, [&](auto* gadget) {
+		print_floating_point(gadget, value, 0, 0, 0, true);
+	});
 }
 } // namespace modm
\ No newline at end of file
@@ -14,9 +14,13 @@
 
 #include "filter/debounce.hpp"
 #include "filter/fir.hpp"
+#include "filter/goertzel.hpp"
+#include "filter/kalman.hpp"
 #include "filter/median.hpp"
 #include "filter/moving_average.hpp"
 #include "filter/pid.hpp"
+#include "filter/pid_2dof.hpp"
 #include "filter/ramp.hpp"
 #include "filter/s_curve_controller.hpp"
 #include "filter/s_curve_generator.hpp"
+#include "filter/sliding_dft.hpp"
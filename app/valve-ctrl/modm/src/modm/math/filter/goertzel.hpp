@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_MATH_GOERTZEL_HPP
+#define MODM_MATH_GOERTZEL_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <stdint.h>
+#include <type_traits>
+
+namespace modm::math
+{
+
+/**
+ * Goertzel algorithm for the power of a small set of frequency bins.
+ *
+ * Every bin costs one multiply-add per sample, which is much cheaper than a
+ * full FFT when only a few frequencies are of interest. The bin frequencies
+ * can be chosen freely and do not need to be integer multiples of
+ * `1/BlockLength`.
+ *
+ * Samples can be fed one at a time or as a block. After `BlockLength`
+ * samples the power of each bin is latched and the next block starts.
+ *
+ * `T` may be `float` or `int32_t`. For `int32_t` the samples are Q31 values,
+ * the computation uses 32x32->64-bit multiplications only and the power is
+ * returned in Q31. The input is shifted right per bin to provide the headroom
+ * of the resonator, so `BlockLength` must be a power of two and very low bin
+ * frequencies lose resolution.
+ *
+ * @code
+ * // ADC at 20kHz, motor ripple expected between 400Hz and 1.2kHz
+ * modm::math::Goertzel<float, 5, 256> ripple({0.02f, 0.03f, 0.04f, 0.05f, 0.06f});
+ *
+ * if (ripple.update(std::span{adc_block})) {
+ *     const float frequency = ripple.getFrequency(ripple.getDominantBin()) * 20'000;
+ * }
+ * @endcode
+ *
+ * @tparam	T			`float` or `int32_t` (Q31)
+ * @tparam	Bins		number of frequency bins
+ * @tparam	BlockLength	number of samples per result
+ *
+ * @ingroup	modm_math_filter
+ */
+template< typename T, std::size_t Bins, std::size_t BlockLength >
+class Goertzel
+{
+	static constexpr bool Fixed = std::is_same_v<T, int32_t>;
+	static_assert(Fixed or std::is_floating_point_v<T>,
+				  "Goertzel only supports floating point or Q31 (int32_t) samples!");
+	static_assert(not Fixed or std::has_single_bit(BlockLength),
+				  "The Q31 Goertzel requires a power of two block length!");
+	static constexpr uint8_t BlockShift = std::countr_zero(BlockLength);
+
+	/// Q31: coefficient in Q30, since 2cos() is in [-2, 2]
+	using Coefficient = std::conditional_t<Fixed, int32_t, T>;
+
+public:
+	/// @param	frequencies	bin frequencies in cycles per sample (f/fs) in (0, 0.5)
+	explicit
+	Goertzel(const std::array<float, Bins> &frequencies)
+	: frequencies(frequencies)
+	{
+		for (std::size_t bin = 0; bin < Bins; bin++)
+		{
+			const float omega = 2.f * std::numbers::pi_v<float> * frequencies[bin];
+			if constexpr (Fixed)
+			{
+				// 2cos() rounds to exactly 2.0 for very low frequencies, which
+				// does not fit into Q30 and would wrap to -2.0
+				const int64_t q30 = std::llround(2.f * std::cos(omega) * (1ul << 30));
+				coefficient[bin] = int32_t(std::clamp<int64_t>(q30, INT32_MIN, INT32_MAX));
+				// the resonator gains up to BlockLength / sin(omega), plus two
+				// bits of margin for the power computation
+				const float gain = 1.f / std::abs(std::sin(omega));
+				shift[bin] = std::min<int>(31, BlockShift + int(std::ceil(std::log2(gain))) + 2);
+			}
+			else coefficient[bin] = T(2) * std::cos(T(omega));
+		}
+		reset();
+	}
+
+	/// Restarts the current block, the last results are kept.
+	void
+	reset()
+	{
+		state = {};
+		count = 0;
+	}
+
+	/// @return	`true` if a block was completed and new results are available.
+	bool
+	update(T sample)
+	{
+		for (std::size_t bin = 0; bin < Bins; bin++)
+			step(bin, state[bin][0], state[bin][1], sample);
+		return (++count == BlockLength) and finish();
+	}
+
+	/// @return	`true` if at least one block was completed.
+	bool
+	update(std::span<const T> samples)
+	{
+		bool completed = false;
+		while (not samples.empty())
+		{
+			const std::size_t chunk = std::min(samples.size(), BlockLength - count);
+			for (std::size_t bin = 0; bin < Bins; bin++)
+			{
+				// keep the resonator state in registers for the whole chunk
+				State s1 = state[bin][0], s2 = state[bin][1];
+				for (std::size_t ii = 0; ii < chunk; ii++)
+					step(bin, s1, s2, samples[ii]);
+				state[bin] = {s1, s2};
+			}
+			samples = samples.subspan(chunk);
+			count += chunk;
+			if (count == BlockLength) completed |= finish();
+		}
+		return completed;
+	}
+
+	/// Squared amplitude of the bin in the last completed block.
+	T
+	getPower(std::size_t bin) const
+	{ return power[bin]; }
+
+	/// Bin frequency in cycles per sample.
+	float
+	getFrequency(std::size_t bin) const
+	{ return frequencies[bin]; }
+
+	/// Index of the bin with the highest power in the last completed block.
+	std::size_t
+	getDominantBin() const
+	{
+		std::size_t dominant = 0;
+		for (std::size_t bin = 1; bin < Bins; bin++)
+			if (power[bin] > power[dominant]) dominant = bin;
+		return dominant;
+	}
+
+private:
+	using State = T;
+
+	inline void
+	step(std::size_t bin, State &s1, State &s2, T sample) const
+	{
+		if constexpr (Fixed)
+		{
+			const int32_t s0 = (sample >> shift[bin]) - s2 +
+					int32_t((int64_t(coefficient[bin]) * s1) >> 30);
+			s2 = s1; s1 = s0;
+		}
+		else
+		{
+			const T s0 = sample + coefficient[bin] * s1 - s2;
+			s2 = s1; s1 = s0;
+		}
+	}
+
+	bool
+	finish()
+	{
+		for (std::size_t bin = 0; bin < Bins; bin++)
+		{
+			const State s1 = state[bin][0], s2 = state[bin][1];
+			if constexpr (Fixed)
+			{
+				// |X|^2 in Q62 of the scaled input, then amplitude^2 = 4|X|^2/N^2
+				const int64_t cs1 = (int64_t(coefficient[bin]) * s1) >> 30;
+				const int64_t p = int64_t(s1) * s1 + int64_t(s2) * s2 - cs1 * s2;
+				const int exponent = 2 * (shift[bin] - BlockShift) + 2 - 31;
+				const int64_t q31 = (exponent >= 0) ? (p << exponent) : (p >> -exponent);
+				power[bin] = int32_t(std::min<int64_t>(q31, INT32_MAX));
+			}
+			else
+			{
+				const T p = s1 * s1 + s2 * s2 - coefficient[bin] * s1 * s2;
+				power[bin] = p * (T(4) / (T(BlockLength) * T(BlockLength)));
+			}
+		}
+		reset();
+		return true;
+	}
+
+	std::array<std::array<State, 2>, Bins> state;
+	std::array<Coefficient, Bins> coefficient;
+	std::array<uint8_t, Fixed ? Bins : 0> shift{};
+	std::array<T, Bins> power{};
+	std::array<float, Bins> frequencies;
+	std::size_t count;
+};
+
+} // namespace modm::math
+
+#endif // MODM_MATH_GOERTZEL_HPP
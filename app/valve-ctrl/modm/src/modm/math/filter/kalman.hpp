@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_FILTER_KALMAN_HPP
+#define MODM_FILTER_KALMAN_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+namespace modm::filter
+{
+
+/**
+ * Linear Kalman filter with fixed-size, heap-free matrices.
+ *
+ * The filter estimates `States` values from `Measurements` values using
+ *
+ * - the state transition `x = F x + u` with process noise covariance `Q`, and
+ * - the observation `z = H x` with measurement noise covariance `R`.
+ *
+ * The covariance is updated in Joseph form `P = (I-KH) P (I-KH)' + K R K'`,
+ * which keeps `P` symmetric and positive definite in single precision float.
+ *
+ * Measurements from sources with different rates can be fused with the
+ * sequential `update(index, z)`, which uses row `index` of `H` and the
+ * diagonal element of `R` and does not need a matrix inversion.
+ *
+ * Specialisations with unrolled arithmetic exist for the scalar filter
+ * `Kalman<T, 1, 1>` and the two-state filter `Kalman<T, 2, 1>`.
+ *
+ * Example for fusing a floor and a room NTC into one zone temperature:
+ * @code
+ * modm::filter::Kalman<float, 1, 2> temperature(
+ *     {{{1.f}}},              // F: temperature is constant between samples
+ *     {{{1.f}, {1.f}}},       // H: both NTCs measure the temperature
+ *     {{{0.01f}}},            // Q: temperature drift per sample
+ *     {{{0.04f, 0}, {0, 0.25f}}}); // R: floor NTC is more accurate
+ * temperature.reset({20.f}, {{{10.f}}});
+ *
+ * temperature.predict();
+ * temperature.update({floor, room});
+ * const float zone = temperature.getState()[0];
+ * @endcode
+ *
+ * Example for fusing the ripple-counted valve position with the position
+ * estimated from the motor run time, which arrive at different rates:
+ * @code
+ * // state: position [steps], velocity [steps/sample]
+ * modm::filter::Kalman<float, 2, 2> valve(
+ *     {{{1.f, 1.f}, {0, 1.f}}},
+ *     {{{1.f, 0}, {1.f, 0}}}, // both sources measure the position
+ *     {{{0.1f, 0}, {0, 0.5f}}},
+ *     {{{1.f, 0}, {0, 25.f}}});
+ *
+ * valve.predict();
+ * if (ripple_counted) valve.update(0, ripple_position);
+ * valve.update(1, runtime_position);
+ * @endcode
+ *
+ * @tparam	T				floating point type
+ * @tparam	States			number of estimated states
+ * @tparam	Measurements	number of measured values
+ *
+ * @ingroup	modm_math_filter
+ */
+template< typename T, std::size_t States, std::size_t Measurements = 1 >
+class Kalman
+{
+public:
+	using StateVector = std::array<T, States>;
+	using StateMatrix = std::array<StateVector, States>;
+	using MeasurementVector = std::array<T, Measurements>;
+	using MeasurementMatrix = std::array<MeasurementVector, Measurements>;
+	using ObservationMatrix = std::array<StateVector, Measurements>;
+
+	/**
+	 * @param	transition			state transition matrix F
+	 * @param	observation			observation matrix H
+	 * @param	processNoise		process noise covariance Q
+	 * @param	measurementNoise	measurement noise covariance R
+	 */
+	Kalman(const StateMatrix &transition, const ObservationMatrix &observation,
+		   const StateMatrix &processNoise, const MeasurementMatrix &measurementNoise);
+
+	/// Sets the state estimate and its covariance.
+	void
+	reset(const StateVector &state, const StateMatrix &covariance);
+
+	/// Propagates the state and covariance by one sample.
+	void
+	predict();
+
+	/// Propagates the state and covariance by one sample with a control input.
+	void
+	predict(const StateVector &input);
+
+	/**
+	 * Corrects the estimate with all measurements at once.
+	 *
+	 * @return	`false` if the innovation covariance is singular, the estimate
+	 * 			is not changed then.
+	 */
+	bool
+	update(const MeasurementVector &measurement);
+
+	/// Corrects the estimate with a single measurement, assuming `R` is diagonal.
+	bool
+	update(std::size_t index, const T &measurement);
+
+	const StateVector&
+	getState() const
+	{ return x; }
+
+	const StateMatrix&
+	getCovariance() const
+	{ return P; }
+
+	void
+	setTransition(const StateMatrix &transition)
+	{ F = transition; }
+
+	void
+	setObservation(const ObservationMatrix &observation)
+	{ H = observation; }
+
+	void
+	setProcessNoise(const StateMatrix &processNoise)
+	{ Q = processNoise; }
+
+	void
+	setMeasurementNoise(const MeasurementMatrix &measurementNoise)
+	{ R = measurementNoise; }
+
+protected:
+	StateMatrix F;
+	ObservationMatrix H;
+	StateMatrix Q;
+	MeasurementMatrix R;
+
+	StateVector x{};
+	StateMatrix P{};
+};
+
+/// Scalar Kalman filter.
+/// @ingroup	modm_math_filter
+template< typename T >
+class Kalman<T, 1, 1>
+{
+public:
+	using StateVector = std::array<T, 1>;
+	using StateMatrix = std::array<StateVector, 1>;
+	using MeasurementVector = std::array<T, 1>;
+	using MeasurementMatrix = std::array<MeasurementVector, 1>;
+	using ObservationMatrix = std::array<StateVector, 1>;
+
+	Kalman(const StateMatrix &transition, const ObservationMatrix &observation,
+		   const StateMatrix &processNoise, const MeasurementMatrix &measurementNoise);
+
+	void
+	reset(const StateVector &state, const StateMatrix &covariance);
+
+	void
+	predict();
+
+	void
+	predict(const StateVector &input);
+
+	bool
+	update(const MeasurementVector &measurement);
+
+	bool
+	update(std::size_t index, const T &measurement);
+
+	const StateVector&
+	getState() const
+	{ return x; }
+
+	const StateMatrix&
+	getCovariance() const
+	{ return P; }
+
+	void
+	setTransition(const StateMatrix &transition)
+	{ F = transition; }
+
+	void
+	setObservation(const ObservationMatrix &observation)
+	{ H = observation; }
+
+	void
+	setProcessNoise(const StateMatrix &processNoise)
+	{ Q = processNoise; }
+
+	void
+	setMeasurementNoise(const MeasurementMatrix &measurementNoise)
+	{ R = measurementNoise; }
+
+protected:
+	StateMatrix F;
+	ObservationMatrix H;
+	StateMatrix Q;
+	MeasurementMatrix R;
+
+	StateVector x{};
+	StateMatrix P{};
+};
+
+/// Two-state Kalman filter with a single measurement.
+/// @ingroup	modm_math_filter
+template< typename T >
+class Kalman<T, 2, 1>
+{
+public:
+	using StateVector = std::array<T, 2>;
+	using StateMatrix = std::array<StateVector, 2>;
+	using MeasurementVector = std::array<T, 1>;
+	using MeasurementMatrix = std::array<MeasurementVector, 1>;
+	using ObservationMatrix = std::array<StateVector, 1>;
+
+	Kalman(const StateMatrix &transition, const ObservationMatrix &observation,
+		   const StateMatrix &processNoise, const MeasurementMatrix &measurementNoise);
+
+	void
+	reset(const StateVector &state, const StateMatrix &covariance);
+
+	void
+	predict();
+
+	void
+	predict(const StateVector &input);
+
+	bool
+	update(const MeasurementVector &measurement);
+
+	bool
+	update(std::size_t index, const T &measurement);
+
+	const StateVector&
+	getState() const
+	{ return x; }
+
+	const StateMatrix&
+	getCovariance() const
+	{ return P; }
+
+	void
+	setTransition(const StateMatrix &transition)
+	{ F = transition; }
+
+	void
+	setObservation(const ObservationMatrix &observation)
+	{ H = observation; }
+
+	void
+	setProcessNoise(const StateMatrix &processNoise)
+	{ Q = processNoise; }
+
+	void
+	setMeasurementNoise(const MeasurementMatrix &measurementNoise)
+	{ R = measurementNoise; }
+
+protected:
+	StateMatrix F;
+	ObservationMatrix H;
+	StateMatrix Q;
+	MeasurementMatrix R;
+
+	StateVector x{};
+	StateMatrix P{};
+};
+
+} // namespace modm::filter
+
+#include "kalman_impl.hpp"
+
+#endif // MODM_FILTER_KALMAN_HPP
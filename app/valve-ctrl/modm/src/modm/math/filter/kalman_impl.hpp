@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_FILTER_KALMAN_HPP
+#	error	"Don't include this file directly, use 'kalman.hpp' instead!"
+#endif
+
+/// @cond
+namespace modm::filter::kalman_detail
+{
+
+template< typename T, std::size_t Rows, std::size_t Cols >
+using Matrix = std::array<std::array<T, Cols>, Rows>;
+
+/// A * B
+template< typename T, std::size_t Rows, std::size_t Inner, std::size_t Cols >
+Matrix<T, Rows, Cols>
+multiply(const Matrix<T, Rows, Inner> &a, const Matrix<T, Inner, Cols> &b)
+{
+	Matrix<T, Rows, Cols> r{};
+	for (std::size_t ii = 0; ii < Rows; ii++)
+		for (std::size_t kk = 0; kk < Inner; kk++)
+			for (std::size_t jj = 0; jj < Cols; jj++)
+				r[ii][jj] += a[ii][kk] * b[kk][jj];
+	return r;
+}
+
+/// A * B'
+template< typename T, std::size_t Rows, std::size_t Inner, std::size_t Cols >
+Matrix<T, Rows, Cols>
+multiplyTransposed(const Matrix<T, Rows, Inner> &a, const Matrix<T, Cols, Inner> &b)
+{
+	Matrix<T, Rows, Cols> r{};
+	for (std::size_t ii = 0; ii < Rows; ii++)
+		for (std::size_t jj = 0; jj < Cols; jj++)
+			for (std::size_t kk = 0; kk < Inner; kk++)
+				r[ii][jj] += a[ii][kk] * b[jj][kk];
+	return r;
+}
+
+/// Averages P and P' to remove the rounding asymmetry.
+template< typename T, std::size_t N >
+void
+symmetrize(Matrix<T, N, N> &p)
+{
+	for (std::size_t ii = 0; ii < N; ii++)
+		for (std::size_t jj = ii + 1; jj < N; jj++)
+			p[ii][jj] = p[jj][ii] = (p[ii][jj] + p[jj][ii]) / T(2);
+}
+
+/// Gauss-Jordan inversion with partial pivoting, returns false if singular.
+template< typename T, std::size_t N >
+bool
+invert(Matrix<T, N, N> &a)
+{
+	Matrix<T, N, N> inv{};
+	for (std::size_t ii = 0; ii < N; ii++) inv[ii][ii] = T(1);
+
+	for (std::size_t col = 0; col < N; col++)
+	{
+		std::size_t pivot = col;
+		for (std::size_t row = col + 1; row < N; row++)
+			if (std::abs(a[row][col]) > std::abs(a[pivot][col])) pivot = row;
+		if (a[pivot][col] == T(0)) return false;
+		std::swap(a[col], a[pivot]);
+		std::swap(inv[col], inv[pivot]);
+
+		const T scale = T(1) / a[col][col];
+		for (std::size_t jj = 0; jj < N; jj++) {
+			a[col][jj] *= scale;
+			inv[col][jj] *= scale;
+		}
+		for (std::size_t row = 0; row < N; row++)
+		{
+			if (row == col) continue;
+			const T factor = a[row][col];
+			for (std::size_t jj = 0; jj < N; jj++) {
+				a[row][jj] -= factor * a[col][jj];
+				inv[row][jj] -= factor * inv[col][jj];
+			}
+		}
+	}
+	a = inv;
+	return true;
+}
+
+} // namespace modm::filter::kalman_detail
+/// @endcond
+
+// ----------------------------------------------------------------------------
+template< typename T, std::size_t States, std::size_t Measurements >
+modm::filter::Kalman<T, States, Measurements>::Kalman(
+		const StateMatrix &transition, const ObservationMatrix &observation,
+		const StateMatrix &processNoise, const MeasurementMatrix &measurementNoise) :
+	F(transition), H(observation), Q(processNoise), R(measurementNoise)
+{
+}
+
+template< typename T, std::size_t States, std::size_t Measurements >
+void
+modm::filter::Kalman<T, States, Measurements>::reset(
+		const StateVector &state, const StateMatrix &covariance)
+{
+	x = state;
+	P = covariance;
+}
+
+template< typename T, std::size_t States, std::size_t Measurements >
+void
+modm::filter::Kalman<T, States, Measurements>::predict()
+{
+	predict(StateVector{});
+}
+
+template< typename T, std::size_t States, std::size_t Measurements >
+void
+modm::filter::Kalman<T, States, Measurements>::predict(const StateVector &input)
+{
+	using namespace kalman_detail;
+	StateVector next = input;
+	for (std::size_t ii = 0; ii < States; ii++)
+		for (std::size_t jj = 0; jj < States; jj++)
+			next[ii] += F[ii][jj] * x[jj];
+	x = next;
+
+	P = multiplyTransposed(multiply(F, P), F);
+	for (std::size_t ii = 0; ii < States; ii++)
+		for (std::size_t jj = 0; jj < States; jj++)
+			P[ii][jj] += Q[ii][jj];
+	symmetrize(P);
+}
+
+template< typename T, std::size_t States, std::size_t Measurements >
+bool
+modm::filter::Kalman<T, States, Measurements>::update(const MeasurementVector &measurement)
+{
+	using namespace kalman_detail;
+	// innovation y = z - H x
+	MeasurementVector y = measurement;
+	for (std::size_t ii = 0; ii < Measurements; ii++)
+		for (std::size_t jj = 0; jj < States; jj++)
+			y[ii] -= H[ii][jj] * x[jj];
+
+	// S = H P H' + R
+	const Matrix<T, States, Measurements> PHt = multiplyTransposed(P, H);
+	Matrix<T, Measurements, Measurements> S = multiply(H, PHt);
+	for (std::size_t ii = 0; ii < Measurements; ii++)
+		for (std::size_t jj = 0; jj < Measurements; jj++)
+			S[ii][jj] += R[ii][jj];
+	if (not invert(S)) return false;
+
+	// K = P H' S^-1
+	const Matrix<T, States, Measurements> K = multiply(PHt, S);
+	for (std::size_t ii = 0; ii < States; ii++)
+		for (std::size_t jj = 0; jj < Measurements; jj++)
+			x[ii] += K[ii][jj] * y[jj];
+
+	// P = (I - K H) P (I - K H)' + K R K'
+	StateMatrix A = multiply(K, H);
+	for (std::size_t ii = 0; ii < States; ii++)
+		for (std::size_t jj = 0; jj < States; jj++)
+			A[ii][jj] = T(ii == jj) - A[ii][jj];
+	P = multiplyTransposed(multiply(A, P), A);
+	const StateMatrix KRKt = multiplyTransposed(multiply(K, R), K);
+	for (std::size_t ii = 0; ii < States; ii++)
+		for (std::size_t jj = 0; jj < States; jj++)
+			P[ii][jj] += KRKt[ii][jj];
+	symmetrize(P);
+	return true;
+}
+
+template< typename T, std::size_t States, std::size_t Measurements >
+bool
+modm::filter::Kalman<T, States, Measurements>::update(std::size_t index, const T &measurement)
+{
+	using namespace kalman_detail;
+	const StateVector &h = H[index];
+	const T r = R[index][index];
+
+	StateVector Ph{};
+	T s = r;
+	T y = measurement;
+	for (std::size_t ii = 0; ii < States; ii++)
+	{
+		for (std::size_t jj = 0; jj < States; jj++)
+			Ph[ii] += P[ii][jj] * h[jj];
+		s += h[ii] * Ph[ii];
+		y -= h[ii] * x[ii];
+	}
+	if (not (s > T(0))) return false;
+
+	StateVector K;
+	for (std::size_t ii = 0; ii < States; ii++)
+	{
+		K[ii] = Ph[ii] / s;
+		x[ii] += K[ii] * y;
+	}
+
+	StateMatrix A;
+	for (std::size_t ii = 0; ii < States; ii++)
+		for (std::size_t jj = 0; jj < States; jj++)
+			A[ii][jj] = T(ii == jj) - K[ii] * h[jj];
+	P = multiplyTransposed(multiply(A, P), A);
+	for (std::size_t ii = 0; ii < States; ii++)
+		for (std::size_t jj = 0; jj < States; jj++)
+			P[ii][jj] += r * K[ii] * K[jj];
+	symmetrize(P);
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+template< typename T >
+modm::filter::Kalman<T, 1, 1>::Kalman(
+		const StateMatrix &transition, const ObservationMatrix &observation,
+		const StateMatrix &processNoise, const MeasurementMatrix &measurementNoise) :
+	F(transition), H(observation), Q(processNoise), R(measurementNoise)
+{
+}
+
+template< typename T >
+void
+modm::filter::Kalman<T, 1, 1>::reset(const StateVector &state, const StateMatrix &covariance)
+{
+	x = state;
+	P = covariance;
+}
+
+template< typename T >
+void
+modm::filter::Kalman<T, 1, 1>::predict()
+{
+	predict(StateVector{});
+}
+
+template< typename T >
+void
+modm::filter::Kalman<T, 1, 1>::predict(const StateVector &input)
+{
+	const T f = F[0][0];
+	x[0] = f * x[0] + input[0];
+	P[0][0] = f * P[0][0] * f + Q[0][0];
+}
+
+template< typename T >
+bool
+modm::filter::Kalman<T, 1, 1>::update(const MeasurementVector &measurement)
+{
+	return update(0, measurement[0]);
+}
+
+template< typename T >
+bool
+modm::filter::Kalman<T, 1, 1>::update(std::size_t, const T &measurement)
+{
+	const T h = H[0][0];
+	const T r = R[0][0];
+	const T p = P[0][0];
+	const T s = h * p * h + r;
+	if (not (s > T(0))) return false;
+
+	const T k = p * h / s;
+	x[0] += k * (measurement - h * x[0]);
+	const T a = T(1) - k * h;
+	P[0][0] = a * p * a + k * r * k;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+template< typename T >
+modm::filter::Kalman<T, 2, 1>::Kalman(
+		const StateMatrix &transition, const ObservationMatrix &observation,
+		const StateMatrix &processNoise, const MeasurementMatrix &measurementNoise) :
+	F(transition), H(observation), Q(processNoise), R(measurementNoise)
+{
+}
+
+template< typename T >
+void
+modm::filter::Kalman<T, 2, 1>::reset(const StateVector &state, const StateMatrix &covariance)
+{
+	x = state;
+	P = covariance;
+}
+
+template< typename T >
+void
+modm::filter::Kalman<T, 2, 1>::predict()
+{
+	predict(StateVector{});
+}
+
+template< typename T >
+void
+modm::filter::Kalman<T, 2, 1>::predict(const StateVector &input)
+{
+	const T x0 = F[0][0] * x[0] + F[0][1] * x[1] + input[0];
+	const T x1 = F[1][0] * x[0] + F[1][1] * x[1] + input[1];
+	x = {x0, x1};
+
+	// P is symmetric: only a = P00, b = P01 = P10 and d = P11 are used
+	const T a = P[0][0], b = P[0][1], d = P[1][1];
+	const T n00 = F[0][0] * a + F[0][1] * b;
+	const T n01 = F[0][0] * b + F[0][1] * d;
+	const T n10 = F[1][0] * a + F[1][1] * b;
+	const T n11 = F[1][0] * b + F[1][1] * d;
+	P[0][0] = n00 * F[0][0] + n01 * F[0][1] + Q[0][0];
+	P[0][1] = P[1][0] = n00 * F[1][0] + n01 * F[1][1] + Q[0][1];
+	P[1][1] = n10 * F[1][0] + n11 * F[1][1] + Q[1][1];
+}
+
+template< typename T >
+bool
+modm::filter::Kalman<T, 2, 1>::update(const MeasurementVector &measurement)
+{
+	return update(0, measurement[0]);
+}
+
+template< typename T >
+bool
+modm::filter::Kalman<T, 2, 1>::update(std::size_t, const T &measurement)
+{
+	const T h0 = H[0][0], h1 = H[0][1];
+	const T r = R[0][0];
+	const T a = P[0][0], b = P[0][1], d = P[1][1];
+
+	const T p0 = a * h0 + b * h1;
+	const T p1 = b * h0 + d * h1;
+	const T s = h0 * p0 + h1 * p1 + r;
+	if (not (s > T(0))) return false;
+
+	const T k0 = p0 / s;
+	const T k1 = p1 / s;
+	const T y = measurement - h0 * x[0] - h1 * x[1];
+	x[0] += k0 * y;
+	x[1] += k1 * y;
+
+	// Joseph form with A = I - K h
+	const T a00 = T(1) - k0 * h0, a01 = -k0 * h1;
+	const T a10 = -k1 * h0, a11 = T(1) - k1 * h1;
+	const T m00 = a00 * a + a01 * b, m01 = a00 * b + a01 * d;
+	const T m10 = a10 * a + a11 * b, m11 = a10 * b + a11 * d;
+	P[0][0] = m00 * a00 + m01 * a01 + r * k0 * k0;
+	P[0][1] = P[1][0] = m00 * a10 + m01 * a11 + r * k0 * k1;
+	P[1][1] = m10 * a10 + m11 * a11 + r * k1 * k1;
+	return true;
+}
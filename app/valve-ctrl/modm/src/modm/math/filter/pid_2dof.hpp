@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_PID_2DOF_HPP
+#define MODM_PID_2DOF_HPP
+
+#include <stdint.h>
+
+#include <modm/math/utils/arithmetic_traits.hpp>
+
+namespace modm
+{
+	/**
+	 * \brief	A two-degree-of-freedom PID controller with back-calculation
+	 * 			anti-windup and feed-forward input
+	 *
+	 * In contrast to modm::Pid this controller gets the setpoint and the
+	 * measured value separately:
+	 *
+	 * - The proportional term acts on the weighted error
+	 *   `b * setpoint - input`. With `b < 1` a setpoint step causes a smaller
+	 *   output step, which reduces overshoot.
+	 * - The derivative term acts on the measured value only and is smoothed by
+	 *   a first-order low-pass filter with coefficient `alpha` (1 = unfiltered).
+	 *   Setpoint changes therefore do not cause a derivative kick.
+	 * - The integrator is corrected by `kt * (saturated - unsaturated)` whenever
+	 *   the output is limited (back-calculation), so it tracks the limit
+	 *   instead of winding up.
+	 * - A feed-forward value is added to the output before limitation.
+	 *
+	 * All gains are per sample, i.e. `ki` and `kt` contain the sample time and
+	 * `kd` contains its reciprocal.
+	 *
+	 * With the template parameter \c ScaleFactor this class provides a fixed
+	 * point capability with integer types. Since `b` and `alpha` are in the
+	 * range [0, 1], \c ScaleFactor should be large enough to represent them.
+	 * For floating point types use the default \c ScaleFactor of 1.
+	 *
+	 * Example for a valve position control with a 10-bit PWM output.
+	 * \code
+	 * Pid2Dof<int32_t, 1024>::Parameter parameter;
+	 * parameter.setKp(0.4); parameter.setKi(0.05); parameter.setKd(0.2);
+	 * parameter.setKt(0.1); parameter.setSetpointWeight(0.7);
+	 * parameter.setDerivativeFilter(0.2); parameter.setMaxOutput(1023);
+	 * Pid2Dof<int32_t, 1024> pid(parameter);
+	 *
+	 * ...
+	 *
+	 * pid.update(position_target, position, friction_feed_forward);
+	 * pwm = pid.getValue();
+	 * \endcode
+	 *
+	 * \ingroup	modm_math_filter
+	 */
+	template<typename T, unsigned int ScaleFactor = 1>
+	class Pid2Dof
+	{
+		typedef modm::WideType<T> WideType;
+		/// Signed scale, so that negative values are not divided as unsigned
+		static constexpr WideType Scale = ScaleFactor;
+
+	public:
+		typedef T ValueType;
+
+		/**
+		 * \brief	Parameter for a PID calculation
+		 *
+		 * All values except `maxOutput` are multiplied with \c ScaleFactor.
+		 */
+		struct Parameter
+		{
+			Parameter(const float& kp = 0, const float& ki = 0, const float& kd = 0,
+					  const float& kt = 0, const float& b = 1, const float& alpha = 1,
+					  const T& maxOutput = 0);
+
+			inline void
+			setKp(float kp) {
+				this->kp = static_cast<T>(kp * ScaleFactor);
+			}
+
+			inline void
+			setKi(float ki) {
+				this->ki = static_cast<T>(ki * ScaleFactor);
+			}
+
+			inline void
+			setKd(float kd) {
+				this->kd = static_cast<T>(kd * ScaleFactor);
+			}
+
+			/// Back-calculation gain, typically between `ki / kp` and `ki`.
+			inline void
+			setKt(float kt) {
+				this->kt = static_cast<T>(kt * ScaleFactor);
+			}
+
+			/// Weight of the setpoint in the proportional term in [0, 1].
+			inline void
+			setSetpointWeight(float b) {
+				this->b = static_cast<T>(b * ScaleFactor);
+			}
+
+			/// Coefficient of the derivative low-pass in (0, 1], 1 = unfiltered.
+			inline void
+			setDerivativeFilter(float alpha) {
+				this->alpha = static_cast<T>(alpha * ScaleFactor);
+			}
+
+			inline void
+			setMaxOutput(const T& maxOutput) {
+				this->maxOutput = maxOutput;
+			}
+
+		private:
+			T kp;		///< Proportional gain multiplied with ScaleFactor
+			T ki;		///< Integral gain multiplied with ScaleFactor
+			T kd;		///< Differential gain multiplied with ScaleFactor
+			T kt;		///< Back-calculation gain multiplied with ScaleFactor
+			T b;		///< Setpoint weight multiplied with ScaleFactor
+			T alpha;	///< Derivative filter coefficient multiplied with ScaleFactor
+
+			T maxOutput;	///< output will be limited to this value
+
+			friend class Pid2Dof;
+		};
+
+	public:
+		/**
+		 * \param	parameter	list of parameters to the controller
+		 **/
+		Pid2Dof(const Parameter& parameter = Parameter());
+
+		/**
+		 * Reset the parameters of the controller.
+		 *
+		 * \param	parameter	list of parameters to the controller
+		 **/
+		void
+		setParameter(const Parameter& parameter);
+
+		/**
+		 * \brief	Reset all values
+		 *
+		 * \param	input	Current measured value, used to start the
+		 * 					derivative term without a kick.
+		 * \param	output	Current actuating variable, used to preload the
+		 * 					integrator for a bumpless transfer.
+		 */
+		void
+		reset(const T& input = 0, const T& output = 0);
+
+		/**
+		 * \brief	Calculate a new output value
+		 *
+		 * \param	setpoint	Target value
+		 * \param	input		Measured value
+		 * \param	feedForward	Value added to the output before limitation
+		 */
+		void
+		update(const T& setpoint, const T& input, const T& feedForward = 0);
+
+		/**
+		 * \brief	Returns the calculated actuating variable.
+		 */
+		inline const T&
+		getValue() const
+		{
+			return output;
+		}
+
+		/**
+		 * \brief	Get the integrator state in output units
+		 *
+		 * This function is provided for debugging purposes only.
+		 */
+		inline T
+		getIntegral() const
+		{
+			return static_cast<T>(integral / Scale);
+		}
+
+		/**
+		 * \brief	Get the filtered derivative term in output units
+		 *
+		 * This function is provided for debugging purposes only.
+		 */
+		inline T
+		getDerivative() const
+		{
+			return static_cast<T>(derivative / Scale);
+		}
+
+		/**
+		 * \brief	Check if the output was limited by the last update
+		 */
+		inline bool
+		isLimited() const
+		{
+			return limited;
+		}
+
+	private:
+		Parameter parameter;
+
+		/// Integrator and filtered derivative in output units times ScaleFactor
+		WideType integral;
+		WideType derivative;
+		T lastInput;
+		T output;
+		bool limited;
+	};
+}
+
+#include "pid_2dof_impl.hpp"
+
+#endif // MODM_PID_2DOF_HPP
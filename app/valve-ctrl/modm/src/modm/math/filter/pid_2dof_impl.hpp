@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_PID_2DOF_IMPL_HPP
+#define MODM_PID_2DOF_IMPL_HPP
+
+template<typename T, unsigned int ScaleFactor>
+modm::Pid2Dof<T, ScaleFactor>::Parameter::Parameter(
+		const float& kp, const float& ki, const float& kd,
+		const float& kt, const float& b, const float& alpha,
+		const T& maxOutput) :
+	kp(static_cast<T>(kp * ScaleFactor)),
+	ki(static_cast<T>(ki * ScaleFactor)),
+	kd(static_cast<T>(kd * ScaleFactor)),
+	kt(static_cast<T>(kt * ScaleFactor)),
+	b(static_cast<T>(b * ScaleFactor)),
+	alpha(static_cast<T>(alpha * ScaleFactor)),
+	maxOutput(maxOutput)
+{
+}
+
+// -----------------------------------------------------------------------------
+template<typename T, unsigned int ScaleFactor>
+modm::Pid2Dof<T, ScaleFactor>::Pid2Dof(
+		const Parameter& parameter) :
+	parameter(parameter)
+{
+	this->reset();
+}
+
+template<typename T, unsigned int ScaleFactor>
+void
+modm::Pid2Dof<T, ScaleFactor>::reset(const T& input, const T& output)
+{
+	this->integral = static_cast<WideType>(output) * Scale;
+	this->derivative = 0;
+	this->lastInput = input;
+	this->output = output;
+	this->limited = false;
+}
+
+template<typename T, unsigned int ScaleFactor>
+void
+modm::Pid2Dof<T, ScaleFactor>::setParameter(const Parameter& parameter)
+{
+	this->parameter = parameter;
+}
+
+template<typename T, unsigned int ScaleFactor>
+void
+modm::Pid2Dof<T, ScaleFactor>::update(const T& setpoint, const T& input,
+									  const T& feedForward)
+{
+	const WideType error = static_cast<WideType>(setpoint) - input;
+	const WideType weightedError =
+			static_cast<WideType>(this->parameter.b) * setpoint / Scale - input;
+
+	// derivative on measurement through a first-order low-pass
+	const WideType rawDerivative =
+			-static_cast<WideType>(this->parameter.kd) * (static_cast<WideType>(input) - this->lastInput);
+	this->derivative += static_cast<WideType>(this->parameter.alpha) *
+			(rawDerivative - this->derivative) / Scale;
+
+	WideType tmp = static_cast<WideType>(this->parameter.kp) * weightedError;
+	tmp += this->integral;
+	tmp += this->derivative;
+	tmp = tmp / Scale + feedForward;
+
+	const WideType maxOutput = this->parameter.maxOutput;
+	WideType saturated = tmp;
+	if (tmp > maxOutput) {
+		saturated = maxOutput;
+	}
+	else if (tmp < -maxOutput) {
+		saturated = -maxOutput;
+	}
+	this->limited = (saturated != tmp);
+	this->output = static_cast<T>(saturated);
+
+	// Back-calculation: the integrator is pulled towards the value at which
+	// the output just reaches the limit, so it never winds up.
+	this->integral += static_cast<WideType>(this->parameter.ki) * error +
+			static_cast<WideType>(this->parameter.kt) * (saturated - tmp);
+
+	this->lastInput = input;
+}
+
+#endif // MODM_PID_2DOF_IMPL_HPP
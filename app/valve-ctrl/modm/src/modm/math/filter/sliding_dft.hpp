@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef MODM_MATH_SLIDING_DFT_HPP
+#define MODM_MATH_SLIDING_DFT_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <stdint.h>
+#include <type_traits>
+
+namespace modm::math
+{
+
+/**
+ * Sliding DFT for a small set of frequency bins.
+ *
+ * In contrast to the Goertzel algorithm the result is updated with every
+ * sample over the last `Length` samples, at the cost of a sample history and
+ * one complex multiplication per bin and sample. The bins are integer DFT
+ * bins `k`, i.e. the frequency is `k / Length` cycles per sample.
+ *
+ * The recursion is damped by `r^Length` to keep it stable despite rounding:
+ * `S(n) = W * (r * S(n-1) + x(n) - r^Length * x(n - Length))`. This weights
+ * older samples slightly less, e.g. r = 0.9999 lowers the power of a 256-point
+ * DFT by about 2.5%.
+ *
+ * `T` may be `float` or `int32_t`. For `int32_t` the samples are Q31 values,
+ * the computation uses 32x32->64-bit multiplications only and the power is
+ * returned in Q31. The input is scaled by `1/(2 * Length)` to provide headroom.
+ *
+ * @code
+ * // ADC at 20kHz, 256 samples -> 78Hz bin width, ripple 400Hz..1.2kHz
+ * modm::math::SlidingDft<int32_t, 256, 11> ripple({5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15});
+ *
+ * ripple.update(std::span{adc_block_q31});
+ * const auto bin = ripple.getDominantBin();
+ * const float frequency = ripple.getFrequency(bin) * 20'000;
+ * @endcode
+ *
+ * @tparam	T		`float` or `int32_t` (Q31)
+ * @tparam	Length	DFT length, must be a power of two
+ * @tparam	Bins	number of DFT bins
+ *
+ * @ingroup	modm_math_filter
+ */
+template< typename T, std::size_t Length, std::size_t Bins >
+class SlidingDft
+{
+	static constexpr bool Fixed = std::is_same_v<T, int32_t>;
+	static_assert(Fixed or std::is_floating_point_v<T>,
+				  "SlidingDft only supports floating point or Q31 (int32_t) samples!");
+	static_assert(std::has_single_bit(Length), "SlidingDft requires a power of two length!");
+	static constexpr uint8_t Headroom = std::countr_zero(Length) + 1;
+
+public:
+	/**
+	 * @param	bins	DFT bin indices in [1, Length/2)
+	 * @param	damping	damping factor `r` slightly below 1
+	 */
+	explicit
+	SlidingDft(const std::array<uint16_t, Bins> &bins, float damping = 0.9999f)
+	: bins(bins)
+	{
+		for (std::size_t bin = 0; bin < Bins; bin++)
+		{
+			const float omega = 2.f * std::numbers::pi_v<float> * bins[bin] / Length;
+			twiddle[bin] = {convert(std::cos(omega)), convert(std::sin(omega))};
+		}
+		r = convert(damping);
+		rN = convert(std::pow(damping, float(Length)));
+		reset();
+	}
+
+	void
+	reset()
+	{
+		history = {};
+		state = {};
+		index = 0;
+	}
+
+	void
+	update(T sample)
+	{
+		if constexpr (Fixed) sample >>= Headroom;
+		const T delta = sample - multiply(rN, history[index]);
+		history[index] = sample;
+		index = (index + 1) & (Length - 1);
+
+		for (std::size_t bin = 0; bin < Bins; bin++)
+		{
+			const T re = multiply(r, state[bin][0]) + delta;
+			const T im = multiply(r, state[bin][1]);
+			const auto &w = twiddle[bin];
+			state[bin][0] = multiply(w[0], re) - multiply(w[1], im);
+			state[bin][1] = multiply(w[1], re) + multiply(w[0], im);
+		}
+	}
+
+	void
+	update(std::span<const T> samples)
+	{
+		for (const T sample : samples) update(sample);
+	}
+
+	/// Squared amplitude of the bin over the last `Length` samples.
+	T
+	getPower(std::size_t bin) const
+	{
+		const T re = state[bin][0], im = state[bin][1];
+		if constexpr (Fixed)
+		{
+			// 4|X|^2/N^2 with X scaled by 1/2N is 16|X|^2, in Q62 -> Q31
+			const int64_t p = (int64_t(re) * re + int64_t(im) * im) >> (31 - 4);
+			return int32_t(std::min<int64_t>(p, INT32_MAX));
+		}
+		else return (re * re + im * im) * (T(4) / (T(Length) * T(Length)));
+	}
+
+	/// Bin frequency in cycles per sample.
+	float
+	getFrequency(std::size_t bin) const
+	{ return float(bins[bin]) / Length; }
+
+	/// Index of the bin with the highest power.
+	std::size_t
+	getDominantBin() const
+	{
+		std::size_t dominant = 0;
+		T maximum = getPower(0);
+		for (std::size_t bin = 1; bin < Bins; bin++)
+			if (const T p = getPower(bin); p > maximum) { maximum = p; dominant = bin; }
+		return dominant;
+	}
+
+private:
+	static T
+	convert(float value)
+	{
+		if constexpr (Fixed)
+			return int32_t(std::clamp<long long>(std::llround(value * 2147483648.f),
+												 INT32_MIN, INT32_MAX));
+		else return T(value);
+	}
+
+	static constexpr T
+	multiply(T a, T b)
+	{
+		if constexpr (Fixed) return int32_t((int64_t(a) * b) >> 31);
+		else return a * b;
+	}
+
+	std::array<T, Length> history;
+	std::array<std::array<T, 2>, Bins> state;
+	std::array<std::array<T, 2>, Bins> twiddle;
+	std::array<uint16_t, Bins> bins;
+	T r;
+	T rN;
+	std::size_t index;
+};
+
+} // namespace modm::math
+
+#endif // MODM_MATH_SLIDING_DFT_HPP
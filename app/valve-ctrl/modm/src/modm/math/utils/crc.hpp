@@ -13,6 +13,10 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <array>
+#include <cstring>
+#include <span>
+#include "endianness.hpp"
 #ifdef __AVR__
 #include <util/crc16.h>
 #endif
@@ -22,12 +26,39 @@ namespace modm::math
 /// @ingroup modm_math_utils
 /// @{
 
-inline uint8_t
-crc8_ccitt_update(uint8_t crc, uint8_t data)
+/**
+ * Lookup strategy of the bulk CRC functions.
+ *
+ * The tables are generated at compile time and are only placed into flash if
+ * the corresponding strategy is used, so small targets can trade flash for
+ * speed on a per-call basis.
+ *
+ * | Strategy  | CRC8  | CRC16   | CRC32   | Bytes per iteration |
+ * |-----------|-------|---------|---------|---------------------|
+ * | `Bitwise` | 0B    | 0B      | 0B      | 1 (8 shifts)        |
+ * | `Table`   | 256B  | 512B    | 1kB     | 1                   |
+ * | `Slice4`  | 256B  | 2kB     | 4kB     | 4                   |
+ * | `Slice8`  | 256B  | 4kB     | 8kB     | 8                   |
+ *
+ * @note CRC8 always uses a single table for `Slice4` and `Slice8`, since the
+ *       whole CRC register is consumed by every byte.
+ */
+enum class
+CrcLookup : uint8_t
+{
+    Bitwise,
+    Table,
+    Slice4,
+    Slice8,
+};
+
+/// @cond
+namespace crc_detail
+{
+
+constexpr uint8_t
+crc8_ccitt_bitwise(uint8_t crc, uint8_t data)
 {
-#ifdef __AVR__
-    return _crc8_ccitt_update(crc, data);
-#else
     data ^= crc;
     for (uint8_t ii = 0; ii < 8; ii++)
     {
@@ -35,6 +66,113 @@ crc8_ccitt_update(uint8_t crc, uint8_t data)
         if (data & 0x80) data ^= 0x07;
     }
     return data;
+}
+
+constexpr uint16_t
+crc16_ccitt_bitwise(uint16_t crc, uint8_t data)
+{
+    data ^= uint8_t(crc); data ^= data << 4;
+    return (((uint16_t(data) << 8) | uint8_t(crc >> 8)) ^
+            uint8_t(data >> 4) ^ (uint16_t(data) << 3));
+}
+
+constexpr uint32_t
+crc32_bitwise(uint32_t crc, uint8_t data)
+{
+    constexpr uint32_t polynomial{0xEDB88320};
+    crc ^= data;
+    for (uint_fast8_t ii = 0; ii < 8; ii++)
+        crc = (crc >> 1) ^ (-int32_t(crc & 1) & polynomial);
+    return crc;
+}
+
+/// Table[0] is the byte-wise table, Table[n] advances Table[n-1] by one zero byte.
+template< typename T, T(*Update)(T, uint8_t), size_t Slices >
+inline constexpr std::array<std::array<T, 256>, Slices> table = []
+{
+    std::array<std::array<T, 256>, Slices> tables{};
+    for (size_t ii = 0; ii < 256; ii++)
+        tables[0][ii] = Update(0, uint8_t(ii));
+    for (size_t slice = 1; slice < Slices; slice++)
+        for (size_t ii = 0; ii < 256; ii++)
+        {
+            const T prev = tables[slice - 1][ii];
+            if constexpr (sizeof(T) == 1) tables[slice][ii] = tables[0][prev];
+            else tables[slice][ii] = T(prev >> 8) ^ tables[0][uint8_t(prev)];
+        }
+    return tables;
+}();
+
+inline uint32_t
+load32(const uint8_t *data)
+{
+    uint32_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return fromLittleEndian(word);
+}
+
+/// All supported CRCs shift towards the LSB, so the CRC register can be
+/// XOR-ed onto the little-endian input word before the parallel lookup.
+template< typename T, T(*Update)(T, uint8_t), CrcLookup Lookup >
+inline T
+update(T crc, std::span<const uint8_t> data)
+{
+    const uint8_t *ptr = data.data();
+    size_t length = data.size();
+
+    if constexpr (Lookup == CrcLookup::Bitwise)
+    {
+        while (length--) crc = Update(crc, *ptr++);
+        return crc;
+    }
+    else if constexpr (sizeof(T) == 1 or Lookup == CrcLookup::Table)
+    {
+        constexpr auto &tbl = table<T, Update, 1>[0];
+        if constexpr (sizeof(T) == 1) {
+            while (length--) crc = tbl[uint8_t(crc ^ *ptr++)];
+        } else {
+            while (length--) crc = T(crc >> 8) ^ tbl[uint8_t(crc ^ *ptr++)];
+        }
+        return crc;
+    }
+    else
+    {
+        constexpr size_t Slices = (Lookup == CrcLookup::Slice8) ? 8 : 4;
+        constexpr auto &tbl = table<T, Update, Slices>;
+        while (length >= Slices)
+        {
+            const uint32_t one = load32(ptr) ^ crc;
+            T next = tbl[Slices - 1][uint8_t(one)] ^
+                     tbl[Slices - 2][uint8_t(one >> 8)] ^
+                     tbl[Slices - 3][uint8_t(one >> 16)] ^
+                     tbl[Slices - 4][uint8_t(one >> 24)];
+            if constexpr (Slices == 8)
+            {
+                const uint32_t two = load32(ptr + 4);
+                next ^= tbl[3][uint8_t(two)] ^
+                        tbl[2][uint8_t(two >> 8)] ^
+                        tbl[1][uint8_t(two >> 16)] ^
+                        tbl[0][uint8_t(two >> 24)];
+            }
+            crc = next;
+            ptr += Slices;
+            length -= Slices;
+        }
+        while (length--) crc = T(crc >> 8) ^ tbl[0][uint8_t(crc ^ *ptr++)];
+        return crc;
+    }
+}
+
+} // namespace crc_detail
+/// @endcond
+
+inline uint8_t
+crc8_ccitt_update(uint8_t crc, uint8_t data)
+{
+#ifdef __AVR__
+    return _crc8_ccitt_update(crc, data);
+#else
+    return crc_detail::crc8_ccitt_bitwise(crc, data);
 #endif
 }
 
@@ -44,9 +182,7 @@ crc16_ccitt_update(uint16_t crc, uint8_t data)
 #ifdef __AVR__
     return _crc_ccitt_update(crc, data);
 #else
-    data ^= uint8_t(crc); data ^= data << 4;
-    return (((uint16_t(data) << 8) | uint8_t(crc >> 8)) ^
-            uint8_t(data >> 4) ^ (uint16_t(data) << 3));
+    return crc_detail::crc16_ccitt_bitwise(crc, data);
 #endif
 }
 
@@ -54,11 +190,7 @@ crc16_ccitt_update(uint16_t crc, uint8_t data)
 inline uint32_t
 crc32_update(uint32_t crc, uint8_t data)
 {
-    static constexpr uint32_t polynomial{0xEDB88320};
-    crc ^= data;
-    for (uint_fast8_t ii = 0; ii < 8; ii++)
-        crc = (crc >> 1) ^ (-int32_t(crc & 1) & polynomial);
-    return crc;
+    return crc_detail::crc32_bitwise(crc, data);
 }
 
 static constexpr uint8_t crc8_ccitt_init{0xFFu};
@@ -90,6 +222,55 @@ crc32(const uint8_t *data, size_t length)
     return ~crc;
 }
 
+// ----------------------------------------------------------------------------
+/// Updates a CRC8 with a block of data using the lookup strategy.
+template< CrcLookup Lookup = CrcLookup::Table >
+inline uint8_t
+crc8_ccitt_update(uint8_t crc, std::span<const uint8_t> data)
+{
+    return crc_detail::update<uint8_t, crc_detail::crc8_ccitt_bitwise, Lookup>(crc, data);
+}
+
+/// Updates a CRC16 with a block of data using the lookup strategy.
+template< CrcLookup Lookup = CrcLookup::Table >
+inline uint16_t
+crc16_ccitt_update(uint16_t crc, std::span<const uint8_t> data)
+{
+    return crc_detail::update<uint16_t, crc_detail::crc16_ccitt_bitwise, Lookup>(crc, data);
+}
+
+/// Updates a CRC32 with a block of data using the lookup strategy.
+/// The result must still be inverted to obtain the final CRC32.
+template< CrcLookup Lookup = CrcLookup::Table >
+inline uint32_t
+crc32_update(uint32_t crc, std::span<const uint8_t> data)
+{
+    return crc_detail::update<uint32_t, crc_detail::crc32_bitwise, Lookup>(crc, data);
+}
+
+/// Computes the CRC8 of a block of data using the lookup strategy.
+template< CrcLookup Lookup = CrcLookup::Table >
+inline uint8_t
+crc8_ccitt(std::span<const uint8_t> data)
+{
+    return crc8_ccitt_update<Lookup>(crc8_ccitt_init, data);
+}
+
+/// Computes the CRC16 of a block of data using the lookup strategy.
+template< CrcLookup Lookup = CrcLookup::Table >
+inline uint16_t
+crc16_ccitt(std::span<const uint8_t> data)
+{
+    return crc16_ccitt_update<Lookup>(crc16_ccitt_init, data);
+}
+
+/// Computes the CRC32 of a block of data using the lookup strategy.
+template< CrcLookup Lookup = CrcLookup::Table >
+inline uint32_t
+crc32(std::span<const uint8_t> data)
+{
+    return ~crc32_update<Lookup>(crc32_init, data);
+}
+
 /// @}
 } // namespace modm::math
-
@@ -19,6 +19,7 @@
 #include "platform/core/delay_ns.hpp"
 #include "platform/core/hardware_init.hpp"
 #include "platform/core/vectors.hpp"
+#include "platform/crc/crc.hpp"
 #include "platform/gpio/base.hpp"
 #include "platform/gpio/connector.hpp"
 #include "platform/gpio/data.hpp"
@@ -39,4 +40,6 @@
 #include "platform/timer/basic_base.hpp"
 #include "platform/timer/general_purpose_base.hpp"
 #include "platform/timer/timer_1.hpp"
+#include "platform/usb/cdc_acm.hpp"
+#include "platform/usb/usb_cdc_acm.hpp"
 #include "platform/usb/usb_fs.hpp"
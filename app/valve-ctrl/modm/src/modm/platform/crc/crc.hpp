@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstring>
+#include <span>
+#include <modm/math/utils/crc.hpp>
+#include <modm/platform/device.hpp>
+#include <modm/platform/clock/rcc.hpp>
+
+namespace modm::platform
+{
+
+/**
+ * Hardware CRC calculation unit.
+ *
+ * The peripheral computes the CRC-32 polynomial 0x04C11DB7 MSB-first on 32-bit
+ * words. By bit-reversing the input words and the result, this computes the
+ * same CRC32 as `modm::math::crc32()` at one word per AHB cycle. Trailing bytes
+ * that do not fill a word are finished in software.
+ *
+ * @warning The unit has a single shared state and is not reentrant. Do not use
+ *          it from an interrupt while a fiber is using it.
+ *
+ * @ingroup modm_platform_crc
+ */
+class Crc
+{
+public:
+	static void
+	initialize()
+	{
+		Rcc::enable<Peripheral::Crc>();
+	}
+
+	static void
+	reset()
+	{
+		CRC->CR = CRC_CR_RESET;
+	}
+
+	/// Computes the CRC32 of a block of data compatible with `modm::math::crc32()`.
+	template< modm::math::CrcLookup TailLookup = modm::math::CrcLookup::Bitwise >
+	static uint32_t
+	crc32(std::span<const uint8_t> data)
+	{
+		reset();
+		const uint8_t *ptr = data.data();
+		size_t words = data.size() / 4;
+		while (words--)
+		{
+			uint32_t word;
+			std::memcpy(&word, ptr, sizeof(word));
+			CRC->DR = __RBIT(word);
+			ptr += 4;
+		}
+		const uint32_t crc = __RBIT(CRC->DR);
+		return ~modm::math::crc32_update<TailLookup>(crc, {ptr, data.size() % 4});
+	}
+};
+
+} // namespace modm::platform
@@ -12,6 +12,7 @@
 #include <modm/platform/device.hpp>
 #include "rtt.hpp"
 #include <algorithm>
+#include <cstring>
 
 namespace modm::platform
 {
@@ -29,40 +30,85 @@ struct RttBuffer
 	{
 		const uint32_t rhead{head};
 		const uint32_t rtail{tail};
-		const uint32_t rhead_next{(rhead + 1) % size};
+		uint32_t rhead_next{rhead + 1};
+		if (rhead_next >= size) rhead_next = 0;
 		if (not size or rhead_next == rtail) return false;
 		buffer[rhead] = data;
+		__DMB();
 		head = rhead_next;
 		return true;
 	}
+	std::size_t write(const uint8_t *data, std::size_t length)
+	{
+		if (not size) return 0;
+		const uint32_t rhead{head};
+		const uint32_t rtail{tail};
+		// one byte always stays free to distinguish a full from an empty buffer
+		const uint32_t space{((rtail > rhead) ? 0 : size) + rtail - rhead - 1};
+		length = std::min<std::size_t>(length, space);
+		// copy in at most two chunks across the wrap and publish the head once
+		const std::size_t chunk = std::min<std::size_t>(length, size - rhead);
+		std::memcpy(buffer + rhead, data, chunk);
+		std::memcpy(buffer, data + chunk, length - chunk);
+		uint32_t rhead_next{rhead + uint32_t(length)};
+		if (rhead_next >= size) rhead_next -= size;
+		// the data must be visible to the debugger before the head is
+		__DMB();
+		head = rhead_next;
+		return length;
+	}
 	bool read(uint8_t &data)
 	{
 		const uint32_t rhead{head};
 		const uint32_t rtail{tail};
 		if (not size or rtail == rhead) return false;
+		__DMB();
 		data = buffer[rtail];
-		tail = (rtail + 1) % size;
+		uint32_t rtail_next{rtail + 1};
+		if (rtail_next >= size) rtail_next = 0;
+		tail = rtail_next;
 		return true;
 	}
+	std::size_t read(uint8_t *data, std::size_t length)
+	{
+		if (not size) return 0;
+		const uint32_t rhead{head};
+		const uint32_t rtail{tail};
+		const uint32_t used{((rhead >= rtail) ? 0 : size) + rhead - rtail};
+		length = std::min<std::size_t>(length, used);
+		// only read the data after the debugger has published the head
+		__DMB();
+		const std::size_t chunk = std::min<std::size_t>(length, size - rtail);
+		std::memcpy(data, buffer + rtail, chunk);
+		std::memcpy(data + chunk, buffer, length - chunk);
+		uint32_t rtail_next{rtail + uint32_t(length)};
+		if (rtail_next >= size) rtail_next -= size;
+		tail = rtail_next;
+		return length;
+	}
 	bool isEmpty() const { return (head == tail); }
 	uint32_t getSize() const
 	{
 		const uint32_t rhead{head};
 		const uint32_t rtail{tail};
-		return ((rhead > rtail) ? 0 : size) + rhead - rtail;
+		return ((rhead >= rtail) ? 0 : size) + rhead - rtail;
 	}
 } modm_packed;
 
 static uint8_t tx_data_buffer_0[512];
+static uint8_t tx_data_buffer_1[2048];
+static uint8_t tx_data_buffer_2[512];
+static uint8_t tx_data_buffer_3[1024];
 static uint8_t rx_data_buffer_0[16];
+static uint8_t rx_data_buffer_2[256];
 
 struct RttControlBlock
 {
 	const char identifier[16];
 	const int32_t tx_buffer_count;
 	const int32_t rx_buffer_count;
-	RttBuffer tx_buffers[1];
-	RttBuffer rx_buffers[1];
+	RttBuffer tx_buffers[4];
+	RttBuffer rx_buffers[4];
 } modm_packed;
 
 // Explicitly constructed as constinit to force *only* copying via .data section.
@@ -70,19 +116,25 @@ struct RttControlBlock
 // found by OpenOCD accidentally instead of the real RTT control block.
 static constinit RttControlBlock rtt_control{
 	"SEGGER RTT",
-	1,
-	1,
+	4,
+	4,
 	{
 		{"tx0", tx_data_buffer_0, 512, 0,0,0 },
+		{"tx1", tx_data_buffer_1, 2048, 0,0,0 },
+		{"tx2", tx_data_buffer_2, 512, 0,0,0 },
+		{"tx3", tx_data_buffer_3, 1024, 0,0,0 },
 	},{
 		{"rx0", rx_data_buffer_0, 16, 0,0,0 },
+		{"rx1", nullptr, 0, 0,0,0 },
+		{"rx2", rx_data_buffer_2, 256, 0,0,0 },
+		{"rx3", nullptr, 0, 0,0,0 },
 	}
 };
 
 
 Rtt::Rtt(uint8_t channel)
-:	tx_buffer(rtt_control.tx_buffers[std::min<uint8_t>(channel, 0)]),
-	rx_buffer(rtt_control.rx_buffers[std::min<uint8_t>(channel, 0)])
+:	tx_buffer(rtt_control.tx_buffers[std::min<uint8_t>(channel, Channels - 1)]),
+	rx_buffer(rtt_control.rx_buffers[std::min<uint8_t>(channel, Channels - 1)])
 {
 }
 
@@ -95,11 +147,7 @@ Rtt::write(uint8_t data)
 std::size_t
 Rtt::write(const uint8_t *data, std::size_t length)
 {
-	std::size_t sent = 0;
-	for (; sent < length; sent++)
-		if (not write(*data++))
-			return sent;
-	return sent;
+	return tx_buffer.write(data, length);
 }
 
 bool
@@ -123,11 +171,7 @@ Rtt::read(uint8_t& data)
 std::size_t
 Rtt::read(uint8_t *data, std::size_t length)
 {
-	uint32_t i = 0;
-	for (; i < length; ++i)
-		if (not rx_buffer.read(*data++))
-			return i;
-	return i;
+	return rx_buffer.read(data, length);
 }
 
 std::size_t
@@ -29,6 +29,9 @@ class Rtt : public ::modm::Uart
 	RttBuffer& rx_buffer;
 
 public:
+	/// Number of configured channels, larger channel indices use the last one
+	static constexpr uint8_t Channels = 4;
+
 	Rtt(uint8_t channel);
 
 	inline void
@@ -37,7 +40,14 @@ public:
 
 	inline void
 	writeBlocking(const uint8_t *data, std::size_t length)
-	{ while (length--) writeBlocking(*data++); }
+	{
+		while (length)
+		{
+			const std::size_t written = write(data, length);
+			data += written;
+			length -= written;
+		}
+	}
 
 	inline void
 	flushWriteBuffer() {}
@@ -15,6 +15,35 @@
 // ----------------------------------------------------------------------------
 
 #include "spi_master_1.hpp"
+#include <modm/architecture/interface/interrupt.hpp>
+#include <modm/processing/fiber/event_flags.hpp>
+
+namespace
+{
+	// block transfer driven by the interrupt, one byte is in flight
+	const uint8_t *transferTx(nullptr);
+	uint8_t *transferRx(nullptr);
+	std::size_t transferLength(0);
+	std::size_t transferIndex(0);
+	modm::fiber::event_flags transferDone;
+}
+
+MODM_ISR(SPI1)
+{
+	using modm::platform::SpiHal1;
+	uint8_t data;
+	SpiHal1::read(data);
+	if (transferRx) transferRx[transferIndex] = data;
+	if (++transferIndex < transferLength)
+	{
+		SpiHal1::write(transferTx ? transferTx[transferIndex] : uint8_t(0));
+	}
+	else
+	{
+		SpiHal1::disableInterrupt(SpiHal1::Interrupt::RxBufferNotEmpty);
+		transferDone.set(1);
+	}
+}
 
 modm::ResumableResult<uint8_t>
 modm::platform::SpiMaster1::transfer(uint8_t data)
@@ -40,11 +69,32 @@ modm::ResumableResult<void>
 modm::platform::SpiMaster1::transfer(
 		const uint8_t * tx, uint8_t * rx, std::size_t length)
 {
-	for (std::size_t index = 0; index < length; index++)
+	if (length == 0) return;
+	// at high baudrates the interrupt per byte costs more than polling
+	const bool interrupt = byteCycles > InterruptCycles and
+			length > SuspendCycles / (byteCycles - InterruptCycles);
+	if (not interrupt or __get_IPSR() or __get_PRIMASK())
 	{
-		// if tx == 0, we use a dummy byte 0x00 else we copy it from the array
-		auto result = transfer(tx ? tx[index] : 0);
-		// if rx != 0, we copy the result into the array
-		if (rx) rx[index] = result;
+		// the interrupt does not pay off or cannot preempt the caller
+		for (std::size_t index = 0; index < length; index++)
+		{
+			while(!SpiHal1::isTransmitRegisterEmpty()) ;
+			// if tx == 0, we use a dummy byte 0x00 else we copy it from the array
+			SpiHal1::write(tx ? tx[index] : uint8_t(0));
+			while(!SpiHal1::isReceiveRegisterNotEmpty()) ;
+			uint8_t data;
+			SpiHal1::read(data);
+			// if rx != 0, we copy the result into the array
+			if (rx) rx[index] = data;
+		}
+		return;
 	}
-}
\ No newline at end of file
+
+	transferTx = tx;
+	transferRx = rx;
+	transferLength = length;
+	transferIndex = 0;
+	SpiHal1::enableInterrupt(SpiHal1::Interrupt::RxBufferNotEmpty);
+	SpiHal1::write(tx ? tx[0] : uint8_t(0));
+	transferDone.wait_any(1);
+}
@@ -33,7 +33,10 @@ namespace platform
 /**
  * Serial peripheral interface (SPI1).
  *
- * Simple unbuffered implementation.
+ * Simple unbuffered implementation. Block transfers from a fiber are driven
+ * by the SPI interrupt, which suspends the fiber until the last byte has been
+ * received. An interrupt per byte only pays off for slow baudrates and long
+ * blocks, all other transfers are polled.
  *
  * @author	Niklas Hauser
  * @ingroup	modm_platform_spi modm_platform_spi_1
@@ -45,9 +48,16 @@ protected:
 	// Bit0: single transfer state
 	// Bit1: block transfer state
 	static inline uint8_t state{0};
+	/// core cycles to transfer one byte at the configured baudrate
+	static inline uint32_t byteCycles{0};
 public:
 	using Hal = SpiHal1;
 
+	/// Core cycles of one interrupt to receive a byte and send the next one.
+	static constexpr uint32_t InterruptCycles = 160;
+	/// Core cycles to suspend and resume the fiber that waits for a block.
+	static constexpr uint32_t SuspendCycles = 600;
+
 	/// Spi Data Mode, Mode0 is the most common mode
 	enum class
 	DataMode : uint32_t
@@ -88,16 +98,18 @@ public:
 
 	template< class SystemClock, baudrate_t baudrate, percent_t tolerance=pct(5) >
 	static void
-	initialize()
+	initialize(uint8_t isrPriority = 10u)
 	{
 		constexpr auto result = modm::Prescaler::from_power(SystemClock::Spi1, baudrate, 2, 256);
 		assertBaudrateInTolerance< result.frequency, baudrate, tolerance >();
 
 		// translate the prescaler into the bitmapping
 		constexpr SpiHal1::Prescaler prescaler{result.index << SPI_CR1_BR_Pos};
+		byteCycles = 8 * SystemClock::Frequency / result.frequency;
 
 		// initialize the Spi
 		SpiHal1::initialize(prescaler);
+		SpiHal1::enableInterruptVector(true, isrPriority);
 		state = 0;
 	}
 
@@ -140,6 +152,19 @@ public:
 	static modm::ResumableResult<uint8_t>
 	transfer(uint8_t data);
 
+	/**
+	 * Transfers a block of bytes.
+	 *
+	 * In thread mode, the SPI interrupt exchanges the bytes and the calling
+	 * fiber is suspended until the transfer has finished, so other fibers can
+	 * run in the meantime. This is only done if the time of the bytes minus
+	 * `InterruptCycles` per byte exceeds `SuspendCycles`, so that the
+	 * interrupt frees CPU time. Otherwise, in an interrupt, or with interrupts
+	 * disabled, the bytes are transferred by polling.
+	 *
+	 * @param	tx	bytes to send or `nullptr` to send zeros
+	 * @param	rx	buffer for the received bytes or `nullptr` to discard them
+	 */
 	static modm::ResumableResult<void>
 	transfer(const uint8_t *tx, uint8_t *rx, std::size_t length);
 };
@@ -0,0 +1,884 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+#include <modm/architecture/interface/uart.hpp>
+
+namespace modm::platform
+{
+
+/// @cond
+namespace otg
+{
+
+// Register offsets of the Synopsys OTG core
+enum Register : uint32_t
+{
+	GAHBCFG = 0x008,
+	GUSBCFG = 0x00C,
+	GRSTCTL = 0x010,
+	GINTSTS = 0x014,
+	GINTMSK = 0x018,
+	GRXSTSP = 0x020,
+	GRXFSIZ = 0x024,
+	DIEPTXF0 = 0x028,
+	GCCFG = 0x038,
+	DIEPTXF1 = 0x104,
+	DCFG = 0x800,
+	DCTL = 0x804,
+	DIEPMSK = 0x810,
+	DOEPMSK = 0x814,
+	DAINT = 0x818,
+	DAINTMSK = 0x81C,
+	DIEPEMPMSK = 0x834,
+	PCGCCTL = 0xE00,
+};
+
+constexpr uint32_t DIEPCTL(uint8_t ep) { return 0x900 + 0x20 * ep; }
+constexpr uint32_t DIEPINT(uint8_t ep) { return 0x908 + 0x20 * ep; }
+constexpr uint32_t DIEPTSIZ(uint8_t ep) { return 0x910 + 0x20 * ep; }
+constexpr uint32_t DTXFSTS(uint8_t ep) { return 0x918 + 0x20 * ep; }
+constexpr uint32_t DOEPCTL(uint8_t ep) { return 0xB00 + 0x20 * ep; }
+constexpr uint32_t DOEPINT(uint8_t ep) { return 0xB08 + 0x20 * ep; }
+constexpr uint32_t DOEPTSIZ(uint8_t ep) { return 0xB10 + 0x20 * ep; }
+constexpr uint32_t FIFO(uint8_t ep) { return 0x1000 + 0x1000 * ep; }
+
+enum Bit : uint32_t
+{
+	GAHBCFG_GINT = 1ul << 0,
+	GUSBCFG_PHYSEL = 1ul << 6,
+	GUSBCFG_TRDT = 0xful << 10,
+	GUSBCFG_FDMOD = 1ul << 30,
+	GRSTCTL_CSRST = 1ul << 0,
+	GRSTCTL_RXFFLSH = 1ul << 4,
+	GRSTCTL_TXFFLSH = 1ul << 5,
+	GRSTCTL_TXFNUM_ALL = 0x10ul << 6,
+	GRSTCTL_AHBIDL = 1ul << 31,
+	GINT_RXFLVL = 1ul << 4,
+	GINT_USBSUSP = 1ul << 11,
+	GINT_USBRST = 1ul << 12,
+	GINT_ENUMDNE = 1ul << 13,
+	GINT_IEPINT = 1ul << 18,
+	GINT_OEPINT = 1ul << 19,
+	GINT_WKUPINT = 1ul << 31,
+	GCCFG_PWRDWN = 1ul << 16,
+	DCFG_DSPD_FULL = 3ul << 0,
+	DCFG_DAD = 0x7ful << 4,
+	DCTL_SDIS = 1ul << 1,
+	DCTL_CGINAK = 1ul << 8,
+	EPCTL_USBAEP = 1ul << 15,
+	EPCTL_BULK = 2ul << 18,
+	EPCTL_INTERRUPT = 3ul << 18,
+	EPCTL_STALL = 1ul << 21,
+	EPCTL_CNAK = 1ul << 26,
+	EPCTL_SNAK = 1ul << 27,
+	EPCTL_SD0PID = 1ul << 28,
+	EPCTL_EPENA = 1ul << 31,
+	EPINT_XFRC = 1ul << 0,
+	DOEPINT_STUP = 1ul << 3,
+	DIEPINT_TXFE = 1ul << 7,
+	TSIZ_PKTCNT_1 = 1ul << 19,
+	DOEPTSIZ_STUPCNT_3 = 3ul << 29,
+};
+
+constexpr uint32_t EPCTL_TXFNUM(uint8_t fifo) { return uint32_t(fifo) << 22; }
+
+enum class
+Packet : uint8_t
+{
+	OutData = 2,
+	OutComplete = 3,
+	SetupComplete = 4,
+	SetupData = 6,
+};
+
+} // namespace otg
+/// @endcond
+
+/**
+ * USB CDC-ACM device on the Synopsys OTG core.
+ *
+ * Enumerates as virtual serial port and implements the `modm::Uart`
+ * interface, so that loggers, telemetry and the parameter protocol can use it
+ * instead of a debug probe. The baudrate set by the host is ignored.
+ *
+ * Transmitted data is buffered in a ring and sent as multi-packet bulk IN
+ * transfers of up to 16 packets. The IN FIFO holds eight packets, so the
+ * interrupt refills it while the previous packets are being sent. A transfer
+ * that ends on a packet boundary is terminated by a zero length packet.
+ * Received bulk OUT packets are copied from the shared RX FIFO directly into
+ * the receive ring. The OUT endpoint is armed for as many packets as fit into
+ * the ring, otherwise it NAKs until `read()` frees enough space.
+ *
+ * All register accesses go through the `Registers` policy with the static
+ * functions `read(offset)`, `write(offset, value)`, `delay()` for the
+ * 25 ms mode switch, `enableInterrupt()`, `serialNumber()` and a `Lock` type
+ * that blocks the USB interrupt. Thus the protocol state machine runs on the
+ * host against a simulated register model as well as on the target. The
+ * application calls `handleInterrupt()` from the interrupt of the core.
+ *
+ * @code
+ * Board::initializeUsbFs();
+ * UsbCdcAcm::initialize();
+ *
+ * modm::IODeviceWrapper<UsbCdcAcm, modm::IOBuffer::DiscardIfFull> usb_device;
+ * @endcode
+ *
+ * @tparam	Registers		register access policy
+ * @tparam	TxBufferSize	transmit ring size, a power of two
+ * @tparam	RxBufferSize	receive ring size, a power of two of at least 64
+ *
+ * @ingroup	modm_platform_usb_fs
+ */
+template< class Registers, std::size_t TxBufferSize, std::size_t RxBufferSize >
+class CdcAcmDevice : public ::modm::Uart
+{
+	static_assert(std::has_single_bit(TxBufferSize), "The transmit buffer size must be a power of two!");
+	static_assert(std::has_single_bit(RxBufferSize) and RxBufferSize >= 64,
+				  "The receive buffer size must be a power of two of at least 64 bytes!");
+
+	static constexpr uint8_t DataOut = 1;
+	static constexpr uint8_t DataIn = 1;
+	static constexpr uint8_t Notification = 2;
+	static constexpr uint16_t PacketSize = 64;
+	static constexpr uint16_t MaxPackets = 16;
+
+public:
+	/// Line coding as set by the host.
+	struct LineCoding
+	{
+		uint32_t baudrate;
+		uint8_t stop_bits;
+		uint8_t parity;
+		uint8_t data_bits;
+	};
+
+	/// Resets and configures the OTG core and connects to the bus.
+	/// The clock and the pins must be initialized, e.g. with `Board::initializeUsbFs()`.
+	static void
+	initialize()
+	{
+		using namespace otg;
+		wait(GRSTCTL, GRSTCTL_AHBIDL, GRSTCTL_AHBIDL);
+		Registers::write(GRSTCTL, GRSTCTL_CSRST);
+		wait(GRSTCTL, GRSTCTL_CSRST, 0);
+
+		// Device mode with the internal full speed PHY, turnaround time for AHB > 32MHz
+		Registers::write(GUSBCFG, (Registers::read(GUSBCFG) & ~GUSBCFG_TRDT) |
+				GUSBCFG_FDMOD | GUSBCFG_PHYSEL | (6ul << 10));
+		Registers::delay();
+		set(DCTL, DCTL_SDIS);
+		// keep the VBUS sensing configuration of the board
+		set(GCCFG, GCCFG_PWRDWN);
+		Registers::write(PCGCCTL, 0);
+		Registers::write(DCFG, (Registers::read(DCFG) & ~(DCFG_DAD | 3ul)) | DCFG_DSPD_FULL);
+
+		// FIFO RAM in words: RX 128, EP0 16, data IN 128 (8 packets), notification 16
+		Registers::write(GRXFSIZ, 128);
+		Registers::write(DIEPTXF0, (16ul << 16) | 128);
+		Registers::write(DIEPTXF1 + 4 * (DataIn - 1), (128ul << 16) | 144);
+		Registers::write(DIEPTXF1 + 4 * (Notification - 1), (16ul << 16) | 272);
+		flushFifos();
+
+		Registers::write(GINTSTS, 0xffff'ffff);
+		Registers::write(GINTMSK, GINT_USBRST | GINT_ENUMDNE | GINT_RXFLVL |
+				GINT_IEPINT | GINT_OEPINT | GINT_USBSUSP | GINT_WKUPINT);
+		Registers::write(GAHBCFG, GAHBCFG_GINT);
+		Registers::enableInterrupt();
+		clear(DCTL, DCTL_SDIS);
+	}
+
+	/// `true` if the host has configured the device.
+	static bool
+	isConfigured()
+	{ return configured; }
+
+	/// `true` if a terminal on the host has opened the port (DTR set).
+	static bool
+	isTerminalConnected()
+	{ return configured and (control_line_state & 1); }
+
+	static LineCoding
+	getLineCoding()
+	{
+		LineCoding coding;
+		std::memcpy(&coding.baudrate, line_coding, 4);
+		coding.stop_bits = line_coding[4];
+		coding.parity = line_coding[5];
+		coding.data_bits = line_coding[6];
+		return coding;
+	}
+
+	static void
+	writeBlocking(uint8_t data)
+	{ while (not write(data)) ; }
+
+	static void
+	writeBlocking(const uint8_t *data, std::size_t length)
+	{
+		while (length)
+		{
+			const std::size_t written = write(data, length);
+			data += written;
+			length -= written;
+		}
+	}
+
+	static void
+	flushWriteBuffer()
+	{ while (configured and not isWriteFinished()) ; }
+
+	static bool
+	write(uint8_t data)
+	{ return write(&data, 1); }
+
+	static std::size_t
+	write(const uint8_t *data, std::size_t length)
+	{
+		const uint32_t head = tx_head.load(std::memory_order_relaxed);
+		length = std::min<std::size_t>(length, TxBufferSize - (head - tx_tail.load(std::memory_order_acquire)));
+		const uint32_t index = head & (TxBufferSize - 1);
+		const std::size_t first = std::min<std::size_t>(length, TxBufferSize - index);
+		std::memcpy(tx_buffer + index, data, first);
+		std::memcpy(tx_buffer, data + first, length - first);
+		tx_head.store(head + length, std::memory_order_release);
+		if (length and not tx_busy)
+		{
+			typename Registers::Lock lock;
+			transmit();
+		}
+		return length;
+	}
+
+	static bool
+	isWriteFinished()
+	{ return tx_head.load(std::memory_order_relaxed) == tx_tail.load(std::memory_order_relaxed) and not tx_busy; }
+
+	static std::size_t
+	transmitBufferSize()
+	{ return tx_head.load(std::memory_order_relaxed) - tx_tail.load(std::memory_order_relaxed); }
+
+	static std::size_t
+	discardTransmitBuffer()
+	{
+		typename Registers::Lock lock;
+		// keep the data of the transfer in progress
+		const uint32_t tail = tx_tail.load(std::memory_order_relaxed) + (tx_busy ? tx_transfer : 0);
+		const std::size_t discarded = tx_head.load(std::memory_order_relaxed) - tail;
+		tx_head.store(tail, std::memory_order_relaxed);
+		return discarded;
+	}
+
+	static bool
+	read(uint8_t &data)
+	{ return read(&data, 1); }
+
+	static std::size_t
+	read(uint8_t *data, std::size_t length)
+	{
+		const uint32_t tail = rx_tail.load(std::memory_order_relaxed);
+		length = std::min<std::size_t>(length, rx_head.load(std::memory_order_acquire) - tail);
+		const uint32_t index = tail & (RxBufferSize - 1);
+		const std::size_t first = std::min<std::size_t>(length, RxBufferSize - index);
+		std::memcpy(data, rx_buffer + index, first);
+		std::memcpy(data + first, rx_buffer, length - first);
+		rx_tail.store(tail + length, std::memory_order_release);
+		if (length and not rx_armed)
+		{
+			typename Registers::Lock lock;
+			receive();
+		}
+		return length;
+	}
+
+	static std::size_t
+	receiveBufferSize()
+	{ return rx_head.load(std::memory_order_relaxed) - rx_tail.load(std::memory_order_relaxed); }
+
+	static std::size_t
+	discardReceiveBuffer()
+	{
+		const std::size_t discarded = receiveBufferSize();
+		rx_tail.fetch_add(discarded, std::memory_order_release);
+		if (not rx_armed)
+		{
+			typename Registers::Lock lock;
+			receive();
+		}
+		return discarded;
+	}
+
+	static bool
+	hasError()
+	{ return false; }
+
+	static void
+	clearError() {}
+
+	/// Must be called from the OTG interrupt.
+	static void
+	handleInterrupt()
+	{
+		using namespace otg;
+		const uint32_t status = Registers::read(GINTSTS) & Registers::read(GINTMSK);
+
+		if (status & GINT_USBRST)
+		{
+			Registers::write(GINTSTS, GINT_USBRST);
+			reset();
+		}
+		if (status & GINT_ENUMDNE)
+		{
+			Registers::write(GINTSTS, GINT_ENUMDNE);
+			// EP0 max packet size of 64 bytes
+			clear(DIEPCTL(0), 3ul);
+			set(DCTL, DCTL_CGINAK);
+		}
+		if (status & GINT_RXFLVL)
+		{
+			while (Registers::read(GINTSTS) & GINT_RXFLVL) popPacket();
+		}
+		if (status & GINT_OEPINT)
+		{
+			const uint32_t endpoints = Registers::read(DAINT) & Registers::read(DAINTMSK);
+			if (endpoints & (1ul << 16)) handleOut0();
+			if (endpoints & (1ul << (16 + DataOut))) handleDataOut();
+		}
+		if (status & GINT_IEPINT)
+		{
+			const uint32_t endpoints = Registers::read(DAINT) & Registers::read(DAINTMSK);
+			if (endpoints & (1ul << 0)) handleIn0();
+			if (endpoints & (1ul << DataIn)) handleDataIn();
+			if (endpoints & (1ul << Notification))
+				Registers::write(DIEPINT(Notification), Registers::read(DIEPINT(Notification)));
+		}
+		if (status & (GINT_USBSUSP | GINT_WKUPINT))
+			Registers::write(GINTSTS, status & (GINT_USBSUSP | GINT_WKUPINT));
+	}
+
+private:
+	enum class
+	Request : uint8_t
+	{
+		GetStatus = 0x00,
+		ClearFeature = 0x01,
+		SetFeature = 0x03,
+		SetAddress = 0x05,
+		GetDescriptor = 0x06,
+		GetConfiguration = 0x08,
+		SetConfiguration = 0x09,
+		GetInterface = 0x0A,
+		SetInterface = 0x0B,
+		SetLineCoding = 0x20,
+		GetLineCoding = 0x21,
+		SetControlLineState = 0x22,
+		SendBreak = 0x23,
+	};
+
+	static constexpr uint8_t device_descriptor[] =
+	{
+		18, 0x01, 0x00, 0x02,		// USB 2.0
+		0xEF, 0x02, 0x01, 64,		// composite with IAD, EP0 64 bytes
+		0x83, 0x04, 0x40, 0x57,		// VID 0x0483, PID 0x5740
+		0x00, 0x02, 1, 2, 3, 1,		// device 2.00, strings, 1 configuration
+	};
+
+	static constexpr uint8_t configuration_descriptor[] =
+	{
+		9, 0x02, 75, 0, 2, 1, 0, 0x80, 50,		// 2 interfaces, bus powered 100mA
+		8, 0x0B, 0, 2, 0x02, 0x02, 0x01, 0,		// interface association
+		9, 0x04, 0, 0, 1, 0x02, 0x02, 0x01, 0,	// communication interface
+		5, 0x24, 0x00, 0x10, 0x01,				// header, CDC 1.10
+		5, 0x24, 0x01, 0x00, 1,					// call management
+		4, 0x24, 0x02, 0x02,					// ACM: line coding and state
+		5, 0x24, 0x06, 0, 1,					// union
+		7, 0x05, 0x80 | Notification, 0x03, 16, 0, 16,
+		9, 0x04, 1, 0, 2, 0x0A, 0, 0, 0,		// data interface
+		7, 0x05, DataOut, 0x02, PacketSize, 0, 0,
+		7, 0x05, 0x80 | DataIn, 0x02, PacketSize, 0, 0,
+	};
+	static_assert(sizeof(configuration_descriptor) == 75);
+
+	static constexpr const char *strings[] = {"modm", "Virtual COM Port"};
+
+	// --------------------------------------------------------------------------
+	static void
+	set(uint32_t offset, uint32_t mask)
+	{ Registers::write(offset, Registers::read(offset) | mask); }
+
+	static void
+	clear(uint32_t offset, uint32_t mask)
+	{ Registers::write(offset, Registers::read(offset) & ~mask); }
+
+	static void
+	wait(uint32_t offset, uint32_t mask, uint32_t value)
+	{
+		for (uint32_t timeout = 100'000; timeout and (Registers::read(offset) & mask) != value; timeout--) ;
+	}
+
+	static void
+	flushFifos()
+	{
+		using namespace otg;
+		Registers::write(GRSTCTL, GRSTCTL_TXFFLSH | GRSTCTL_TXFNUM_ALL);
+		wait(GRSTCTL, GRSTCTL_TXFFLSH, 0);
+		Registers::write(GRSTCTL, GRSTCTL_RXFFLSH);
+		wait(GRSTCTL, GRSTCTL_RXFFLSH, 0);
+	}
+
+	static void
+	writeFifo(uint8_t ep, const uint8_t *data, std::size_t length)
+	{
+		for (std::size_t ii = 0; ii < length; ii += 4)
+		{
+			uint32_t word = 0;
+			std::memcpy(&word, data + ii, std::min<std::size_t>(4, length - ii));
+			Registers::write(otg::FIFO(ep), word);
+		}
+	}
+
+	static void
+	reset()
+	{
+		using namespace otg;
+		configured = false;
+		control_line_state = 0;
+		tx_busy = false;
+		rx_armed = false;
+		ep0_state = Ep0::Idle;
+		for (uint8_t ep = 0; ep < 4; ep++)
+		{
+			set(DOEPCTL(ep), EPCTL_SNAK);
+			Registers::write(DIEPINT(ep), 0xff);
+			Registers::write(DOEPINT(ep), 0xff);
+		}
+		clear(DIEPCTL(DataIn), EPCTL_USBAEP);
+		clear(DOEPCTL(DataOut), EPCTL_USBAEP);
+		clear(DIEPCTL(Notification), EPCTL_USBAEP);
+		flushFifos();
+		clear(DCFG, DCFG_DAD);
+		Registers::write(DAINTMSK, (1ul << 16) | (1ul << 0));
+		Registers::write(DOEPMSK, EPINT_XFRC | DOEPINT_STUP);
+		Registers::write(DIEPMSK, EPINT_XFRC);
+		Registers::write(DIEPEMPMSK, 0);
+		armSetup();
+	}
+
+	static void
+	armSetup()
+	{
+		using namespace otg;
+		Registers::write(DOEPTSIZ(0), DOEPTSIZ_STUPCNT_3 | TSIZ_PKTCNT_1 | PacketSize);
+		set(DOEPCTL(0), EPCTL_CNAK | EPCTL_EPENA);
+	}
+
+	static void
+	stall()
+	{
+		using namespace otg;
+		set(DIEPCTL(0), EPCTL_STALL);
+		set(DOEPCTL(0), EPCTL_STALL);
+		ep0_state = Ep0::Idle;
+	}
+
+	/// Pops one entry of the shared RX FIFO.
+	static void
+	popPacket()
+	{
+		using namespace otg;
+		const uint32_t status = Registers::read(GRXSTSP);
+		const uint8_t ep = status & 0xf;
+		const uint16_t count = (status >> 4) & 0x7ff;
+		const auto packet = Packet((status >> 17) & 0xf);
+
+		if (packet == Packet::SetupData or (packet == Packet::OutData and ep == 0))
+		{
+			uint8_t *destination = (packet == Packet::SetupData) ? setup : ep0_buffer;
+			const std::size_t limit = (packet == Packet::SetupData) ? sizeof(setup) : sizeof(ep0_buffer);
+			for (std::size_t ii = 0; ii < count; ii += 4)
+			{
+				const uint32_t word = Registers::read(FIFO(0));
+				if (ii < limit) std::memcpy(destination + ii, &word, std::min<std::size_t>(4, limit - ii));
+			}
+			if (packet == Packet::OutData) ep0_received = std::min<std::size_t>(count, limit);
+		}
+		else if (packet == Packet::OutData)
+		{
+			uint32_t head = rx_head.load(std::memory_order_relaxed);
+			for (std::size_t ii = 0; ii < count; ii += 4)
+			{
+				const uint32_t word = Registers::read(FIFO(0));
+				for (std::size_t byte = 0; byte < 4 and ii + byte < count; byte++)
+					rx_buffer[head++ & (RxBufferSize - 1)] = uint8_t(word >> (8 * byte));
+			}
+			rx_head.store(head, std::memory_order_release);
+		}
+	}
+
+	// --------------------------------------------------------------------------
+	static void
+	handleOut0()
+	{
+		using namespace otg;
+		const uint32_t interrupts = Registers::read(DOEPINT(0));
+		Registers::write(DOEPINT(0), interrupts);
+		if (interrupts & DOEPINT_STUP)
+		{
+			handleSetup();
+		}
+		else if (interrupts & EPINT_XFRC)
+		{
+			if (ep0_state == Ep0::DataOut)
+			{
+				if (Request(setup[1]) == Request::SetLineCoding)
+					std::memcpy(line_coding, ep0_buffer, std::min<std::size_t>(ep0_received, sizeof(line_coding)));
+				ep0_state = Ep0::Idle;
+				sendStatus();
+			}
+		}
+		armSetup();
+	}
+
+	static void
+	handleIn0()
+	{
+		using namespace otg;
+		const uint32_t interrupts = Registers::read(DIEPINT(0));
+		Registers::write(DIEPINT(0), interrupts);
+		if ((interrupts & EPINT_XFRC) and ep0_state == Ep0::DataIn) sendControl();
+	}
+
+	static void
+	handleSetup()
+	{
+		const uint8_t type = setup[0];
+		const auto request = Request(setup[1]);
+		const uint16_t value = setup[2] | (setup[3] << 8);
+		const uint16_t length = setup[6] | (setup[7] << 8);
+
+		ep0_state = Ep0::Idle;
+		if ((type & 0x60) == 0x00) handleStandard(request, value, length);
+		else if ((type & 0x60) == 0x20) handleClass(request, value, length);
+		else stall();
+	}
+
+	static void
+	handleStandard(Request request, uint16_t value, uint16_t length)
+	{
+		using namespace otg;
+		static constexpr uint8_t zero[2]{};
+		switch (request)
+		{
+			case Request::GetDescriptor:
+				return sendDescriptor(value, length);
+			case Request::SetAddress:
+				Registers::write(DCFG, (Registers::read(DCFG) & ~DCFG_DAD) | ((value & 0x7f) << 4));
+				return sendStatus();
+			case Request::SetConfiguration:
+				if (value > 1) return stall();
+				configure(value == 1);
+				return sendStatus();
+			case Request::GetConfiguration:
+				ep0_buffer[0] = configured;
+				return sendControl(ep0_buffer, 1, length);
+			case Request::GetStatus:
+				return sendControl(zero, 2, length);
+			case Request::GetInterface:
+				return sendControl(zero, 1, length);
+			case Request::SetInterface:
+				return sendStatus();
+			case Request::ClearFeature:
+			case Request::SetFeature:
+				if ((setup[0] & 0x1f) == 0x02 and value == 0)
+				{
+					// endpoint halt
+					const uint8_t ep = setup[4] & 0x0f;
+					const uint32_t control = (setup[4] & 0x80) ? DIEPCTL(ep) : DOEPCTL(ep);
+					if (ep == 0 or ep > Notification) return stall();
+					if (request == Request::SetFeature) set(control, EPCTL_STALL);
+					else Registers::write(control, (Registers::read(control) & ~EPCTL_STALL) | EPCTL_SD0PID);
+				}
+				return sendStatus();
+			default:
+				return stall();
+		}
+	}
+
+	static void
+	handleClass(Request request, uint16_t value, uint16_t length)
+	{
+		switch (request)
+		{
+			case Request::SetLineCoding:
+				if (length == 0) return sendStatus();
+				ep0_state = Ep0::DataOut;
+				return;
+			case Request::GetLineCoding:
+				return sendControl(line_coding, sizeof(line_coding), length);
+			case Request::SetControlLineState:
+				control_line_state = value;
+				return sendStatus();
+			case Request::SendBreak:
+				return sendStatus();
+			default:
+				return stall();
+		}
+	}
+
+	static void
+	sendDescriptor(uint16_t value, uint16_t length)
+	{
+		const uint8_t index = value & 0xff;
+		switch (value >> 8)
+		{
+			case 0x01:
+				return sendControl(device_descriptor, sizeof(device_descriptor), length);
+			case 0x02:
+				return sendControl(configuration_descriptor, sizeof(configuration_descriptor), length);
+			case 0x03:
+			{
+				uint8_t size = 2;
+				if (index == 0)
+				{
+					// US English
+					ep0_buffer[size++] = 0x09;
+					ep0_buffer[size++] = 0x04;
+				}
+				else if (index <= std::size(strings))
+				{
+					for (const char *c = strings[index - 1]; *c and size < sizeof(ep0_buffer); c++)
+					{
+						ep0_buffer[size++] = *c;
+						ep0_buffer[size++] = 0;
+					}
+				}
+				else if (index == 3)
+				{
+					uint32_t serial = Registers::serialNumber();
+					for (uint8_t ii = 0; ii < 8; ii++, serial <<= 4)
+					{
+						ep0_buffer[size++] = "0123456789ABCDEF"[serial >> 28];
+						ep0_buffer[size++] = 0;
+					}
+				}
+				else return stall();
+				ep0_buffer[0] = size;
+				ep0_buffer[1] = 0x03;
+				return sendControl(ep0_buffer, size, length);
+			}
+			default:
+				return stall();
+		}
+	}
+
+	/// Starts the data stage of a control read.
+	static void
+	sendControl(const uint8_t *data, std::size_t size, uint16_t length)
+	{
+		ep0_data = data;
+		ep0_remaining = std::min<std::size_t>(size, length);
+		// a short transfer must be terminated by a short packet
+		ep0_zlp = ep0_remaining < length and (ep0_remaining % PacketSize) == 0;
+		ep0_state = Ep0::DataIn;
+		sendControl();
+	}
+
+	static void
+	sendControl()
+	{
+		using namespace otg;
+		if (ep0_remaining == 0 and not ep0_zlp)
+		{
+			ep0_state = Ep0::Idle;
+			return;
+		}
+		const std::size_t chunk = std::min<std::size_t>(ep0_remaining, PacketSize);
+		if (chunk == 0) ep0_zlp = false;
+		Registers::write(DIEPTSIZ(0), TSIZ_PKTCNT_1 | chunk);
+		set(DIEPCTL(0), EPCTL_CNAK | EPCTL_EPENA);
+		writeFifo(0, ep0_data, chunk);
+		ep0_data += chunk;
+		ep0_remaining -= chunk;
+	}
+
+	/// Sends the zero length status packet of a control write.
+	static void
+	sendStatus()
+	{
+		using namespace otg;
+		Registers::write(DIEPTSIZ(0), TSIZ_PKTCNT_1);
+		set(DIEPCTL(0), EPCTL_CNAK | EPCTL_EPENA);
+	}
+
+	static void
+	configure(bool enable)
+	{
+		using namespace otg;
+		configured = false;
+		tx_busy = false;
+		rx_armed = false;
+		if (not enable)
+		{
+			clear(DIEPCTL(DataIn), EPCTL_USBAEP);
+			clear(DOEPCTL(DataOut), EPCTL_USBAEP);
+			clear(DIEPCTL(Notification), EPCTL_USBAEP);
+			Registers::write(DAINTMSK, (1ul << 16) | (1ul << 0));
+			return;
+		}
+		Registers::write(DIEPCTL(DataIn), EPCTL_USBAEP | EPCTL_BULK |
+				EPCTL_TXFNUM(DataIn) | EPCTL_SD0PID | EPCTL_SNAK | PacketSize);
+		Registers::write(DOEPCTL(DataOut), EPCTL_USBAEP | EPCTL_BULK |
+				EPCTL_SD0PID | EPCTL_SNAK | PacketSize);
+		Registers::write(DIEPCTL(Notification), EPCTL_USBAEP | EPCTL_INTERRUPT |
+				EPCTL_TXFNUM(Notification) | EPCTL_SD0PID | EPCTL_SNAK | 16);
+		Registers::write(DAINTMSK, (1ul << 16) | (1ul << (16 + DataOut)) |
+				(1ul << 0) | (1ul << DataIn) | (1ul << Notification));
+		configured = true;
+		receive();
+		transmit();
+	}
+
+	// --------------------------------------------------------------------------
+	/// Arms the bulk OUT endpoint for as many packets as fit into the ring.
+	static void
+	receive()
+	{
+		using namespace otg;
+		if (not configured or rx_armed) return;
+		const std::size_t space = RxBufferSize - (rx_head.load(std::memory_order_relaxed) -
+				rx_tail.load(std::memory_order_acquire));
+		const uint32_t packets = std::min<std::size_t>(space / PacketSize, MaxPackets);
+		if (packets == 0) return;
+		Registers::write(DOEPTSIZ(DataOut), (packets << 19) | (packets * PacketSize));
+		set(DOEPCTL(DataOut), EPCTL_CNAK | EPCTL_EPENA);
+		rx_armed = true;
+	}
+
+	static void
+	handleDataOut()
+	{
+		using namespace otg;
+		const uint32_t interrupts = Registers::read(DOEPINT(DataOut));
+		Registers::write(DOEPINT(DataOut), interrupts);
+		if (interrupts & EPINT_XFRC)
+		{
+			rx_armed = false;
+			receive();
+		}
+	}
+
+	/// Starts a bulk IN transfer of the buffered data.
+	static void
+	transmit()
+	{
+		using namespace otg;
+		if (not configured or tx_busy) return;
+		const uint32_t available = tx_head.load(std::memory_order_acquire) - tx_tail.load(std::memory_order_relaxed);
+		if (available == 0 and not tx_zlp) return;
+		tx_transfer = std::min<uint32_t>(available, MaxPackets * PacketSize);
+		tx_loaded = 0;
+		// a transfer of full packets is terminated with a zero length packet
+		tx_zlp = tx_transfer and (tx_transfer % PacketSize) == 0;
+		const uint32_t packets = tx_transfer ? (tx_transfer + PacketSize - 1) / PacketSize : 1;
+		Registers::write(DIEPTSIZ(DataIn), (packets << 19) | tx_transfer);
+		set(DIEPCTL(DataIn), EPCTL_CNAK | EPCTL_EPENA);
+		tx_busy = true;
+		if (tx_transfer) set(DIEPEMPMSK, 1ul << DataIn);
+	}
+
+	/// Copies as many packets into the IN FIFO as fit.
+	static void
+	fillFifo()
+	{
+		using namespace otg;
+		const uint32_t tail = tx_tail.load(std::memory_order_relaxed);
+		while (tx_loaded < tx_transfer)
+		{
+			const uint32_t chunk = std::min<uint32_t>(tx_transfer - tx_loaded, PacketSize);
+			if ((Registers::read(DTXFSTS(DataIn)) & 0xffff) < (chunk + 3) / 4) return;
+			const uint32_t index = (tail + tx_loaded) & (TxBufferSize - 1);
+			if (index + chunk <= TxBufferSize)
+			{
+				writeFifo(DataIn, tx_buffer + index, chunk);
+			}
+			else
+			{
+				uint8_t packet[PacketSize];
+				const uint32_t first = TxBufferSize - index;
+				std::memcpy(packet, tx_buffer + index, first);
+				std::memcpy(packet + first, tx_buffer, chunk - first);
+				writeFifo(DataIn, packet, chunk);
+			}
+			tx_loaded += chunk;
+		}
+		clear(DIEPEMPMSK, 1ul << DataIn);
+	}
+
+	static void
+	handleDataIn()
+	{
+		using namespace otg;
+		uint32_t interrupts = Registers::read(DIEPINT(DataIn));
+		if (not (Registers::read(DIEPEMPMSK) & (1ul << DataIn))) interrupts &= ~DIEPINT_TXFE;
+		Registers::write(DIEPINT(DataIn), interrupts & ~DIEPINT_TXFE);
+		if (interrupts & DIEPINT_TXFE) fillFifo();
+		if (interrupts & EPINT_XFRC)
+		{
+			tx_tail.store(tx_tail.load(std::memory_order_relaxed) + tx_transfer, std::memory_order_release);
+			tx_busy = false;
+			transmit();
+		}
+	}
+
+	// --------------------------------------------------------------------------
+	enum class
+	Ep0 : uint8_t
+	{
+		Idle,
+		DataIn,
+		DataOut,
+	};
+
+	static inline uint8_t setup[8];
+	static inline uint8_t ep0_buffer[PacketSize];
+	static inline const uint8_t *ep0_data;
+	static inline std::size_t ep0_remaining;
+	static inline std::size_t ep0_received;
+	static inline bool ep0_zlp;
+	static inline Ep0 ep0_state{Ep0::Idle};
+
+	static inline uint8_t line_coding[7]{0x00, 0xC2, 0x01, 0x00, 0, 0, 8};	// 115200 8N1
+	static inline volatile uint16_t control_line_state{0};
+	static inline volatile bool configured{false};
+
+	static inline uint8_t tx_buffer[TxBufferSize];
+	static inline std::atomic<uint32_t> tx_head{0};
+	static inline std::atomic<uint32_t> tx_tail{0};
+	static inline uint32_t tx_transfer;
+	static inline uint32_t tx_loaded;
+	static inline volatile bool tx_busy{false};
+	static inline bool tx_zlp{false};
+
+	static inline uint8_t rx_buffer[RxBufferSize];
+	static inline std::atomic<uint32_t> rx_head{0};
+	static inline std::atomic<uint32_t> rx_tail{0};
+	static inline volatile bool rx_armed{false};
+};
+
+} // namespace modm::platform
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <modm/architecture/interface/atomic_lock.hpp>
+#include <modm/architecture/interface/delay.hpp>
+#include <modm/platform/device.hpp>
+
+#include "cdc_acm.hpp"
+
+namespace modm::platform
+{
+
+/// Register access of the OTG FS core for `CdcAcmDevice`.
+/// @ingroup modm_platform_usb_fs
+struct UsbFsRegisters
+{
+	static uint32_t
+	read(uint32_t offset)
+	{ return *reinterpret_cast<volatile uint32_t*>(USB_OTG_FS_PERIPH_BASE + offset); }
+
+	static void
+	write(uint32_t offset, uint32_t value)
+	{ *reinterpret_cast<volatile uint32_t*>(USB_OTG_FS_PERIPH_BASE + offset) = value; }
+
+	/// Waits for the forced device mode to take effect.
+	static void
+	delay()
+	{ modm::delay_ms(25); }
+
+	static void
+	enableInterrupt()
+	{ NVIC_EnableIRQ(OTG_FS_IRQn); }
+
+	/// Unique device id folded into 32 bits for the USB serial number.
+	static uint32_t
+	serialNumber()
+	{
+		const auto *uid = reinterpret_cast<const uint32_t*>(UID_BASE);
+		return uid[0] ^ uid[1] ^ uid[2];
+	}
+
+	using Lock = modm::atomic::Lock;
+};
+
+/**
+ * Virtual serial port on the OTG FS core with a 2 kiB transmit and a 512 B
+ * receive buffer.
+ *
+ * The application defines the `OTG_FS` interrupt, so that the buffers are
+ * only linked into images that use the device:
+ *
+ * @code
+ * MODM_ISR(OTG_FS)
+ * {
+ *     UsbCdcAcm::handleInterrupt();
+ * }
+ *
+ * Board::initializeUsbFs();
+ * UsbCdcAcm::initialize();
+ * @endcode
+ *
+ * @ingroup modm_platform_usb_fs
+ */
+using UsbCdcAcm = CdcAcmDevice<UsbFsRegisters, 2048, 512>;
+
+} // namespace modm::platform
@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <modm/architecture/interface/fiber.hpp>
+#include "task.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace modm::fiber
+{
+
+/**
+ * Bounded channel of `N` records between producers and one consumer.
+ *
+ * The records are stored in place, so large records like ADC blocks can be
+ * written with `reserve()` and `commit()` and read with `peek()` and
+ * `consume()` without copying them. `send()` and `receive()` copy or move
+ * whole records for convenience.
+ *
+ * The `try_*` functions never block and are lock-free, so they can be called
+ * from any interrupt priority. The other functions suspend the calling fiber
+ * until a record or a slot is available, optionally with a timeout, and
+ * busy-wait outside of a fiber. A waiting consumer is parked outside of the
+ * round-robin and resumed lock-free by `commit()`, waiting producers are kept
+ * in a `WaitQueue` and resumed by `consume()`.
+ *
+ * The single-producer variant only needs a load and a store per record. The
+ * multi-producer variant reserves slots with a compare-and-swap and commits
+ * them with a flag per slot, so producers may commit out of order, but the
+ * consumer receives the records in the order of reservation.
+ *
+ * @code
+ * modm::fiber::channel<AdcBlock, 4> adc_blocks;
+ *
+ * MODM_ISR(DMA2_Stream0) {
+ *     if (AdcBlock* block = adc_blocks.try_reserve()) {
+ *         fill(block);
+ *         adc_blocks.commit(block);
+ *     }
+ * }
+ * // in a fiber
+ * if (const AdcBlock* block = adc_blocks.peek_for(10ms)) {
+ *     process(*block);
+ *     adc_blocks.consume();
+ * }
+ * @endcode
+ *
+ * @tparam	T				record type, must be default constructible
+ * @tparam	N				number of records, must be a power of two
+ * @tparam	MultiProducer	allow concurrent producers
+ *
+ * @see	modm::fiber::mpsc_channel
+ * @ingroup modm_processing_fiber
+ */
+template< class T, std::size_t N, bool MultiProducer = false >
+class channel
+{
+	static_assert(std::has_single_bit(N) and N <= (1ul << 16),
+				  "The channel size must be a power of two of at most 2^16!");
+	static_assert(std::is_default_constructible_v<T>,
+				  "The channel records must be default constructible!");
+	static constexpr uint32_t Mask = N - 1;
+
+	channel(const channel&) = delete;
+	channel& operator=(const channel&) = delete;
+
+	T records[N]{};
+	/// index of the next record to be reserved
+	std::atomic<uint32_t> head{0};
+	/// index of the next record to be consumed
+	std::atomic<uint32_t> tail{0};
+	/// committed flag per record, only used by multiple producers
+	[[no_unique_address]] std::conditional_t<MultiProducer,
+			std::array<std::atomic<bool>, N>, std::tuple<>> committed{};
+	std::atomic<Task*> receiver{nullptr};
+	WaitQueue senders;
+
+	inline T*
+	wait_reserve(const uint32_t* deadline)
+	{
+		T* record{nullptr};
+		// called with interrupts disabled right before the fiber is queued
+		auto condition = [&] { return (record = try_reserve()) != nullptr; };
+		auto& scheduler = Scheduler::instance();
+		if (not scheduler.canSuspend())
+		{
+			while (not Scheduler::poll(condition, deadline) and deadline == nullptr) ;
+			return record;
+		}
+		// another producer may have taken the slot before the fiber resumes
+		while (not record)
+			if (not scheduler.block(senders, condition, deadline)) return nullptr;
+		return record;
+	}
+
+	inline T*
+	wait_peek(const uint32_t* deadline)
+	{
+		T* record{nullptr};
+		// called with interrupts disabled right before the fiber is parked
+		auto condition = [&]
+		{
+			if ((record = try_peek())) return true;
+			modm_assert(receiver.load(std::memory_order_relaxed) == nullptr,
+					"fbr.chan", "Only one fiber can receive from a channel!", this);
+			return false;
+		};
+		auto& scheduler = Scheduler::instance();
+		if (not scheduler.canSuspend())
+		{
+			while (not Scheduler::poll(condition, deadline) and deadline == nullptr) ;
+			return record;
+		}
+		while (not record)
+			if (not scheduler.park(receiver, condition, deadline)) return nullptr;
+		return record;
+	}
+
+	template< class Rep, class Period, class Wait >
+	static T*
+	wait_for(std::chrono::duration<Rep, Period> timeout, Wait&& wait)
+	{
+		T* record{nullptr};
+		Scheduler::withTimeout(timeout, [&](const uint32_t* deadline)
+		{
+			return (record = wait(deadline)) != nullptr;
+		});
+		return record;
+	}
+
+public:
+	constexpr channel() = default;
+
+	[[nodiscard]] static constexpr std::size_t
+	capacity()
+	{
+		return N;
+	}
+
+	/// @returns the number of reserved and not yet consumed records.
+	/// @note This function can be called from an interrupt.
+	[[nodiscard]] std::size_t inline
+	size() const
+	{
+		const uint32_t index = tail.load(std::memory_order_relaxed);
+		return head.load(std::memory_order_relaxed) - index;
+	}
+
+	/// @note This function can be called from an interrupt.
+	[[nodiscard]] bool inline
+	empty() const
+	{
+		return size() == 0;
+	}
+
+	/// @note This function can be called from an interrupt.
+	[[nodiscard]] bool inline
+	full() const
+	{
+		return size() == N;
+	}
+
+	// Producer -------------------------------------------------------------
+	/**
+	 * Reserves the next record for writing it in place. The record still
+	 * contains the previous value. With a single producer, every reserved
+	 * record must be committed before reserving the next one.
+	 *
+	 * @returns the record or `nullptr` if the channel is full.
+	 * @note This function is lock-free and can be called from any interrupt.
+	 */
+	[[nodiscard]] inline T*
+	try_reserve()
+	{
+		uint32_t index = head.load(std::memory_order_relaxed);
+		if constexpr (MultiProducer)
+		{
+			do {
+				// signed, since the head may be outdated by other producers
+				if (int32_t(index - tail.load(std::memory_order_acquire)) >= int32_t(N)) return nullptr;
+			}
+			while (not head.compare_exchange_weak(index, index + 1,
+					std::memory_order_relaxed, std::memory_order_relaxed));
+		}
+		else if (index - tail.load(std::memory_order_acquire) >= N) return nullptr;
+		return &records[index & Mask];
+	}
+
+	/// Reserves the next record and waits for space if the channel is full.
+	[[nodiscard]] inline T*
+	reserve()
+	{
+		return wait_reserve(nullptr);
+	}
+
+	/// @returns the record or `nullptr` if the timeout expired.
+	template< class Rep, class Period >
+	[[nodiscard]] T*
+	reserve_for(std::chrono::duration<Rep, Period> timeout)
+	{
+		return wait_for(timeout, [&](const uint32_t* deadline) { return wait_reserve(deadline); });
+	}
+
+	/// @returns the record or `nullptr` if the time point has been reached.
+	template< class Clock, class Duration >
+	[[nodiscard]] T*
+	reserve_until(std::chrono::time_point<Clock, Duration> time)
+	{
+		return reserve_for(this_fiber::detail::until(time));
+	}
+
+	/**
+	 * Passes a reserved record to the consumer and resumes it.
+	 *
+	 * @note This function is lock-free and can be called from any interrupt.
+	 */
+	void inline
+	commit(T* record)
+	{
+		if constexpr (MultiProducer)
+			committed[record - records].store(true, std::memory_order_release);
+		else
+			head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+		Task* task = receiver.load(std::memory_order_acquire);
+		if (task and receiver.compare_exchange_strong(task, nullptr,
+				std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			Scheduler::instance().post(task);
+		}
+	}
+
+	/// Copies or moves the value into the channel, unless it is full.
+	/// @note This function is lock-free and can be called from any interrupt.
+	template< class U = T >
+	bool
+	try_send(U&& value)
+	{
+		T* record = try_reserve();
+		if (record == nullptr) return false;
+		*record = std::forward<U>(value);
+		commit(record);
+		return true;
+	}
+
+	/// Copies or moves the value into the channel and waits for space if it is full.
+	template< class U = T >
+	void
+	send(U&& value)
+	{
+		T* record = reserve();
+		*record = std::forward<U>(value);
+		commit(record);
+	}
+
+	/// @returns false if the timeout expired.
+	template< class U, class Rep, class Period >
+	bool
+	send_for(U&& value, std::chrono::duration<Rep, Period> timeout)
+	{
+		T* record = reserve_for(timeout);
+		if (record == nullptr) return false;
+		*record = std::forward<U>(value);
+		commit(record);
+		return true;
+	}
+
+	/// @returns false if the time point has been reached.
+	template< class U, class Clock, class Duration >
+	bool
+	send_until(U&& value, std::chrono::time_point<Clock, Duration> time)
+	{
+		return send_for(std::forward<U>(value), this_fiber::detail::until(time));
+	}
+
+	// Consumer -------------------------------------------------------------
+	/**
+	 * Returns the oldest record for reading it in place. It stays in the
+	 * channel until it is consumed. There must only be one consumer.
+	 *
+	 * @returns the record or `nullptr` if the channel is empty or the oldest
+	 *          record is not committed yet.
+	 * @note This function is lock-free and can be called from any interrupt.
+	 */
+	[[nodiscard]] inline T*
+	try_peek()
+	{
+		const uint32_t index = tail.load(std::memory_order_relaxed);
+		if constexpr (MultiProducer)
+		{
+			if (not committed[index & Mask].load(std::memory_order_acquire)) return nullptr;
+		}
+		else if (index == head.load(std::memory_order_acquire)) return nullptr;
+		return &records[index & Mask];
+	}
+
+	/// Returns the oldest record and waits for one if the channel is empty.
+	[[nodiscard]] inline T*
+	peek()
+	{
+		return wait_peek(nullptr);
+	}
+
+	/// @returns the record or `nullptr` if the timeout expired.
+	template< class Rep, class Period >
+	[[nodiscard]] T*
+	peek_for(std::chrono::duration<Rep, Period> timeout)
+	{
+		return wait_for(timeout, [&](const uint32_t* deadline) { return wait_peek(deadline); });
+	}
+
+	/// @returns the record or `nullptr` if the time point has been reached.
+	template< class Clock, class Duration >
+	[[nodiscard]] T*
+	peek_until(std::chrono::time_point<Clock, Duration> time)
+	{
+		return peek_for(this_fiber::detail::until(time));
+	}
+
+	/**
+	 * Frees the oldest record, which must have been peeked, and resumes the
+	 * longest waiting producer.
+	 *
+	 * @note This function can be called from an interrupt. It is lock-free
+	 *       unless a producer fiber is waiting.
+	 */
+	void inline
+	consume()
+	{
+		const uint32_t index = tail.load(std::memory_order_relaxed);
+		if constexpr (MultiProducer)
+			committed[index & Mask].store(false, std::memory_order_relaxed);
+		tail.store(index + 1, std::memory_order_release);
+		if (not senders.empty()) senders.notify_one();
+	}
+
+	/// Moves the oldest record out of the channel, unless it is empty.
+	/// @note This function can be called from an interrupt.
+	bool
+	try_receive(T& value)
+	{
+		T* record = try_peek();
+		if (record == nullptr) return false;
+		value = std::move(*record);
+		consume();
+		return true;
+	}
+
+	/// Moves the oldest record out of the channel and waits for one if it is empty.
+	T
+	receive()
+	{
+		T value = std::move(*peek());
+		consume();
+		return value;
+	}
+
+	/// @returns false if the timeout expired.
+	template< class Rep, class Period >
+	bool
+	receive_for(T& value, std::chrono::duration<Rep, Period> timeout)
+	{
+		T* record = peek_for(timeout);
+		if (record == nullptr) return false;
+		value = std::move(*record);
+		consume();
+		return true;
+	}
+
+	/// @returns false if the time point has been reached.
+	template< class Clock, class Duration >
+	bool
+	receive_until(T& value, std::chrono::time_point<Clock, Duration> time)
+	{
+		return receive_for(value, this_fiber::detail::until(time));
+	}
+};
+
+/**
+ * Bounded channel with multiple producers and one consumer.
+ *
+ * @ingroup modm_processing_fiber
+ */
+template< class T, std::size_t N >
+using mpsc_channel = channel<T, N, true>;
+
+}	// namespace modm::fiber
@@ -13,7 +13,7 @@
 
 #include <modm/architecture/interface/fiber.hpp>
 #include "stop_token.hpp"
-#include <atomic>
+#include "wait_queue.hpp"
 
 
 namespace modm::fiber
@@ -36,12 +36,20 @@ class condition_variable_any
 	condition_variable_any(const condition_variable_any&) = delete;
 	condition_variable_any& operator=(const condition_variable_any&) = delete;
 
-	std::atomic<uint16_t> sequence{};
+	WaitQueue queue;
 
-	const auto inline wait_on_sequence()
+	/// Unlocks the lock with interrupts disabled right before the fiber is
+	/// queued, so that no notification is lost.
+	template< class Lock >
+	static auto inline
+	unlock_on_wait(Lock& lock)
 	{
-		return [this, poll_sequence = sequence.load(std::memory_order_acquire)]
-		{ return poll_sequence != sequence.load(std::memory_order_acquire); };
+		return [&lock, unlocked = false]() mutable
+		{
+			if (not unlocked) lock.unlock();
+			unlocked = true;
+			return false;
+		};
 	}
 public:
 	constexpr condition_variable_any() = default;
@@ -50,7 +58,7 @@ public:
 	void inline
 	notify_one()
 	{
-		sequence.fetch_add(1, std::memory_order_release);
+		(void) queue.notify_one();
 	}
 
 	/// @note This function can be called from an interrupt.
@@ -60,13 +68,19 @@ public:
 		notify_one();
 	}
 
+	/// @note This function can be called from an interrupt.
+	void inline
+	notify_all()
+	{
+		(void) queue.notify_all();
+	}
+
 
 	template< class Lock >
 	void
 	wait(Lock& lock)
 	{
-		lock.unlock();
-		this_fiber::poll(wait_on_sequence());
+		(void) queue.wait(unlock_on_wait(lock));
 		lock.lock();
 	}
 
@@ -96,8 +110,7 @@ public:
 	cv_status
 	wait_for(Lock& lock, std::chrono::duration<Rep, Period> rel_time)
 	{
-		lock.unlock();
-		const bool result = this_fiber::poll_for(rel_time, wait_on_sequence());
+		const bool result = queue.wait_for(rel_time, unlock_on_wait(lock));
 		lock.lock();
 		return result ? cv_status::no_timeout : cv_status::timeout;
 	}
@@ -135,8 +148,7 @@ public:
 	cv_status
 	wait_until(Lock& lock, std::chrono::time_point<Clock, Duration> abs_time)
 	{
-		lock.unlock();
-		const bool result = this_fiber::poll_until(abs_time, wait_on_sequence());
+		const bool result = queue.wait_until(abs_time, unlock_on_wait(lock));
 		lock.lock();
 		return result ? cv_status::no_timeout : cv_status::timeout;
 	}
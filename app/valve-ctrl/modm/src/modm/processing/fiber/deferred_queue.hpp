@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "channel.hpp"
+#include "event_flags.hpp"
+#include <modm/utils/inplace_function.hpp>
+#include <algorithm>
+
+namespace modm::fiber
+{
+
+/**
+ * Queue of deferred work items posted by interrupts and run by a fiber.
+ *
+ * Interrupts hand off variable-cost processing with `post()`, which only
+ * copies a small closure into the queue and wakes the fiber, so it takes a
+ * constant time, is lock-free and can be called from any interrupt priority.
+ * A dedicated fiber calls `run()`, which executes the items of the highest
+ * level first and items of the same level in the order they were posted.
+ *
+ * Each level holds up to `N` items. `post()` fails if the level is full, which
+ * is counted in `dropped()`. `high_water_mark()` returns the largest number of
+ * pending items per level, which helps sizing `N`.
+ *
+ * @code
+ * modm::fiber::deferred_queue<8, 2> deferred;
+ * modm::fiber::Task deferred_fiber(stack, [] { deferred.run(); },
+ *                                  modm::fiber::Start::Now, modm::fiber::PriorityHighest);
+ *
+ * MODM_ISR(ADC) {
+ *     const uint16_t sample = Adc1::getValue();
+ *     deferred.post([sample] { filter.update(sample); }, 1);
+ * }
+ * @endcode
+ *
+ * @tparam	N			number of items per level, must be a power of two
+ * @tparam	Levels		number of priority levels, at most 32
+ * @tparam	Capacity	size of the closure of an item in bytes
+ *
+ * @ingroup modm_processing_fiber
+ */
+template< std::size_t N, uint8_t Levels = 1, std::size_t Capacity = 2*sizeof(void*) >
+class deferred_queue
+{
+	static_assert(0 < Levels and Levels <= 32, "The number of levels must be in [1, 32]!");
+	static constexpr uint32_t AllLevels = uint32_t(-1) >> (32 - Levels);
+
+public:
+	using Function = modm::inplace_function<void(), Capacity>;
+
+private:
+	deferred_queue(const deferred_queue&) = delete;
+	deferred_queue& operator=(const deferred_queue&) = delete;
+
+	mpsc_channel<Function, N> queues[Levels];
+	/// one flag per level with pending items
+	event_flags pending;
+	std::atomic<uint32_t> high_water[Levels]{};
+	std::atomic<uint32_t> drops{0};
+
+public:
+	constexpr deferred_queue() = default;
+
+	[[nodiscard]] static constexpr std::size_t
+	capacity()
+	{
+		return N;
+	}
+
+	[[nodiscard]] static constexpr uint8_t
+	levels()
+	{
+		return Levels;
+	}
+
+	/**
+	 * Copies the function into the queue of its level and resumes the fiber.
+	 *
+	 * @param	level	priority of the item, higher levels run first.
+	 * @returns `false` if the level is full and the item was dropped.
+	 * @note This function is lock-free and can be called from any interrupt.
+	 */
+	template< class F >
+	bool
+	post(F&& function, uint8_t level = 0)
+	{
+		level = std::min<uint8_t>(level, Levels - 1);
+		auto& queue = queues[level];
+		Function* item = queue.try_reserve();
+		if (item == nullptr)
+		{
+			drops.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		const uint32_t depth = queue.size();
+		uint32_t mark = high_water[level].load(std::memory_order_relaxed);
+		while (mark < depth and not high_water[level].compare_exchange_weak(
+				mark, depth, std::memory_order_relaxed)) ;
+
+		*item = std::forward<F>(function);
+		queue.commit(item);
+		pending.set(1ul << level);
+		return true;
+	}
+
+	/**
+	 * Runs the pending item of the highest level, if any.
+	 *
+	 * @returns `false` if no item is pending.
+	 * @note There must only be one fiber running items.
+	 */
+	bool
+	run_one()
+	{
+		for (uint8_t level = Levels; level-- > 0;)
+		{
+			auto& queue = queues[level];
+			if (Function* item = queue.try_peek())
+			{
+				(*item)();
+				// destroy the closure before the slot is reused
+				*item = nullptr;
+				queue.consume();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Runs the pending items until the queue is empty.
+	/// @returns the number of items that have been run.
+	std::size_t
+	run_pending()
+	{
+		std::size_t count{0};
+		while (run_one()) count++;
+		return count;
+	}
+
+	/// Runs the items and suspends the fiber while the queue is empty.
+	[[noreturn]] void
+	run()
+	{
+		while (true)
+		{
+			run_pending();
+			// posts after the last check have set their flag
+			pending.wait_any(AllLevels);
+		}
+	}
+
+	/// @returns the number of pending items of a level.
+	/// @note This function can be called from an interrupt.
+	[[nodiscard]] std::size_t
+	size(uint8_t level) const
+	{
+		return queues[std::min<uint8_t>(level, Levels - 1)].size();
+	}
+
+	/// @returns the largest number of pending items of a level since the last reset.
+	/// @note This function can be called from an interrupt.
+	[[nodiscard]] std::size_t
+	high_water_mark(uint8_t level) const
+	{
+		return high_water[std::min<uint8_t>(level, Levels - 1)].load(std::memory_order_relaxed);
+	}
+
+	/// @returns the number of items that could not be posted since the last reset.
+	/// @note This function can be called from an interrupt.
+	[[nodiscard]] uint32_t
+	dropped() const
+	{
+		return drops.load(std::memory_order_relaxed);
+	}
+
+	/// Resets the high-water marks and the number of dropped items.
+	void
+	reset_statistics()
+	{
+		for (auto& mark : high_water) mark.store(0, std::memory_order_relaxed);
+		drops.store(0, std::memory_order_relaxed);
+	}
+};
+
+}	// namespace modm::fiber
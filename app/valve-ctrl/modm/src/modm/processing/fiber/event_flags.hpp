@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <modm/architecture/interface/fiber.hpp>
+#include "task.hpp"
+#include <atomic>
+
+namespace modm::fiber
+{
+
+/**
+ * Event flags to wake up a fiber from interrupts.
+ *
+ * Interrupts set flags with `set()`, which is lock-free and can therefore be
+ * called from any interrupt priority. One fiber at a time waits for any or all
+ * flags of a mask, optionally with a timeout. It is parked outside of the
+ * round-robin of the scheduler and `set()` posts it back as soon as its mask
+ * matches, so there is no polling between the interrupt and the fiber. The
+ * matching flags are cleared when the wait returns.
+ *
+ * @code
+ * modm::fiber::event_flags adc_events;
+ *
+ * MODM_ISR(ADC) { adc_events.set(EndOfConversion); }
+ *
+ * // in a fiber
+ * if (adc_events.wait_any_for(EndOfConversion, 10ms)) process(Adc1::getValue());
+ * @endcode
+ *
+ * Outside of a fiber, the waits busy-wait on the flags.
+ *
+ * @ingroup modm_processing_fiber
+ */
+class event_flags
+{
+	event_flags(const event_flags&) = delete;
+	event_flags& operator=(const event_flags&) = delete;
+
+	std::atomic<uint32_t> flags;
+	std::atomic<Task*> waiter{nullptr};
+	uint32_t wait_mask{0};
+	bool wait_for_all{false};
+
+	static bool inline
+	matches(uint32_t value, uint32_t mask, bool all)
+	{
+		const uint32_t matched = value & mask;
+		return all ? matched == mask : matched;
+	}
+
+	/// Clears and returns the flags of the mask if they match.
+	uint32_t inline
+	take(uint32_t mask, bool all)
+	{
+		uint32_t value = flags.load(std::memory_order_relaxed);
+		uint32_t matched;
+		do {
+			matched = value & mask;
+			if (not matches(value, mask, all)) return 0;
+		}
+		while (not flags.compare_exchange_weak(value, value & ~matched,
+				std::memory_order_acquire, std::memory_order_relaxed));
+		return matched;
+	}
+
+	uint32_t inline
+	wait(uint32_t mask, bool all, const uint32_t* deadline)
+	{
+		uint32_t result{0};
+		// called with interrupts disabled right before the fiber is parked
+		auto condition = [&]
+		{
+			if ((result = take(mask, all))) return true;
+			modm_assert(waiter.load(std::memory_order_relaxed) == nullptr,
+					"fbr.evfl", "Only one fiber can wait on event_flags!", this);
+			wait_mask = mask;
+			wait_for_all = all;
+			return false;
+		};
+		auto& scheduler = Scheduler::instance();
+		if (not scheduler.canSuspend())
+		{
+			while (not Scheduler::poll(condition, deadline) and deadline == nullptr) ;
+			return result;
+		}
+		// the flags may have been cleared again before the fiber resumes
+		while (not result)
+			if (not scheduler.park(waiter, condition, deadline)) return 0;
+		return result;
+	}
+
+	template< class Rep, class Period >
+	uint32_t
+	wait_for(uint32_t mask, bool all, std::chrono::duration<Rep, Period> timeout)
+	{
+		uint32_t result{0};
+		Scheduler::withTimeout(timeout, [&](const uint32_t* deadline)
+		{
+			return (result = wait(mask, all, deadline));
+		});
+		return result;
+	}
+
+public:
+	constexpr explicit
+	event_flags(uint32_t desired = 0)
+	: flags(desired) {}
+
+	/// @note This function can be called from an interrupt.
+	[[nodiscard]] uint32_t inline
+	get() const
+	{
+		return flags.load(std::memory_order_acquire);
+	}
+
+	/// Sets the flags and resumes the waiting fiber if its mask matches.
+	/// @note This function is lock-free and can be called from any interrupt.
+	void inline
+	set(uint32_t mask)
+	{
+		const uint32_t value = flags.fetch_or(mask, std::memory_order_release) | mask;
+		Task* task = waiter.load(std::memory_order_acquire);
+		if (task and matches(value, wait_mask, wait_for_all) and
+			waiter.compare_exchange_strong(task, nullptr,
+					std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			Scheduler::instance().post(task);
+		}
+	}
+
+	/// Clears the flags and returns the previous flags.
+	/// @note This function can be called from an interrupt.
+	uint32_t inline
+	clear(uint32_t mask)
+	{
+		return flags.fetch_and(~mask, std::memory_order_acq_rel);
+	}
+
+	/// Waits until any flag of the mask is set.
+	/// @returns the set flags of the mask, which are cleared.
+	uint32_t inline
+	wait_any(uint32_t mask)
+	{
+		return wait(mask, false, nullptr);
+	}
+
+	/// Waits until all flags of the mask are set.
+	/// @returns the mask, whose flags are cleared.
+	uint32_t inline
+	wait_all(uint32_t mask)
+	{
+		return wait(mask, true, nullptr);
+	}
+
+	/// @returns the set flags of the mask, or zero if the timeout expired.
+	template< class Rep, class Period >
+	uint32_t
+	wait_any_for(uint32_t mask, std::chrono::duration<Rep, Period> timeout)
+	{
+		return wait_for(mask, false, timeout);
+	}
+
+	/// @returns the mask, or zero if the timeout expired.
+	template< class Rep, class Period >
+	uint32_t
+	wait_all_for(uint32_t mask, std::chrono::duration<Rep, Period> timeout)
+	{
+		return wait_for(mask, true, timeout);
+	}
+
+	/// @returns the set flags of the mask, or zero if the time point has been reached.
+	template< class Clock, class Duration >
+	uint32_t
+	wait_any_until(uint32_t mask, std::chrono::time_point<Clock, Duration> time)
+	{
+		return wait_for(mask, false, this_fiber::detail::until(time));
+	}
+
+	/// @returns the mask, or zero if the time point has been reached.
+	template< class Clock, class Duration >
+	uint32_t
+	wait_all_until(uint32_t mask, std::chrono::time_point<Clock, Duration> time)
+	{
+		return wait_for(mask, true, this_fiber::detail::until(time));
+	}
+};
+
+}	// namespace modm::fiber
@@ -18,6 +18,7 @@
 
 #include <modm/architecture/interface/fiber.hpp>
 #include <modm/architecture/interface/atomic_lock.hpp>
+#include "wait_queue.hpp"
 #include <limits>
 #include <atomic>
 #include <mutex>
@@ -29,13 +30,18 @@ namespace modm::fiber
 /// @{
 
 /// Implements the `std::mutex` interface for fibers.
+/// Blocked fibers wait in a queue and the mutex is handed over to the longest
+/// waiting fiber on `unlock()`.
 /// @see https://en.cppreference.com/w/cpp/thread/mutex
 class mutex
 {
 	mutex(const mutex&) = delete;
 	mutex& operator=(const mutex&) = delete;
 
+protected:
 	std::atomic_bool locked{false};
+	WaitQueue queue;
+
 public:
 	constexpr mutex() = default;
 
@@ -50,14 +56,16 @@ public:
 	void inline
 	lock()
 	{
-		while(not try_lock()) modm::this_fiber::yield();
+		while(not queue.wait([this]{ return try_lock(); })) ;
 	}
 
 	/// @note This function can be called from an interrupt.
 	void inline
 	unlock()
 	{
-		locked.store(false, std::memory_order_release);
+		modm::atomic::Lock _;
+		// the mutex stays locked for the resumed fiber
+		if (not queue.notify_one()) locked.store(false, std::memory_order_release);
 	}
 };
 
@@ -71,7 +79,7 @@ public:
 	bool
 	try_lock_for(std::chrono::duration<Rep, Period> sleep_duration)
 	{
-		return this_fiber::poll_for(sleep_duration, [this]{ return try_lock(); });
+		return queue.wait_for(sleep_duration, [this]{ return try_lock(); });
 	}
 
 	template< class Clock, class Duration >
@@ -79,7 +87,7 @@ public:
 	bool
 	try_lock_until(std::chrono::time_point<Clock, Duration> sleep_time)
 	{
-		return this_fiber::poll_until(sleep_time, [this]{ return try_lock(); });
+		return queue.wait_until(sleep_time, [this]{ return try_lock(); });
 	}
 };
 
@@ -91,10 +99,12 @@ class recursive_mutex
 	recursive_mutex& operator=(const recursive_mutex&) = delete;
 	using count_t = uint16_t;
 
+protected:
 	static constexpr fiber::id NoOwner{fiber::id(-1)};
 	volatile fiber::id owner{NoOwner};
 	static constexpr count_t countMax{count_t(-1)};
 	volatile count_t count{1};
+	WaitQueue queue;
 
 public:
 	constexpr recursive_mutex() = default;
@@ -121,7 +131,7 @@ public:
 	void inline
 	lock()
 	{
-		while(not try_lock()) modm::this_fiber::yield();
+		while(not queue.wait([this]{ return try_lock(); })) ;
 	}
 
 	/// @note This function can be called from an interrupt.
@@ -130,10 +140,11 @@ public:
 	{
 		modm::atomic::Lock _;
 		if (count > 1) count--;
-		else {
+		else if (const auto id = queue.notify_one(); id) {
 			// count = 1; is implicit
-			owner = NoOwner;
+			owner = id;
 		}
+		else owner = NoOwner;
 	}
 };
 
@@ -147,7 +158,7 @@ public:
 	bool
 	try_lock_for(std::chrono::duration<Rep, Period> sleep_duration)
 	{
-		return this_fiber::poll_for(sleep_duration, [this]{ return try_lock(); });
+		return queue.wait_for(sleep_duration, [this]{ return try_lock(); });
 	}
 
 	template< class Clock, class Duration >
@@ -155,7 +166,7 @@ public:
 	bool
 	try_lock_until(std::chrono::time_point<Clock, Duration> sleep_time)
 	{
-		return this_fiber::poll_until(sleep_time, [this]{ return try_lock(); });
+		return queue.wait_until(sleep_time, [this]{ return try_lock(); });
 	}
 };
 
@@ -10,6 +10,7 @@
 // ----------------------------------------------------------------------------
 
 #include "scheduler.hpp"
+#include <modm/architecture/utils.hpp>
 
 /// @cond
 namespace modm::this_fiber
@@ -27,5 +28,54 @@ get_id()
 	return modm::fiber::Scheduler::instance().get_id();
 }
 
+void
+detail::sleep(modm::chrono::micro_clock::time_point wakeup)
+{
+	auto &scheduler = modm::fiber::Scheduler::instance();
+	const uint32_t time = wakeup.time_since_epoch().count();
+	if (scheduler.current == nullptr or modm::fiber::Scheduler::isInsideInterrupt())
+	{
+		// Without a running scheduler there is nothing to switch to
+		while (int32_t(modm::fiber::Scheduler::now() - time) < 0) ;
+		return;
+	}
+	scheduler.sleep(time);
+}
+
 } // namespace modm::this_fiber
+
+namespace modm::fiber
+{
+
+fiber::id
+WaitQueue::notify_one()
+{
+	modm::atomic::Lock lock;
+	Task* task = pop();
+	if (task == nullptr) return 0;
+	Scheduler::instance().unblock(task);
+	return task->get_id();
+}
+
+std::size_t
+WaitQueue::notify_all()
+{
+	modm::atomic::Lock lock;
+	std::size_t count = 0;
+	for (Task* task; (task = pop()); count++)
+		Scheduler::instance().unblock(task);
+	return count;
+}
+
+} // namespace modm::fiber
 /// @endcond
+
+modm_weak void
+modm_fiber_idle(uint32_t duration)
+{
+	// The SysTick interrupt at 4Hz is the only wakeup source that is always
+	// available, so only sleep if it fires before the next fiber is due.
+	if (not (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk)) return;
+	const uint32_t systick = (uint64_t(SysTick->VAL) * 250'000ul) / (SysTick->LOAD + 1ul);
+	if (systick < duration) __WFI();
+}
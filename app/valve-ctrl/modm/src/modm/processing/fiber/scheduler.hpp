@@ -15,30 +15,101 @@
 #define MODM_FIBER_SCHEDULER_HPP
 
 #include "task.hpp"
+#include "wait_queue.hpp"
 #include <modm/architecture/interface/assert.hpp>
+#include <modm/architecture/interface/atomic_lock.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <utility>
 #include <modm/platform/device.hpp>
+
+/**
+ * Called by the scheduler with interrupts disabled when no fiber is ready.
+ *
+ * The default implementation sleeps with WFI if the SysTick interrupt fires
+ * before the next fiber wakes up, otherwise it returns immediately and the
+ * scheduler polls the clock with the core running. With fibers sleeping for
+ * less than the 250ms SysTick period, the core then rarely sleeps, although
+ * the time is reported as idle. Override it to sleep until the deadline with
+ * a timer of your application.
+ *
+ * @param duration	microseconds until the next fiber wakes up, or
+ *					0xffff'ffff if no fiber is sleeping.
+ * @ingroup modm_processing_fiber
+ */
+extern "C" void
+modm_fiber_idle(uint32_t duration);
+
 namespace modm::fiber
 {
 
 /**
- * The scheduler executes fibers in a simple round-robin fashion. Fibers can be
- * added to a scheduler using the `modm::fiber::Task::start()` function, also
- * while the scheduler is running. Fibers returning from their function will
- * automatically unschedule themselves.
+ * The scheduler executes fibers in a round-robin fashion per priority level.
+ * Fibers can be added to a scheduler using the `modm::fiber::Task::start()`
+ * function, also while the scheduler is running. Fibers returning from their
+ * function will automatically unschedule themselves.
+ *
+ * Each priority level has its own round-robin and a bitmap marks the levels
+ * with ready fibers, so the highest ready level is found in constant time by
+ * counting the leading zeros. A yield switches to the highest priority ready
+ * fiber, so fibers of lower priority only run when all fibers of higher
+ * priority sleep or wait. With `setAging(n)`, after `n` consecutive switches
+ * to fibers of the same priority while lower levels are ready, the first fiber
+ * of a lower level runs once. The lower levels are served in descending order, so
+ * no ready fiber starves.
+ *
+ * Sleeping fibers are removed from the round-robin and kept in a list sorted
+ * by their wakeup time, so they cost nothing until they are due. A yield
+ * moves all due fibers to the end of the round-robin. Fibers blocked on a
+ * synchronization primitive wait in its `modm::fiber::WaitQueue` in the same
+ * way. If no fiber is ready, the scheduler calls `modm_fiber_idle()` until the
+ * first one is due or an interrupt resumes one.
+ *
+ * The round-robin and the sleep list are modified with interrupts disabled,
+ * since interrupts may resume fibers by notifying a wait queue.
+ *
+ * Every context switch charges the DWT cycles since the previous switch to the
+ * fiber that ran, see `modm::fiber::Task::cpu_time()`. The time spent in the
+ * idle loop is counted separately with the clock, since the cycle counter
+ * stops while the core sleeps, see `getIdleTime()`.
  *
  * @ingroup modm_processing_fiber
  */
 class Scheduler
 {
 	friend class Task;
+	friend class WaitQueue;
+	friend class event_flags;
+	template< class T, std::size_t N, bool MultiProducer > friend class channel;
 	friend void modm::this_fiber::yield();
 	friend modm::fiber::id modm::this_fiber::get_id();
+	friend void modm::this_fiber::detail::sleep(modm::chrono::micro_clock::time_point);
 	Scheduler(const Scheduler&) = delete;
 	Scheduler& operator=(const Scheduler&) = delete;
+	static_assert(PriorityLevels <= 32, "The ready bitmap supports at most 32 priority levels!");
 
 protected:
-	Task* last{nullptr};
+	/// last fiber of the round-robin per priority level
+	Task* last[PriorityLevels]{};
 	Task* current{nullptr};
+	/// bit n is set if the round-robin of priority n is not empty
+	uint32_t ready_levels{0};
+	uint8_t aging{0};
+	uint8_t aging_count{0};
+	/// priority that got the consecutive switches
+	Priority aging_level{PriorityLevels};
+	/// lower priority that ran last due to aging
+	Priority aged_level{PriorityLevels};
+	/// sorted by wakeup time, the first one is due next
+	Task* sleeping{nullptr};
+	/// fibers resumed by interrupts, pushed lock-free in reverse order
+	std::atomic<Task*> posted{nullptr};
+	/// number of fibers in wait queues or waiting for a post
+	uint16_t blocked{0};
+	/// cycle counter at the start of the current slice
+	uint32_t slice_start{0};
+	CpuTime idle_time{};
 
 	uintptr_t inline
 	get_id() const
@@ -54,26 +125,49 @@ protected:
 		return __get_IPSR();
 	}
 
+	/// Inserts the task at the front of the round-robin of its priority.
 	void inline
-	runNext(Task* task)
+	runFirst(Task* task)
 	{
-		task->next = current->next;
-		current->next = task;
+		const Priority level = task->level = task->priority;
+		if (Task* tail = last[level])
+		{
+			task->next = tail->next;
+			tail->next = task;
+		}
+		else
+		{
+			task->next = task;
+			last[level] = task;
+			ready_levels |= 1ul << level;
+		}
 	}
 
+	/// Appends the task to the end of the round-robin of its priority.
 	void inline
 	runLast(Task* task)
 	{
-		task->next = last->next;
-		last->next = task;
-		last = task;
+		runFirst(task);
+		last[task->level] = task;
+	}
+
+	/// Removes the current fiber, which is the first of its round-robin.
+	void inline
+	unlinkCurrent()
+	{
+		const Priority level = current->level;
+		if (current == last[level])
+		{
+			last[level] = nullptr;
+			ready_levels &= ~(1ul << level);
+		}
+		else last[level]->next = current->next;
 	}
 
 	inline Task*
 	removeCurrent()
 	{
-		if (current == last) last = nullptr;
-		else last->next = current->next;
+		unlinkCurrent();
 		current->next = nullptr;
 		current->scheduler = nullptr;
 		return current;
@@ -82,27 +176,336 @@ protected:
 	bool inline
 	empty() const
 	{
-		return last == nullptr;
+		return ready_levels == 0;
+	}
+
+	/// Returns the first fiber of the highest ready priority, or of a lower
+	/// priority if it is due for aging.
+	inline Task*
+	select()
+	{
+		Priority level = std::bit_width(ready_levels) - 1;
+		if (const uint32_t lower = ready_levels & ((1ul << level) - 1); aging and lower)
+		{
+			if (level != aging_level)
+			{
+				aging_level = level;
+				aging_count = 0;
+			}
+			if (++aging_count >= aging)
+			{
+				aging_count = 0;
+				const uint32_t below = lower & ((1ul << aged_level) - 1);
+				level = aged_level = std::bit_width(below ? below : lower) - 1;
+			}
+		}
+		else aging_count = 0;
+		return last[level]->next;
+	}
+
+	/// @returns the DWT cycle counter, which is enabled during startup.
+	static uint32_t inline
+	cycles()
+	{
+		return DWT->CYCCNT;
+	}
+
+	/// Charges the cycles since the start of the slice to the current fiber.
+	void inline
+	account()
+	{
+		const uint32_t time = cycles();
+		const uint32_t slice = time - slice_start;
+		slice_start = time;
+		current->cpu.cycles += slice;
+		if (slice > current->cpu.longest_slice) current->cpu.longest_slice = slice;
 	}
 
 	void inline
 	jump(Task* other)
 	{
 		auto from = current;
+		account();
+		other->cpu.switches++;
 		current = other;
 		modm_context_jump(&from->ctx, &other->ctx);
 	}
 
+	static uint32_t inline
+	now()
+	{
+		return modm::chrono::micro_clock::now().time_since_epoch().count();
+	}
+
+	void inline
+	insertSleeping(Task* task, uint32_t time)
+	{
+		task->wakeup = time;
+		Task** link = &sleeping;
+		while (*link and int32_t((*link)->wakeup - time) <= 0) link = &(*link)->sleep_next;
+		task->sleep_next = *link;
+		if (*link) (*link)->sleep_link = &task->sleep_next;
+		task->sleep_link = link;
+		*link = task;
+	}
+
+	void inline
+	removeSleeping(Task* task)
+	{
+		*task->sleep_link = task->sleep_next;
+		if (task->sleep_next) task->sleep_next->sleep_link = task->sleep_link;
+		task->sleep_link = nullptr;
+	}
+
+	/// Moves all due fibers from the sleep list to the end of the round-robin.
+	void inline
+	wakeup(uint32_t time)
+	{
+		while (sleeping and int32_t(time - sleeping->wakeup) >= 0)
+		{
+			Task* task = sleeping;
+			removeSleeping(task);
+			if (task->queue)
+			{
+				task->queue->remove(task);
+				task->queue = nullptr;
+			}
+			else if (Task* expected = task; task->slot)
+			{
+				// an interrupt posting the fiber first resumes it instead
+				if (not task->slot->compare_exchange_strong(expected, nullptr,
+						std::memory_order_acquire, std::memory_order_relaxed)) continue;
+				task->slot = nullptr;
+			}
+			else
+			{
+				runLast(task);
+				continue;
+			}
+			task->timed_out = true;
+			blocked--;
+			runLast(task);
+		}
+	}
+
+	/// Resumes a fiber that is removed from the wait queue.
+	void inline
+	unblock(Task* task)
+	{
+		task->queue = nullptr;
+		blocked--;
+		if (task->sleep_link) removeSleeping(task);
+		runLast(task);
+	}
+
+	/// Resumes all fibers posted by interrupts in the order of posting. They
+	/// run before the other fibers of their priority.
+	void inline
+	resumePosted()
+	{
+		// the list is in reverse order, which is restored by inserting
+		// each fiber at the front
+		for (Task* task = posted.exchange(nullptr, std::memory_order_acquire); task; )
+		{
+			Task* next = task->posted_next;
+			task->slot = nullptr;
+			blocked--;
+			if (task->sleep_link) removeSleeping(task);
+			runFirst(task);
+			task = next;
+		}
+	}
+
+	/// Resumes all posted and due fibers.
+	void inline
+	collect()
+	{
+		if (posted.load(std::memory_order_relaxed)) resumePosted();
+		if (sleeping) wakeup(now());
+	}
+
+	/// Waits until a fiber is ready, then returns it.
+	inline Task*
+	idle()
+	{
+		// the slice of the suspended fiber ends here
+		account();
+		uint32_t time = now();
+		while (true)
+		{
+			// interrupts are disabled between the check and the idle hook, so
+			// that an interrupt resuming a fiber also wakes up the core
+			modm::atomic::Lock lock;
+			if (posted.load(std::memory_order_relaxed)) resumePosted();
+			wakeup(time);
+			if (not empty())
+			{
+				slice_start = cycles();
+				return select();
+			}
+			modm_fiber_idle(sleeping ? sleeping->wakeup - time : 0xffff'ffff);
+			// the cycle counter stops while the core sleeps, the clock does not
+			const uint32_t start = std::exchange(time, now());
+			const uint64_t duration = uint64_t(time - start) * (SystemCoreClock / 1'000'000);
+			idle_time.cycles += duration;
+			idle_time.switches++;
+			if (duration > idle_time.longest_slice)
+				idle_time.longest_slice = std::min<uint64_t>(duration, 0xffff'ffff);
+		}
+	}
+
+	/// Removes the current fiber from the round-robin.
+	/// @returns the next ready fiber or nullptr.
+	inline Task*
+	suspend()
+	{
+		unlinkCurrent();
+		collect();
+		return empty() ? nullptr : select();
+	}
+
+	/// Switches to the next fiber until the current fiber is ready again.
+	void inline
+	resume(Task* next)
+	{
+		if (next == nullptr) next = idle();
+		if (next != current) jump(next);
+	}
+
+	void inline
+	sleep(uint32_t time)
+	{
+		Task* next;
+		{
+			modm::atomic::Lock lock;
+			insertSleeping(current, time);
+			next = suspend();
+		}
+		resume(next);
+	}
+
+	template< class Condition >
+	bool
+	block(WaitQueue& queue, Condition& condition, const uint32_t* deadline)
+	{
+		Task* next;
+		{
+			modm::atomic::Lock lock;
+			if (condition()) return true;
+			if (deadline and int32_t(*deadline - now()) <= 0) return false;
+			current->queue = &queue;
+			current->timed_out = false;
+			queue.push(current);
+			blocked++;
+			if (deadline) insertSleeping(current, *deadline);
+			next = suspend();
+		}
+		resume(next);
+		return not current->timed_out;
+	}
+
+	/// Suspends the current fiber until an interrupt posts it through the slot
+	/// or the deadline expires, unless `condition()` returns true.
+	template< class Condition >
+	bool
+	park(std::atomic<Task*>& slot, Condition& condition, const uint32_t* deadline)
+	{
+		Task* next;
+		{
+			modm::atomic::Lock lock;
+			if (condition()) return true;
+			if (deadline and int32_t(*deadline - now()) <= 0) return false;
+			current->slot = &slot;
+			current->timed_out = false;
+			blocked++;
+			if (deadline) insertSleeping(current, *deadline);
+			next = suspend();
+			// publish the fiber only once it is removed from the round-robin
+			slot.store(current, std::memory_order_release);
+		}
+		resume(next);
+		return not current->timed_out;
+	}
+
+	/**
+	 * Resumes a fiber parked in a slot, which must have been taken out of the
+	 * slot by the caller. This is lock-free, so it can be called from any
+	 * interrupt priority. The fiber is moved to the round-robin at the next
+	 * scheduling point, or immediately if the scheduler is idle.
+	 */
+	void inline
+	post(Task* task)
+	{
+		Task* head = posted.load(std::memory_order_relaxed);
+		do task->posted_next = head;
+		while (not posted.compare_exchange_weak(head, task,
+				std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	/// @returns true if the caller is a fiber that can be suspended.
+	bool inline
+	canSuspend() const
+	{
+		return current != nullptr and not isInsideInterrupt();
+	}
+
+	/// Polls the condition until it is true or the deadline expired, since
+	/// there is nothing to switch to without a running scheduler.
+	template< class Condition >
+	static bool
+	poll(Condition& condition, const uint32_t* deadline)
+	{
+		if (deadline == nullptr) return condition();
+		while (not condition())
+			if (int32_t(now() - *deadline) >= 0) return false;
+		return true;
+	}
+
+	/// Calls `bool block(const uint32_t* deadline)` until it returns true or
+	/// the timeout expired. Long timeouts are split into steps that keep the
+	/// 32-bit deadlines comparable.
+	template< class Rep, class Period, class Function >
+	static bool
+	withTimeout(std::chrono::duration<Rep, Period> timeout, Function&& block)
+	{
+		auto remaining = std::chrono::ceil<std::chrono::duration<int64_t, std::micro>>(timeout).count();
+		if (remaining < 0) remaining = 0;
+
+		constexpr int64_t max_step = 1ll << 30;
+		uint32_t deadline = now();
+		do {
+			const auto step = std::min(remaining, max_step);
+			deadline += uint32_t(step);
+			if (block(&deadline)) return true;
+			remaining -= step;
+		}
+		while (remaining > 0);
+		return false;
+	}
+
 	void inline
 	yield()
 	{
 		if (current == nullptr) return;
-		Task* next = current->next;
-		// If there's only one fiber running, we could just return here.
-		// However, we need to check the stack for overflow.
-		// We do that by running the context switch!
-		// if (next == current) return;
-		last = current;
+		Task* next;
+		{
+			modm::atomic::Lock lock;
+			if (sleeping) wakeup(now());
+			// move the current fiber to the end of its round-robin
+			if (current->level == current->priority) last[current->level] = current;
+			else
+			{
+				unlinkCurrent();
+				runLast(current);
+			}
+			// the current fiber must be rotated before fibers are put in front
+			if (posted.load(std::memory_order_relaxed)) resumePosted();
+			next = select();
+			// If there's only one fiber running, we could just return here.
+			// However, we need to check the stack for overflow.
+			// We do that by running the context switch!
+			// if (next == current) return;
+		}
 		jump(next);
 	}
 
@@ -110,13 +513,20 @@ protected:
 	void inline
 	unschedule()
 	{
-		Task* next = current->next;
-		removeCurrent();
-		if (empty())
+		Task* next;
+		{
+			modm::atomic::Lock lock;
+			removeCurrent();
+			collect();
+			next = empty() ? nullptr : select();
+		}
+		// Fibers waiting without a timeout may still be notified by interrupts
+		if (next == nullptr and sleeping == nullptr and blocked == 0)
 		{
 			current = nullptr;
 			modm_context_end(0);
 		}
+		if (next == nullptr) next = idle();
 		jump(next);
 		__builtin_unreachable();
 	}
@@ -124,13 +534,8 @@ protected:
 	void inline
 	add(Task* task)
 	{
+		modm::atomic::Lock lock;
 		task->scheduler = this;
-		if (last == nullptr)
-		{
-			task->next = task;
-			last = task;
-			return;
-		}
 		runLast(task);
 	}
 
@@ -138,7 +543,9 @@ protected:
 	start()
 	{
 		if (empty()) return false;
-		current = last->next;
+		current = select();
+		current->cpu.switches++;
+		slice_start = cycles();
 		const auto overflow = (Task *) modm_context_start(&current->ctx);
 		modm_assert(not overflow, "fbr.stkof", "Fiber stack overflow", overflow);
 		return true;
@@ -162,6 +569,29 @@ public:
 		return 1;
 	}
 
+	/// Runs the first fiber of a lower priority once after `switches`
+	/// consecutive switches to fibers of the same higher priority.
+	/// Zero disables aging.
+	static inline void
+	setAging(uint8_t switches)
+	{
+		instance().aging = switches;
+	}
+
+	/// @returns the time spent in `modm_fiber_idle()` in cycles, the number of
+	/// calls and the longest call since the last reset.
+	static inline CpuTime
+	getIdleTime()
+	{
+		return instance().idle_time;
+	}
+
+	static inline void
+	resetIdleTime()
+	{
+		instance().idle_time = {};
+	}
+
 	/// Runs the currently active scheduler.
 	static inline void
 	run()
@@ -170,6 +600,58 @@ public:
 	}
 };
 
+/// @cond
+void inline
+WaitQueue::push(Task* task)
+{
+	task->wait_next = nullptr;
+	if (last) last->wait_next = task;
+	else first = task;
+	last = task;
+}
+
+inline Task*
+WaitQueue::pop()
+{
+	Task* task = first;
+	if (task)
+	{
+		first = task->wait_next;
+		if (first == nullptr) last = nullptr;
+	}
+	return task;
+}
+
+void inline
+WaitQueue::remove(Task* task)
+{
+	Task** link = &first;
+	Task* previous = nullptr;
+	while (*link != task) link = &(previous = *link)->wait_next;
+	*link = task->wait_next;
+	if (last == task) last = previous;
+}
+
+template< class Condition >
+bool
+WaitQueue::block(Condition& condition, const uint32_t* deadline)
+{
+	auto& scheduler = Scheduler::instance();
+	if (not scheduler.canSuspend()) return Scheduler::poll(condition, deadline);
+	return scheduler.block(*this, condition, deadline);
+}
+
+template< class Rep, class Period, class Condition >
+bool
+WaitQueue::wait_for(std::chrono::duration<Rep, Period> timeout, Condition&& condition)
+{
+	return Scheduler::withTimeout(timeout, [&](const uint32_t* deadline)
+	{
+		return block(condition, deadline);
+	});
+}
+/// @endcond
+
 } // namespace modm::fiber
 
 #endif // MODM_FIBER_SCHEDULER_HPP
\ No newline at end of file
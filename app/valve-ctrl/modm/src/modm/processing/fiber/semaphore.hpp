@@ -12,6 +12,8 @@
 #pragma once
 
 #include <modm/architecture/interface/fiber.hpp>
+#include <modm/architecture/interface/atomic_lock.hpp>
+#include "wait_queue.hpp"
 #include <limits>
 #include <atomic>
 
@@ -22,6 +24,8 @@ namespace modm::fiber
 /// @{
 
 /// Implements the `std::counting_semaphore` interface for fibers.
+/// Blocked fibers wait in a queue and `release()` hands the count over to the
+/// longest waiting fiber.
 /// @see https://en.cppreference.com/w/cpp/thread/counting_semaphore
 template< std::ptrdiff_t LeastMaxValue = 255 >
 class counting_semaphore
@@ -32,6 +36,7 @@ class counting_semaphore
 	static_assert(LeastMaxValue <= uint16_t(-1), "counting_semaphore uses a 16-bit counter!");
 	using count_t = std::conditional_t<(LeastMaxValue < 256), uint8_t, uint16_t>;
 	std::atomic<count_t> count{};
+	WaitQueue queue;
 
 public:
 	constexpr explicit
@@ -57,14 +62,15 @@ public:
 	void inline
 	acquire()
 	{
-		while(not try_acquire()) modm::this_fiber::yield();
+		while(not queue.wait([this]{ return try_acquire(); })) ;
 	}
 
 	/// @note This function can be called from an interrupt.
 	void inline
 	release()
 	{
-		count.fetch_add(1, std::memory_order_release);
+		modm::atomic::Lock _;
+		if (not queue.notify_one()) count.fetch_add(1, std::memory_order_release);
 	}
 
 	template< typename Rep, typename Period >
@@ -72,7 +78,7 @@ public:
 	bool
 	try_acquire_for(std::chrono::duration<Rep, Period> sleep_duration)
 	{
-		return this_fiber::poll_for(sleep_duration, [this]{ return try_acquire(); });
+		return queue.wait_for(sleep_duration, [this]{ return try_acquire(); });
 	}
 
 	template< class Clock, class Duration >
@@ -80,7 +86,7 @@ public:
 	bool
 	try_acquire_until(std::chrono::time_point<Clock, Duration> sleep_time)
 	{
-		return this_fiber::poll_until(sleep_time, [this]{ return try_acquire(); });
+		return queue.wait_until(sleep_time, [this]{ return try_acquire(); });
 	}
 };
 
@@ -15,6 +15,8 @@
 #include "stack.hpp"
 #include "stop_token.hpp"
 #include <modm/architecture/interface/fiber.hpp>
+#include <algorithm>
+#include <atomic>
 #include <type_traits>
 
 namespace modm
@@ -25,6 +27,7 @@ namespace fiber
 
 // forward declaration
 class Scheduler;
+class WaitQueue;
 
 /// The Fiber scheduling policy.
 /// @ingroup modm_processing_fiber
@@ -35,6 +38,30 @@ Start
 	Later,	// Manually add the fiber to a scheduler.
 };
 
+/// Priority of a fiber, the scheduler always resumes a ready fiber of the
+/// highest priority first.
+/// @ingroup modm_processing_fiber
+using Priority = uint8_t;
+/// Number of priority levels of the scheduler.
+/// @ingroup modm_processing_fiber
+static constexpr Priority PriorityLevels = 8;
+/// @ingroup modm_processing_fiber
+static constexpr Priority PriorityLowest = 0;
+/// @ingroup modm_processing_fiber
+static constexpr Priority PriorityHighest = PriorityLevels - 1;
+/// Priority of fibers that do not specify one.
+/// @ingroup modm_processing_fiber
+static constexpr Priority PriorityDefault = PriorityLevels / 2;
+
+/// CPU time spent in a fiber or in the idle hook, measured in CPU cycles.
+/// @ingroup modm_processing_fiber
+struct CpuTime
+{
+	uint64_t cycles;		///< cycles spent running
+	uint32_t switches;		///< number of times the fiber was resumed
+	uint32_t longest_slice;	///< cycles of the longest run between two scheduling points
+};
+
 /**
  * The fiber task connects the callable fiber object with the fiber context and
  * scheduler. It constructs the fiber function on the stack if necessary, and
@@ -57,20 +84,38 @@ class Task
 	Task(const Task&) = delete;
 	Task& operator=(const Task&) = delete;
 	friend class Scheduler;
+	friend class WaitQueue;
 
 	// Make sure that Task and Fiber use a callable constructor, otherwise they
 	// may get placed in the .data section including the whole stack!!!
 	modm_context_t ctx;
 	Task* next;
+	// sleep list, sleep_link points to the pointer to this task
+	Task* sleep_next{nullptr};
+	Task** sleep_link{nullptr};
+	uint32_t wakeup;
+	// wait queue of a synchronization primitive
+	Task* wait_next{nullptr};
+	WaitQueue* queue{nullptr};
+	// slot the task is parked in until an interrupt posts it
+	std::atomic<Task*>* slot{nullptr};
+	Task* posted_next{nullptr};
+	bool timed_out{false};
 	Scheduler *scheduler{nullptr};
 	stop_state stop{};
+	Priority priority;
+	// priority of the round-robin the task is linked into
+	Priority level;
+	CpuTime cpu{};
 
 public:
 	/// @param stack	A stack object that is *NOT* shared with other tasks.
 	/// @param closure	A callable object of signature `void()`.
 	/// @param start	When to start this task.
+	/// @param priority	Priority of this task.
 	template<size_t Size, class Callable>
-	Task(Stack<Size>& stack, Callable&& closure, Start start=Start::Now);
+	Task(Stack<Size>& stack, Callable&& closure, Start start=Start::Now,
+		 Priority priority=PriorityDefault);
 
 	inline
 	~Task()
@@ -142,11 +187,46 @@ public:
 		return modm_context_stack_usage(&ctx);
 	}
 
+	/// @returns the size of the stack below the closure in bytes.
+	[[nodiscard]] size_t inline
+	stack_size() const
+	{
+		return (ctx.top - ctx.bottom) * sizeof(uintptr_t);
+	}
+
+	/// @returns the CPU time spent in this fiber up to its last switch.
+	[[nodiscard]] CpuTime inline
+	cpu_time() const
+	{
+		return cpu;
+	}
+
+	/// Resets the CPU time to measure the next interval.
+	void inline
+	cpu_time_reset()
+	{
+		cpu = {};
+	}
+
 	/// Adds the task to the currently active scheduler, if not already running.
 	/// @returns if the fiber has been scheduled.
 	bool
 	start();
 
+	[[nodiscard]] Priority inline
+	get_priority() const
+	{
+		return priority;
+	}
+
+	/// Changes the priority, which takes effect the next time the fiber
+	/// yields or is resumed.
+	void inline
+	set_priority(Priority priority)
+	{
+		this->priority = std::min(priority, PriorityHighest);
+	}
+
 	/// @returns if the fiber is attached to a scheduler.
 	[[nodiscard]] bool inline
 	isRunning() const
@@ -178,8 +258,9 @@ class Fiber : public fiber::Task
 	fiber::Stack<StackSize> stack;
 public:
 	template<class T>
-	Fiber(T&& task, fiber::Start start=fiber::Start::Now)
-	: Task(stack, std::forward<T>(task), start)
+	Fiber(T&& task, fiber::Start start=fiber::Start::Now,
+		  fiber::Priority priority=fiber::PriorityDefault)
+	: Task(stack, std::forward<T>(task), start, priority)
 	{}
 };
 
@@ -19,8 +19,9 @@ namespace modm::fiber
 {
 
 template<size_t Size, class T>
-Task::Task(Stack<Size>& stack, T&& closure, Start start)
+Task::Task(Stack<Size>& stack, T&& closure, Start start, Priority priority)
 {
+	set_priority(priority);
 	constexpr bool with_stop_token = std::is_invocable_r_v<void, T, stop_token>;
 	if constexpr (std::is_convertible_v<T, void(*)()> or
 				  std::is_convertible_v<T, void(*)(stop_token)>)
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This file is part of the modm project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <modm/architecture/interface/fiber.hpp>
+
+namespace modm::fiber
+{
+
+// forward declaration
+class Scheduler;
+class Task;
+
+/**
+ * Intrusive FIFO of fibers blocked on a synchronization primitive.
+ *
+ * A waiting fiber is removed from the round-robin of the scheduler and linked
+ * into the queue through its task object, so it costs nothing until it is
+ * notified or its timeout expires. `notify_one()` resumes the longest waiting
+ * fiber, which allows primitives to hand over ownership directly.
+ *
+ * The condition passed to the wait functions is called with interrupts
+ * disabled before the fiber is queued, so checking the state of the primitive
+ * and queueing is atomic with respect to notifications from interrupts.
+ *
+ * Outside of a fiber, the wait functions cannot suspend and only poll the
+ * condition: `wait()` calls it once, the timed waits busy-wait until it
+ * returns true or the timeout expires.
+ *
+ * @ingroup modm_processing_fiber
+ */
+class WaitQueue
+{
+	friend class Scheduler;
+	WaitQueue(const WaitQueue&) = delete;
+	WaitQueue& operator=(const WaitQueue&) = delete;
+
+	Task* first{nullptr};
+	Task* last{nullptr};
+
+	void
+	push(Task* task);
+
+	Task*
+	pop();
+
+	void
+	remove(Task* task);
+
+	template< class Condition >
+	bool
+	block(Condition& condition, const uint32_t* deadline);
+
+public:
+	constexpr WaitQueue() = default;
+
+	/// @note This function can be called from an interrupt.
+	[[nodiscard]] bool inline
+	empty() const
+	{
+		return first == nullptr;
+	}
+
+	/**
+	 * Suspends the current fiber until it is notified, unless `bool condition()`
+	 * returns true.
+	 *
+	 * @returns true if the condition returned true or the fiber was notified.
+	 */
+	template< class Condition >
+	bool
+	wait(Condition&& condition)
+	{
+		return block(condition, nullptr);
+	}
+
+	/**
+	 * Suspends the current fiber until it is notified or the timeout expires,
+	 * unless `bool condition()` returns true.
+	 *
+	 * @returns false if the timeout expired.
+	 */
+	template< class Rep, class Period, class Condition >
+	bool
+	wait_for(std::chrono::duration<Rep, Period> timeout, Condition&& condition);
+
+	/**
+	 * Suspends the current fiber until it is notified or the time point has
+	 * been reached, unless `bool condition()` returns true.
+	 *
+	 * @returns false if the time point has been reached.
+	 */
+	template< class Clock, class Duration, class Condition >
+	bool
+	wait_until(std::chrono::time_point<Clock, Duration> time, Condition&& condition)
+	{
+		return wait_for(this_fiber::detail::until(time), std::forward<Condition>(condition));
+	}
+
+	/**
+	 * Resumes the longest waiting fiber.
+	 *
+	 * @returns the id of the resumed fiber or zero if no fiber is waiting.
+	 * @note This function can be called from an interrupt.
+	 */
+	fiber::id
+	notify_one();
+
+	/**
+	 * Resumes all waiting fibers.
+	 *
+	 * @returns the number of resumed fibers.
+	 * @note This function can be called from an interrupt.
+	 */
+	std::size_t
+	notify_all();
+};
+
+}	// namespace modm::fiber
+
+// carefully avoid incomplete type issues
+#include "task.hpp"
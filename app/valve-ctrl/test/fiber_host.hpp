@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Simulated Cortex-M core for running the fiber scheduler on the host.
+//
+// The fiber contexts are ucontext stacks. Time is virtual and counted in core
+// cycles: it only advances when the code under test calls `host::run()` to
+// model its work, reads the clock, switches fibers, or sleeps in WFI until
+// the next simulated interrupt. The DWT cycle counter only advances while the
+// core is awake, like on the target. A due interrupt runs as soon as no atomic
+// lock is held. Include this file in one test only.
+
+#pragma once
+
+#include <ucontext.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <modm/processing/fiber.hpp>
+
+namespace host
+{
+
+constexpr uint64_t CyclesPerUs = 168;
+/// cycles of one micro_clock::now() call
+constexpr uint64_t ClockCost = 40;
+/// cycles of one context switch
+constexpr uint64_t SwitchCost = 100;
+/// SysTick at 4Hz, counting the core clock divided by 8
+constexpr uint64_t SysTickPeriod = 250'000 * CyclesPerUs;
+
+/// cycles since reset
+inline uint64_t time{0};
+/// cycles with the core running
+inline uint64_t awake{0};
+/// WFI calls that slept until an interrupt
+inline uint64_t wakeups{0};
+
+/// time of the simulated peripheral interrupt, e.g. a timer, or ~0 if none
+inline uint64_t alarm{~0ull};
+inline void (*alarm_handler)(){nullptr};
+/// exception number while the interrupt runs
+inline uint32_t ipsr{0};
+
+/// Runs the peripheral interrupt if it is due and interrupts are enabled.
+inline void
+interrupt()
+{
+	if (alarm > time or ipsr or modm::atomic::lock_depth) return;
+	alarm = ~0ull;
+	ipsr = 16;
+	if (alarm_handler) alarm_handler();
+	ipsr = 0;
+}
+
+inline const bool unlock_hook = (modm::atomic::unlocked = interrupt, true);
+
+/// Runs the core for a number of cycles, preempted by the interrupts that are due.
+inline void
+run(uint64_t cycles)
+{
+	while (alarm < time + cycles and not ipsr and not modm::atomic::lock_depth)
+	{
+		const uint64_t slice = alarm > time ? alarm - time : 0;
+		time += slice;
+		awake += slice;
+		cycles -= slice;
+		interrupt();
+	}
+	time += cycles;
+	awake += cycles;
+	interrupt();
+}
+
+inline void
+run_us(uint64_t us)
+{ run(us * CyclesPerUs); }
+
+inline double
+seconds()
+{ return double(time) / (CyclesPerUs * 1'000'000); }
+
+} // namespace host
+
+uint32_t
+host_cycles()
+{ return uint32_t(host::awake); }
+
+uint32_t
+host_ipsr()
+{ return host::ipsr; }
+
+uint32_t
+host_primask()
+{ return modm::atomic::lock_depth != 0; }
+
+uint32_t
+host_systick_value()
+{
+	const uint32_t load = SysTick->LOAD;
+	return load - (host::time % host::SysTickPeriod) * (load + 1ull) / host::SysTickPeriod;
+}
+
+void
+host_wfi()
+{
+	uint64_t next = host::alarm;
+	if (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk)
+		next = std::min(next, (host::time / host::SysTickPeriod + 1) * host::SysTickPeriod);
+	if (next == ~0ull)
+	{
+		std::fprintf(stderr, "WFI without a wakeup source\n");
+		std::abort();
+	}
+	if (next > host::time)
+	{
+		host::time = next;
+		host::wakeups++;
+	}
+	// the interrupt runs once the scheduler enables interrupts again
+	host::interrupt();
+}
+
+modm::chrono::micro_clock::time_point
+modm::chrono::micro_clock::now() noexcept
+{
+	host::run(host::ClockCost);
+	return time_point{duration{uint32_t(host::time / host::CyclesPerUs)}};
+}
+
+modm::chrono::milli_clock::time_point
+modm::chrono::milli_clock::now() noexcept
+{
+	host::run(host::ClockCost);
+	return time_point{duration{uint32_t(host::time / host::CyclesPerUs / 1000)}};
+}
+
+// ----------------------------------------------------------------------------
+// Fiber contexts on ucontext stacks
+namespace host
+{
+
+struct Context
+{
+	modm_context_t *context;
+	ucontext_t ucontext;
+	uintptr_t function;
+	uintptr_t argument;
+};
+
+inline ucontext_t main_context;
+inline std::vector<Context*> contexts;
+
+inline Context*
+find(modm_context_t *context)
+{
+	for (Context *ctx : contexts) if (ctx->context == context) return ctx;
+	contexts.push_back(new Context{context, {}, 0, 0});
+	return contexts.back();
+}
+
+inline void
+trampoline(unsigned high, unsigned low)
+{
+	Context *ctx = reinterpret_cast<Context*>((uintptr_t(high) << 32) | low);
+	reinterpret_cast<void(*)(uintptr_t)>(ctx->function)(ctx->argument);
+}
+
+} // namespace host
+
+extern "C" void
+modm_context_init(modm_context_t *ctx, uintptr_t *bottom, uintptr_t *top, uintptr_t fn, uintptr_t arg)
+{
+	ctx->bottom = bottom;
+	ctx->top = top;
+	host::Context *context = host::find(ctx);
+	context->function = fn;
+	context->argument = arg;
+}
+
+extern "C" void
+modm_context_reset(modm_context_t *ctx)
+{
+	host::Context *context = host::find(ctx);
+	getcontext(&context->ucontext);
+	context->ucontext.uc_stack.ss_sp = ctx->bottom;
+	context->ucontext.uc_stack.ss_size = (ctx->top - ctx->bottom) * sizeof(uintptr_t);
+	context->ucontext.uc_link = &host::main_context;
+	const uintptr_t pointer = reinterpret_cast<uintptr_t>(context);
+	makecontext(&context->ucontext, reinterpret_cast<void(*)()>(host::trampoline), 2,
+				unsigned(pointer >> 32), unsigned(pointer));
+}
+
+extern "C" uintptr_t
+modm_context_start(modm_context_t *to)
+{
+	swapcontext(&host::main_context, &host::find(to)->ucontext);
+	return 0;
+}
+
+extern "C" void
+modm_context_jump(modm_context_t *from, modm_context_t *to)
+{
+	if (modm::atomic::lock_depth)
+	{
+		std::fprintf(stderr, "context switch inside an atomic lock\n");
+		std::abort();
+	}
+	host::run(host::SwitchCost);
+	if (from != to) swapcontext(&host::find(from)->ucontext, &host::find(to)->ucontext);
+}
+
+extern "C" void
+modm_context_end(uintptr_t)
+{
+	setcontext(&host::main_context);
+	std::abort();
+}
+
+extern "C" void
+modm_context_stack_watermark(modm_context_t *) {}
+
+extern "C" size_t
+modm_context_stack_usage(const modm_context_t *)
+{ return 0; }
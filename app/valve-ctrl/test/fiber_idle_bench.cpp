@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Idle behaviour of the fiber scheduler with the fibers of the application.
+//
+// The log fiber runs every 5ms, the command fiber every 10ms and the report
+// fiber every 10s, each for a few microseconds. Built with USE_TIMER=0 the
+// scheduler uses the default idle hook, which only sleeps if the 4Hz SysTick
+// fires before the next fiber is due. With USE_TIMER=1 it uses the FiberIdle
+// hook of the application on a simulated one-pulse timer. The benchmark
+// prints the WFI wakeups per second, the share of time the core really slept
+// and the idle share that the scheduler reports.
+
+#include "fiber_host.hpp"
+#include "../fiber_idle.hpp"
+
+#ifndef USE_TIMER
+#define USE_TIMER 0
+#endif
+
+#if USE_TIMER
+/// One-pulse timer at the core clock, its expiry raises the host alarm.
+struct SimTimer
+{
+	enum class Mode { UpCounter, OneShotUpCounter };
+	enum class Interrupt { Update };
+	enum class InterruptFlag { Update };
+
+	static inline uint16_t prescaler{1};
+	static inline uint16_t overflow{0};
+	static inline uint32_t acknowledged{0};
+
+	static void enable() {}
+	static void setMode(Mode) {}
+	static void setPrescaler(uint16_t value) { prescaler = value; }
+	static void setOverflow(uint16_t value) { overflow = value; }
+	static void applyAndReset() {}
+	static void enableInterrupt(Interrupt) {}
+	static void enableInterruptVector(Interrupt, bool, uint32_t) {}
+	static void acknowledgeInterruptFlags(InterruptFlag) { acknowledged++; }
+
+	static void
+	start()
+	{ host::alarm = host::time + uint64_t(overflow + 1) * prescaler; }
+
+	static void
+	pause()
+	{ host::alarm = ~0ull; }
+};
+
+extern "C" void
+modm_fiber_idle(uint32_t duration)
+{
+	FiberIdle<SimTimer>::sleep(duration);
+}
+#endif
+
+constexpr double Seconds = 60;
+static bool
+running()
+{ return host::seconds() < Seconds; }
+
+modm::Fiber<16384> log_fiber([]
+{
+	while (running())
+	{
+		host::run_us(20);
+		modm::this_fiber::sleep_for(std::chrono::milliseconds(5));
+	}
+}, modm::fiber::Start::Later, modm::fiber::PriorityLowest);
+
+modm::Fiber<16384> command_fiber([]
+{
+	while (running())
+	{
+		host::run_us(10);
+		modm::this_fiber::sleep_for(std::chrono::milliseconds(10));
+	}
+}, modm::fiber::Start::Later);
+
+modm::Fiber<16384> report_fiber([]
+{
+	while (running())
+	{
+		modm::this_fiber::sleep_for(std::chrono::seconds(10));
+		host::run_us(500);
+	}
+}, modm::fiber::Start::Later);
+
+int
+main()
+{
+	// SysTick at 4Hz from the core clock divided by 8
+	SysTick->LOAD = SystemCoreClock / 8 / 4 - 1;
+	SysTick->CTRL = SysTick_CTRL_ENABLE_Msk;
+#if USE_TIMER
+	FiberIdle<SimTimer>::initialize(host::CyclesPerUs, 15);
+	host::alarm_handler = [] { FiberIdle<SimTimer>::handleInterrupt(); };
+#endif
+
+	log_fiber.start();
+	command_fiber.start();
+	report_fiber.start();
+	modm::fiber::Scheduler::run();
+
+	const double seconds = host::seconds();
+	const double asleep = 1 - double(host::awake) / host::time;
+	const modm::fiber::CpuTime idle = modm::fiber::Scheduler::getIdleTime();
+	const double reported = double(idle.cycles) / host::time;
+	std::printf("%s idle hook, %.0fs of fibers sleeping 5ms, 10ms and 10s:\n",
+				USE_TIMER ? "timer" : "systick", seconds);
+	std::printf("  %8.0f idle calls/s %8.1f wakeups/s\n", idle.switches / seconds, host::wakeups / seconds);
+	std::printf("  %7.2f%% asleep      %7.2f%% reported idle\n", 100 * asleep, 100 * reported);
+	return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Multi-producer stress test of modm::log::Ring with real threads.
+//
+// Several threads reserve and commit records concurrently while the main
+// thread drains them. Every record carries its producer and sequence number,
+// so lost, duplicated, reordered or torn records are detected. The same is
+// checked for whole lines written through RingDevice, including the fallback
+// when there are more writers than line buffers. Build with `make tsan` to
+// run it under ThreadSanitizer.
+
+#include <modm/debug/logger/ring.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (not (condition)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; } } while(0)
+
+/// Producers and drain of raw records, each with a producer id and sequence.
+static void
+records()
+{
+	constexpr int Producers = 4;
+	constexpr uint32_t Messages = 100'000;
+	static modm::log::Ring<1024> ring;
+
+	std::vector<std::thread> threads;
+	for (int producer = 0; producer < Producers; producer++)
+	{
+		threads.emplace_back([producer]
+		{
+			unsigned seed = producer;
+			for (uint32_t seq = 0; seq < Messages; )
+			{
+				uint8_t message[64];
+				const std::size_t length = 8 + rand_r(&seed) % 56;
+				message[0] = producer;
+				std::memcpy(message + 1, &seq, 4);
+				for (std::size_t ii = 5; ii < length; ii++) message[ii] = uint8_t(seq + ii);
+				if (uint8_t *data = ring.reserve(length, modm::log::Level(producer % 4)))
+				{
+					std::memcpy(data, message, length);
+					ring.commit(data);
+					seq++;
+				}
+				else std::this_thread::yield();
+			}
+		});
+	}
+
+	uint32_t expected[Producers]{};
+	uint64_t count{0}, errors{0};
+	const auto done = [&]
+	{
+		for (uint32_t seq : expected) if (seq != Messages) return false;
+		return true;
+	};
+	while (not done())
+	{
+		if (ring.isEmpty()) std::this_thread::yield();
+		count += ring.drain([&](const auto &record)
+		{
+			const uint8_t *message = record.data();
+			const int producer = message[0];
+			uint32_t seq;
+			std::memcpy(&seq, message + 1, 4);
+			if (producer >= Producers or seq != expected[producer] or
+				record.level != producer % 4 or record.length < 8)
+			{
+				if (errors++ < 5) std::printf("record from %d: seq %u unexpected\n", producer, seq);
+				return;
+			}
+			for (std::size_t ii = 5; ii < record.length; ii++)
+				if (message[ii] != uint8_t(seq + ii)) { errors++; break; }
+			expected[producer]++;
+		});
+	}
+	for (auto &thread : threads) thread.join();
+
+	std::printf("records: %llu drained, %llu errors, %u dropped\n",
+				(unsigned long long) count, (unsigned long long) errors, ring.getDropped());
+	CHECK(errors == 0);
+	CHECK(count == Producers * Messages);
+	CHECK(ring.isEmpty());
+}
+
+struct Collect : modm::IODevice
+{
+	std::string out;
+	using IODevice::write;
+	void write(char c) override { out += c; }
+	void write(const char *data, std::size_t length) override { out.append(data, length); }
+	void flush() override {}
+	bool read(char&) override { return false; }
+};
+
+/// Threads write lines in fragments, each line must arrive whole and prefixed.
+template< class Ring, class Device >
+static void
+lines(Ring &ring, Device &device, int producers, int count, char level)
+{
+	const uint32_t dropped = ring.getDropped();
+	Collect sink;
+	std::atomic<int> finished{0};
+	std::vector<std::thread> threads;
+	for (int producer = 0; producer < producers; producer++)
+	{
+		threads.emplace_back([&, producer]
+		{
+			for (int seq = 0; seq < count; seq++)
+			{
+				char number[16];
+				std::snprintf(number, sizeof(number), "%d", seq);
+				device.write("T");
+				device.write(char('0' + producer));
+				device.write(" ");
+				device.write(number);
+				for (int ii = 0; ii < 5; ii++) { device.write(" ab"); device.write('c'); }
+				device.write('\n');
+				std::this_thread::sleep_for(std::chrono::microseconds(20));
+			}
+			finished++;
+		});
+	}
+	while (finished < producers or not ring.isEmpty())
+	{
+		ring.drain(sink);
+		std::this_thread::yield();
+	}
+	for (auto &thread : threads) thread.join();
+	ring.drain(sink);
+
+	std::istringstream in(sink.out);
+	std::string line;
+	std::map<int, int> next;
+	int received{0}, errors{0};
+	while (std::getline(in, line))
+	{
+		unsigned long seconds, micros;
+		char prefix;
+		int producer, seq;
+		const auto body = line.find(' ', line.find('T') + 3);
+		if (std::sscanf(line.c_str(), "%lu.%06lu %c T%d %d", &seconds, &micros, &prefix, &producer, &seq) != 5 or
+			prefix != level or body == std::string::npos or
+			line.substr(body) != " abc abc abc abc abc" or seq < next[producer])
+		{
+			if (errors++ < 3) std::printf("torn line: '%s'\n", line.c_str());
+			continue;
+		}
+		next[producer] = seq + 1;
+		received++;
+	}
+	std::printf("lines: %d of %d received, %d errors, %u dropped\n",
+				received, producers * count, errors, ring.getDropped());
+	CHECK(errors == 0);
+	if (ring.getDropped() == dropped) CHECK(received == producers * count);
+}
+
+int
+main()
+{
+	records();
+
+	static modm::log::Ring<2048> ring;
+	{
+		// every thread owns a line buffer
+		modm::log::RingDevice<decltype(ring), 80, 4> device(ring, modm::log::INFO);
+		lines(ring, device, 3, 20'000, 'I');
+	}
+	{
+		// more threads than line buffers, the others write unbuffered
+		// fragments, which may interleave, but still must not be torn
+		modm::log::RingDevice<decltype(ring), 80, 2> device(ring, modm::log::WARNING);
+		Collect sink;
+		std::vector<std::thread> threads;
+		for (int producer = 0; producer < 4; producer++)
+		{
+			threads.emplace_back([&, producer]
+			{
+				for (int seq = 0; seq < 2000; seq++)
+				{
+					device.write("T");
+					device.write(char('0' + producer));
+					device.write(" fragment\n");
+				}
+			});
+		}
+		for (auto &thread : threads) thread.join();
+		ring.drain(sink);
+		CHECK(sink.out.find("T") != std::string::npos);
+		std::printf("fallback: %zu bytes\n", sink.out.size());
+	}
+	{
+		// lines longer than the buffer are split, flush() ends a partial line
+		modm::log::RingDevice<decltype(ring), 80, 4> device(ring, modm::log::INFO);
+		Collect sink;
+		device.write(std::string(200, 'x').c_str());
+		device.flush();
+		device.write("tail\n");
+		ring.drain(sink);
+		CHECK(sink.out.find(std::string(80, 'x')) != std::string::npos);
+		CHECK(sink.out.find("tail\n") != std::string::npos);
+		CHECK(std::count(sink.out.begin(), sink.out.end(), 'x') == 200);
+	}
+
+	std::printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
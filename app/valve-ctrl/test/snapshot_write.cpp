@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Snapshot records written to a device that accepts only part of the frame
+// per call, so the writer has to yield. The device checks that it is never
+// written inside an atomic lock, the decoded record must match the storage.
+
+#include <modm/debug/telemetry/snapshot.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define REQUIRE(condition) \
+	do { if (not (condition)) { std::fprintf(stderr, "%s:%d: REQUIRE(%s) failed\n", __FILE__, __LINE__, #condition); std::abort(); } } while(0)
+
+uint32_t large[300];
+float small[8];
+uint8_t flag;
+constexpr modm::telemetry::SnapshotField fields[] = {
+	{"large", large},
+	{"small", small},
+	{"flag", flag},
+};
+
+struct Device
+{
+	std::vector<uint8_t> out;
+	std::size_t calls{0};
+
+	/// takes at most 100 bytes and nothing on every other call
+	std::size_t
+	write(const uint8_t *data, std::size_t length)
+	{
+		REQUIRE(modm::atomic::lock_depth == 0);
+		if (calls++ % 2) return 0;
+		length = std::min<std::size_t>(length, 100);
+		out.insert(out.end(), data, data + length);
+		return length;
+	}
+};
+
+static std::vector<uint8_t>
+decode(const std::vector<uint8_t> &encoded)
+{
+	std::vector<uint8_t> frame;
+	REQUIRE(not encoded.empty() and encoded.back() == 0);
+	for (std::size_t ii = 0; ii + 1 < encoded.size(); )
+	{
+		const uint8_t code = encoded[ii];
+		REQUIRE(code != 0 and ii + code < encoded.size());
+		frame.insert(frame.end(), &encoded[ii + 1], &encoded[ii + code]);
+		ii += code;
+		if (code < 0xff and ii + 1 < encoded.size()) frame.push_back(0);
+	}
+	return frame;
+}
+
+int
+main()
+{
+	for (std::size_t ii = 0; ii < std::size(large); ii++) large[ii] = ii * 0x0101'0101u;
+	for (std::size_t ii = 0; ii < std::size(small); ii++) small[ii] = ii * 0.5f;
+	flag = 1;
+
+	const modm::telemetry::Snapshot snapshot(fields);
+	Device device;
+	snapshot.write(device, 42);
+	REQUIRE(device.out.size() <= snapshot.encodedSize());
+
+	const std::vector<uint8_t> frame = decode(device.out);
+	REQUIRE(frame.size() == 3 + snapshot.HeaderSize + snapshot.getValueSize() + 2);
+	const uint16_t crc = modm::math::crc16_ccitt_update(modm::math::crc16_ccitt_init,
+			std::span<const uint8_t>(frame.data(), frame.size() - 2));
+	REQUIRE(crc == (frame[frame.size() - 2] | frame[frame.size() - 1] << 8));
+	REQUIRE(frame[0] == snapshot.Response and frame[1] == 42 and frame[2] == 0);
+	REQUIRE(frame[3] == snapshot.Version);
+	REQUIRE((frame[4] | frame[5] << 8) == snapshot.getSchemaId());
+
+	const uint8_t *values = frame.data() + 3 + snapshot.HeaderSize;
+	REQUIRE(std::memcmp(values, large, sizeof(large)) == 0);
+	REQUIRE(std::memcmp(values + sizeof(large), small, sizeof(small)) == 0);
+	REQUIRE(values[sizeof(large) + sizeof(small)] == 1);
+
+	std::printf("snapshot: %zu byte frame in %zu device writes\n", device.out.size(), device.calls);
+	std::printf("OK\n");
+	return 0;
+}
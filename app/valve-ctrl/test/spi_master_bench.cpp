@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// CPU time of SpiMaster1 block transfers per KB on the simulated SPI1.
+//
+// A fiber transfers 1KB in blocks of 8 and of 1024 bytes at every prescaler,
+// while a background fiber runs in slices of 1000 cycles. The CPU time of the
+// transfer is the wall time minus the time the background fiber would have
+// needed for its work without the transfer, so it includes the polling, the
+// interrupts and the fiber switches of the transfer.
+
+#include "spi_master_host.hpp"
+
+#include <utility>
+
+using modm::platform::SpiMaster1;
+
+static bool finished{false};
+static uint64_t background{0};
+/// share of the time the background fiber works when it runs alone
+static double efficiency{1};
+static modm::fiber::event_flags calibrated;
+
+template< unsigned... index >
+static void
+prescalers(std::integer_sequence<unsigned, index...>)
+{
+	([]
+	{
+		host::spi::initialize<index>();
+		std::printf("  1/%-4u %6.2fus", host::spi::prescaler,
+					double(host::spi::byteCycles()) / host::CyclesPerUs);
+		for (std::size_t length : {8, 1024})
+		{
+			static uint8_t tx[1024], rx[1024];
+			host::spi::interrupts = 0;
+			background = 0;
+			const uint64_t start = host::time;
+			for (std::size_t offset = 0; offset < sizeof(tx); offset += length)
+				SpiMaster1::transfer(tx + offset, rx + offset, length);
+			const uint64_t wall = host::time - start;
+			std::printf(" %6s %8.0fus %8.0fus", host::spi::interrupts ? "irq" : "poll",
+						double(wall) / host::CyclesPerUs,
+						(wall - background / efficiency) / host::CyclesPerUs);
+		}
+		std::printf("\n");
+	}(), ...);
+}
+
+modm::Fiber<16384> bench_fiber([]
+{
+	// the background fiber alone, while this fiber waits like for a transfer
+	background = 0;
+	const uint64_t start = host::time;
+	calibrated.wait_any(1);
+	efficiency = double(background) / (host::time - start);
+
+	std::printf("SPI1 transfers of 1KB, wall and CPU time:\n");
+	std::printf("  %-13s %30s %30s\n", "prescaler", "8 byte blocks", "1024 byte blocks");
+	prescalers(std::make_integer_sequence<unsigned, 8>());
+	finished = true;
+}, modm::fiber::Start::Later);
+
+modm::Fiber<16384> background_fiber([]
+{
+	while (not finished)
+	{
+		host::run(1000);
+		background += 1000;
+		if (background == 1'000'000 and efficiency == 1) calibrated.set(1);
+		modm::this_fiber::yield();
+	}
+}, modm::fiber::Start::Later);
+
+int
+main()
+{
+	SysTick->LOAD = SystemCoreClock / 8 / 4 - 1;
+	SysTick->CTRL = SysTick_CTRL_ENABLE_Msk;
+
+	bench_fiber.start();
+	background_fiber.start();
+	modm::fiber::Scheduler::run();
+	return 0;
+}
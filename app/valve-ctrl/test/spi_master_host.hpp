@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Simulated SPI1 on the simulated core of `fiber_host.hpp`, with the SpiMaster1
+// driver compiled against it.
+//
+// The peripheral has a transmit buffer and a shift register: a written byte
+// moves into the shift register when it is idle and is received after
+// `byteCycles()`. The slave answers every byte with `response()`. Every
+// register access costs `RegisterCost` cycles and the RXNE interrupt costs
+// `InterruptCost` for entry, exit and the handler code around the register
+// accesses. Include this file in one test only.
+
+#pragma once
+
+#include "fiber_host.hpp"
+
+#include <modm/platform/device.hpp>
+
+#define SPI_CR1_CPHA		(1ul << 0)
+#define SPI_CR1_CPOL		(1ul << 1)
+#define SPI_CR1_MSTR		(1ul << 2)
+#define SPI_CR1_BR_Pos		3
+#define SPI_CR1_LSBFIRST	(1ul << 7)
+#define SPI_CR1_DFF			(1ul << 11)
+
+// replaces the register access of the driver
+#define MODM_STM32_SPI_HAL1_HPP
+
+namespace host::spi
+{
+
+/// cycles of one access to a peripheral register on APB2
+constexpr uint64_t RegisterCost = 6;
+/// cycles of the interrupt entry, exit and handler code from flash with wait
+/// states, so that an interrupt with its two register accesses costs the
+/// `SpiMaster1::InterruptCycles` that the driver assumes
+constexpr uint64_t InterruptCost = 148;
+
+inline uint8_t
+response(uint8_t tx)
+{ return uint8_t(tx * 7 + 3); }
+
+inline uint32_t prescaler{2};
+inline bool interrupt{false};
+inline bool shifting{false};
+inline uint8_t shift{0};
+inline uint64_t shift_end{0};
+inline bool tx_full{false};
+inline uint8_t tx{0};
+inline bool rx_full{false};
+inline uint8_t rx{0};
+/// received bytes that overwrote an unread byte
+inline uint32_t overruns{0};
+/// RXNE interrupts
+inline uint32_t interrupts{0};
+
+/// core cycles per byte, the SPI clock is APB2 at half the core clock
+inline uint64_t
+byteCycles()
+{ return 8 * 2 * prescaler; }
+
+/// Advances the shift register to the current time.
+inline void
+update()
+{
+	while (shifting and shift_end <= host::time)
+	{
+		if (rx_full) overruns++;
+		rx = response(shift);
+		rx_full = true;
+		shifting = tx_full;
+		if (tx_full)
+		{
+			shift = tx;
+			shift_end += byteCycles();
+			tx_full = false;
+		}
+	}
+}
+
+/// Raises the RXNE interrupt when the next byte is received.
+inline void
+schedule()
+{
+	if (not interrupt) host::alarm = ~0ull;
+	else if (rx_full) host::alarm = host::time;
+	else if (shifting) host::alarm = shift_end;
+}
+
+inline void
+access()
+{
+	host::run(RegisterCost);
+	update();
+}
+
+inline void
+reset()
+{
+	interrupt = shifting = tx_full = rx_full = false;
+	overruns = interrupts = 0;
+	host::alarm = ~0ull;
+}
+
+} // namespace host::spi
+
+namespace modm::platform
+{
+
+class SpiHal1
+{
+public:
+	enum class Interrupt : uint32_t { RxBufferNotEmpty = 1 << 6 };
+	enum class MasterSelection : uint32_t { Slave = 0, Master = SPI_CR1_MSTR };
+	enum class DataMode : uint32_t { Mode0 = 0, Mode3 = SPI_CR1_CPOL | SPI_CR1_CPHA };
+	enum class DataOrder : uint32_t { MsbFirst = 0, LsbFirst = SPI_CR1_LSBFIRST };
+	enum class DataSize : uint32_t { Bit8 = 0, Bit16 = SPI_CR1_DFF };
+	enum class Prescaler : uint32_t { Div2 = 0 };
+
+	static void
+	initialize(Prescaler prescaler)
+	{
+		host::spi::reset();
+		host::spi::prescaler = 2u << (uint32_t(prescaler) >> SPI_CR1_BR_Pos);
+	}
+
+	static void enableInterruptVector(bool, uint32_t) {}
+	static void enableTransfer() {}
+	static void disableTransfer() {}
+	static void setDataMode(DataMode) {}
+	static void setDataOrder(DataOrder) {}
+	static void setDataSize(DataSize) {}
+
+	static bool
+	isTransmitRegisterEmpty()
+	{
+		host::spi::access();
+		return not host::spi::tx_full;
+	}
+
+	static bool
+	isReceiveRegisterNotEmpty()
+	{
+		host::spi::access();
+		return host::spi::rx_full;
+	}
+
+	static void
+	write(uint8_t data)
+	{
+		using namespace host::spi;
+		access();
+		if (shifting)
+		{
+			tx = data;
+			tx_full = true;
+		}
+		else
+		{
+			shift = data;
+			shift_end = host::time + byteCycles();
+			shifting = true;
+		}
+		schedule();
+	}
+
+	static void
+	read(uint8_t &data)
+	{
+		using namespace host::spi;
+		access();
+		data = rx;
+		rx_full = false;
+		schedule();
+	}
+
+	static void
+	enableInterrupt(Interrupt)
+	{
+		host::spi::access();
+		host::spi::interrupt = true;
+		host::spi::schedule();
+	}
+
+	static void
+	disableInterrupt(Interrupt)
+	{
+		host::spi::access();
+		host::spi::interrupt = false;
+		host::spi::schedule();
+	}
+};
+
+} // namespace modm::platform
+
+#include "../modm/src/modm/platform/spi/spi_master_1.cpp"
+
+namespace host::spi
+{
+
+/// Routes the simulated interrupt to the driver.
+inline const bool vector = (host::alarm_handler = []
+{
+	interrupts++;
+	host::run(InterruptCost);
+	SPI1_isr();
+}, true);
+
+/// Clock tree of the board with SPI1 on APB2.
+struct SystemClock
+{
+	static constexpr uint32_t Frequency = 168'000'000;
+	static constexpr uint32_t Spi1 = Frequency / 2;
+};
+
+/// Configures SPI1 with the prescaler 2^(index+1).
+template< unsigned index >
+void
+initialize()
+{
+	modm::platform::SpiMaster1::initialize<SystemClock, SystemClock::Spi1 / (2u << index)>();
+}
+
+} // namespace host::spi
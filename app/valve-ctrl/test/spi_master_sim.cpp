@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// SpiMaster1 block transfers on the simulated SPI1 at every prescaler.
+//
+// Every block must arrive complete without overruns, in the mode the driver
+// promises: polled at high baudrates, for short blocks, in an interrupt and
+// inside an atomic lock, otherwise driven by the RXNE interrupt while another
+// fiber keeps running.
+
+#include "spi_master_host.hpp"
+
+#include <utility>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (not (condition)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; } } while(0)
+
+using modm::platform::SpiMaster1;
+
+static bool finished{false};
+/// cycles the background fiber ran during transfers
+static uint64_t background{0};
+
+/// mode the driver must choose in thread mode
+static bool
+interrupted(std::size_t length)
+{
+	const uint64_t cycles = host::spi::byteCycles();
+	return cycles > SpiMaster1::InterruptCycles and
+			length * (cycles - SpiMaster1::InterruptCycles) > SpiMaster1::SuspendCycles;
+}
+
+/// Transfers a block and checks the received bytes and the mode.
+static void
+block(std::size_t length, bool send, bool receive, bool polled = false)
+{
+	std::vector<uint8_t> tx(length), rx(length, 0xaa);
+	for (std::size_t ii = 0; ii < length; ii++) tx[ii] = uint8_t(ii * 13 + length);
+	host::spi::interrupts = 0;
+	const uint64_t start = host::time;
+
+	SpiMaster1::transfer(send ? tx.data() : nullptr, receive ? rx.data() : nullptr, length);
+
+	const uint64_t minimum = length * host::spi::byteCycles();
+	CHECK(host::time - start >= minimum);
+	CHECK(host::spi::overruns == 0);
+	CHECK(not host::spi::interrupt and not host::spi::shifting and not host::spi::rx_full);
+	const bool expected = not polled and interrupted(length);
+	CHECK((host::spi::interrupts == length) == expected);
+	CHECK((host::spi::interrupts == 0) == not expected);
+	for (std::size_t ii = 0; ii < length; ii++)
+	{
+		const uint8_t value = receive ? host::spi::response(send ? tx[ii] : 0) : 0xaa;
+		if (rx[ii] != value)
+		{
+			std::printf("prescaler %u length %zu: rx[%zu] = %02x, expected %02x\n",
+						host::spi::prescaler, length, ii, rx[ii], value);
+			failures++;
+			break;
+		}
+	}
+}
+
+template< unsigned... index >
+static void
+prescalers(std::integer_sequence<unsigned, index...>)
+{
+	([]
+	{
+		host::spi::initialize<index>();
+		for (std::size_t length : {1, 2, 3, 7, 64, 1000})
+		{
+			block(length, true, true);
+			block(length, false, true);
+			block(length, true, false);
+		}
+
+		// the interrupt cannot preempt an interrupt or an atomic lock
+		host::ipsr = 11;
+		block(300, true, true, true);
+		host::ipsr = 0;
+		{
+			modm::atomic::Lock lock;
+			block(300, true, true, true);
+		}
+
+		// single bytes are always polled
+		host::spi::interrupts = 0;
+		CHECK(SpiMaster1::transfer(uint8_t(0x42)) == host::spi::response(0x42));
+		CHECK(host::spi::interrupts == 0);
+	}(), ...);
+}
+
+modm::Fiber<16384> test_fiber([]
+{
+	prescalers(std::make_integer_sequence<unsigned, 8>());
+
+	// the background fiber gets most of the time of a slow transfer
+	host::spi::initialize<7>();
+	background = 0;
+	const uint64_t start = host::time;
+	block(1000, true, true);
+	const uint64_t duration = host::time - start;
+	std::printf("1000 bytes at 1/256: %.0fus, %.1f%% for the other fiber\n",
+				double(duration) / host::CyclesPerUs, 100. * background / duration);
+	CHECK(background > duration * 8 / 10);
+	finished = true;
+}, modm::fiber::Start::Later);
+
+modm::Fiber<16384> background_fiber([]
+{
+	while (not finished)
+	{
+		host::run(1000);
+		background += 1000;
+		modm::this_fiber::yield();
+	}
+}, modm::fiber::Start::Later);
+
+int
+main()
+{
+	SysTick->LOAD = SystemCoreClock / 8 / 4 - 1;
+	SysTick->CTRL = SysTick_CTRL_ENABLE_Msk;
+
+	test_fiber.start();
+	background_fiber.start();
+	modm::fiber::Scheduler::run();
+
+	std::printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Throughput of modm::SpscRing compared to modm::atomic::Queue.
+//
+// Bytes are passed between a producer and a consumer thread one at a time and
+// in blocks of 64 bytes, and within one thread, which is closer to an
+// interrupt and a fiber sharing one core. atomic::Queue only has single
+// elements and relies on volatile indices, so it is only measured one at a
+// time and is not safe between threads in the formal sense.
+
+#include <modm/architecture/driver/atomic/queue.hpp>
+#include <modm/architecture/driver/atomic/spsc_ring.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+constexpr uint32_t Count = 1u << 24;
+
+/// Runs the producer in a thread and the consumer in this one.
+template< class Producer, class Consumer >
+static double
+throughput(Producer &&producer, Consumer &&consumer)
+{
+	const auto start = std::chrono::steady_clock::now();
+	std::thread thread([&]
+	{
+		for (uint32_t count = 0; count < Count; )
+		{
+			const std::size_t pushed = producer();
+			if (pushed == 0) std::this_thread::yield();
+			count += pushed;
+		}
+	});
+	for (uint32_t count = 0; count < Count; )
+	{
+		const std::size_t popped = consumer();
+		if (popped == 0) std::this_thread::yield();
+		count += popped;
+	}
+	thread.join();
+	const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+	return Count / seconds.count() / 1e6;
+}
+
+/// Pushes and pops each byte in turn.
+template< class Function >
+static double
+interleaved(Function &&function)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (uint32_t count = 0; count < Count; count++) function(uint8_t(count));
+	const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+	return Count / seconds.count() / 1e6;
+}
+
+int
+main()
+{
+	static modm::SpscRing<uint8_t, 1024> ring;
+	static modm::atomic::Queue<uint8_t, 1023> queue;
+	uint8_t value{0};
+	std::printf("%u bytes, MB/s:        %10s %10s\n", Count, "SpscRing", "Queue");
+
+	const double ring_bytes = throughput(
+		[&] { return std::size_t(ring.push(uint8_t(1))); },
+		[&] { return std::size_t(ring.pop(value)); });
+	const double queue_bytes = throughput(
+		[&] { return std::size_t(queue.push(uint8_t(1))); },
+		[&]
+		{
+			if (queue.isEmpty()) return std::size_t(0);
+			value = queue.get();
+			queue.pop();
+			return std::size_t(1);
+		});
+	std::printf("  bytes, 2 threads       %10.1f %10.1f\n", ring_bytes, queue_bytes);
+
+	uint8_t in[64]{}, out[64];
+	const double ring_blocks = throughput(
+		[&] { return ring.push(std::span<const uint8_t>(in)); },
+		[&] { return ring.pop(std::span<uint8_t>(out)); });
+	std::printf("  64B blocks, 2 threads  %10.1f %10s\n", ring_blocks, "-");
+
+	const double ring_single = interleaved([&](uint8_t data)
+	{
+		ring.push(data);
+		ring.pop(value);
+	});
+	const double queue_single = interleaved([&](uint8_t data)
+	{
+		queue.push(data);
+		value = queue.get();
+		queue.pop();
+	});
+	std::printf("  bytes, 1 thread        %10.1f %10.1f\n", ring_single, queue_single);
+	return 0;
+}
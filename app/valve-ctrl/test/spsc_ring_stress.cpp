@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Stress test of modm::SpscRing with a producer and a consumer thread.
+//
+// The producer writes a running sequence through every producer API, single
+// elements, spans and reserve/commit, while the consumer reads it through
+// every consumer API. Lost, duplicated, reordered or torn elements break the
+// sequence. Build with `make tsan` to run it under ThreadSanitizer.
+
+#include <modm/architecture/driver/atomic/spsc_ring.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (not (condition)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; } } while(0)
+
+/// element larger than a word, so that a torn copy is detected
+struct Sample
+{
+	uint32_t seq{0};
+	uint32_t inverse{~0u};
+	uint64_t square{0};
+
+	static Sample
+	make(uint32_t seq)
+	{ return {seq, ~seq, uint64_t(seq) * seq}; }
+
+	bool
+	valid(uint32_t expected) const
+	{ return seq == expected and inverse == ~expected and square == uint64_t(expected) * expected; }
+};
+
+/// Single elements through push() and pop().
+static void
+elements()
+{
+	constexpr uint32_t Count = 2'000'000;
+	static modm::SpscRing<Sample, 64> ring;
+
+	std::thread producer([]
+	{
+		for (uint32_t seq = 0; seq < Count; )
+		{
+			if (ring.push(Sample::make(seq))) seq++;
+			else std::this_thread::yield();
+		}
+	});
+	uint32_t expected{0}, errors{0};
+	while (expected < Count)
+	{
+		Sample sample;
+		if (not ring.pop(sample)) { std::this_thread::yield(); continue; }
+		if (not sample.valid(expected) and errors++ < 5)
+			std::printf("element %u: seq %u unexpected\n", expected, sample.seq);
+		expected = sample.seq + 1;
+	}
+	producer.join();
+
+	std::printf("elements: %u received, %u errors\n", expected, errors);
+	CHECK(errors == 0);
+	CHECK(ring.isEmpty());
+}
+
+/// Bytes in random chunks, alternating between the span APIs on both sides.
+static void
+spans()
+{
+	constexpr uint32_t Count = 20'000'000;
+	static modm::SpscRing<uint8_t, 1024> ring;
+
+	std::thread producer([]
+	{
+		unsigned seed = 1;
+		uint8_t chunk[300];
+		for (uint32_t seq = 0; seq < Count; )
+		{
+			const std::size_t wanted = std::min<std::size_t>(rand_r(&seed) % 300, Count - seq);
+			std::size_t count;
+			if (seq & 1)
+			{
+				const std::span<uint8_t> space = ring.reserve();
+				count = std::min(space.size(), wanted);
+				for (std::size_t ii = 0; ii < count; ii++) space[ii] = uint8_t(seq + ii);
+				ring.commit(count);
+			}
+			else
+			{
+				for (std::size_t ii = 0; ii < wanted; ii++) chunk[ii] = uint8_t(seq + ii);
+				count = ring.push(std::span<const uint8_t>(chunk, wanted));
+			}
+			seq += count;
+			if (count == 0) std::this_thread::yield();
+		}
+	});
+	uint32_t expected{0}, errors{0};
+	uint8_t buffer[200];
+	while (expected < Count)
+	{
+		const bool peek = expected & 1;
+		const std::span<const uint8_t> data = peek ? ring.peek() :
+				std::span<const uint8_t>(buffer, ring.pop(std::span<uint8_t>(buffer)));
+		for (uint8_t value : data)
+		{
+			if (value != uint8_t(expected) and errors++ < 5)
+				std::printf("byte %u: %02x unexpected\n", expected, value);
+			expected++;
+		}
+		if (peek) ring.consume(data.size());
+		if (data.empty()) std::this_thread::yield();
+	}
+	producer.join();
+
+	std::printf("spans: %u bytes received, %u errors\n", expected, errors);
+	CHECK(errors == 0);
+	CHECK(ring.isEmpty());
+}
+
+int
+main()
+{
+	elements();
+	spans();
+
+	std::printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
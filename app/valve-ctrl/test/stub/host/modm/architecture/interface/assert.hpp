@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+#define modm_assert(condition, name, ...) \
+	do { if (not (condition)) { std::fprintf(stderr, "assertion '%s' failed\n", name); std::abort(); } } while(0)
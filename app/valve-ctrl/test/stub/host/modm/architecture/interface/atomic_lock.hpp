@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Counts the nesting of atomic locks instead of disabling interrupts, so a
+// test can check what is called inside a critical section. A simulated core
+// runs its pending interrupts in `unlocked()`.
+
+#pragma once
+
+namespace modm::atomic
+{
+
+inline int lock_depth = 0;
+inline void (*unlocked)() = nullptr;
+
+class Lock
+{
+public:
+	Lock() { lock_depth++; }
+	~Lock() { if (--lock_depth == 0 and unlocked) unlocked(); }
+};
+
+class Unlock
+{
+public:
+	Unlock() { if (--lock_depth == 0 and unlocked) unlocked(); }
+	~Unlock() { lock_depth++; }
+};
+
+} // namespace modm::atomic
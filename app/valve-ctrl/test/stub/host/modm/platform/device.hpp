@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Core registers and intrinsics used by the firmware modules. The values come
+// from the simulated core of the test, which defines the `host_*` functions.
+
+#pragma once
+
+#include <stdint.h>
+
+/// cycles the core has been running, the DWT counter stops during WFI
+uint32_t host_cycles();
+/// sleeps until the next simulated interrupt
+void host_wfi();
+/// SysTick counter, counting down from LOAD
+uint32_t host_systick_value();
+/// exception number of the active simulated interrupt, zero in thread mode
+uint32_t host_ipsr();
+/// set while a simulated atomic lock is held
+uint32_t host_primask();
+
+inline uint32_t __get_IPSR() { return host_ipsr(); }
+inline uint32_t __get_PRIMASK() { return host_primask(); }
+inline void __WFI() { host_wfi(); }
+
+struct SysTick_Type
+{
+	struct Value { operator uint32_t() const { return host_systick_value(); } };
+	uint32_t CTRL;
+	uint32_t LOAD;
+	Value VAL;
+};
+inline SysTick_Type host_systick{};
+#define SysTick (&host_systick)
+#define SysTick_CTRL_ENABLE_Msk 1ul
+
+struct DWT_Type
+{
+	struct Counter { operator uint32_t() const { return host_cycles(); } };
+	Counter CYCCNT;
+};
+inline DWT_Type host_dwt{};
+#define DWT (&host_dwt)
+
+inline uint32_t SystemCoreClock = 168'000'000;
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Just enough of the GPIO connector for the peripheral drivers to compile,
+// the simulated peripherals have no pins.
+
+#pragma once
+
+namespace modm::platform
+{
+
+enum class
+Peripheral
+{
+	Spi1,
+};
+
+struct Gpio
+{
+	enum class Signal { Sck, Mosi, Miso };
+	enum class OutputType { PushPull };
+	enum class InputType { Floating };
+};
+
+template< Peripheral peripheral, class... Signals >
+struct GpioConnector
+{
+	template< Gpio::Signal signal >
+	using GetSignal = void;
+
+	static void connect() {}
+};
+
+} // namespace modm::platform
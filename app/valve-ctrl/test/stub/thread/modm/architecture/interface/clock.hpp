@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Host clocks for tests with real threads: every call advances the time by
+// a fixed step, so timestamps are unique and monotonic across all threads.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace modm
+{
+
+namespace chrono
+{
+
+struct micro_clock
+{
+	using duration = std::chrono::duration<uint32_t, std::micro>;
+	using rep = duration::rep;
+	using period = duration::period;
+	using time_point = std::chrono::time_point<micro_clock, duration>;
+
+	static constexpr bool is_steady = false;
+
+	static time_point
+	now() noexcept
+	{
+		static std::atomic<uint32_t> time{0};
+		return time_point{duration{time.fetch_add(7, std::memory_order_relaxed) + 7}};
+	}
+};
+
+struct milli_clock
+{
+	using duration = std::chrono::duration<uint32_t, std::milli>;
+	using rep = duration::rep;
+	using period = duration::period;
+	using time_point = std::chrono::time_point<milli_clock, duration>;
+
+	static constexpr bool is_steady = false;
+
+	static time_point
+	now() noexcept
+	{
+		return time_point{duration{micro_clock::now().time_since_epoch().count() / 1000}};
+	}
+};
+
+} // namespace chrono
+
+using Clock = chrono::milli_clock;
+using PreciseClock = chrono::micro_clock;
+using namespace ::std::chrono_literals;
+
+} // namespace modm
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Host threads stand in for fibers, so concurrent producers really preempt
+// each other and the sanitizer sees every data race.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace modm::fiber
+{
+
+using id = uintptr_t;
+
+} // namespace modm::fiber
+
+namespace modm::this_fiber
+{
+
+inline modm::fiber::id
+get_id()
+{
+	// the log ring marks free lines with get_id() + 1 == 0
+	return std::hash<std::thread::id>{}(std::this_thread::get_id()) & ~uintptr_t(1);
+}
+
+inline void
+yield()
+{
+	std::this_thread::yield();
+}
+
+} // namespace modm::this_fiber
@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2024, Alexander Evers
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+// ----------------------------------------------------------------------------
+
+// Enumeration and transfer scenarios of CdcAcmDevice against a simulated
+// USB OTG FS core.
+//
+// The register model implements the parts of the core that the driver uses:
+// the receive FIFO with its status words, the transmit FIFOs with their free
+// space, the endpoint control and transfer size registers, and the interrupt
+// hierarchy from the endpoint flags up to GINTSTS. The host side issues
+// SETUP, IN and OUT tokens like a full speed host controller, including NAKs
+// for endpoints that are not enabled and STALL handshakes.
+
+#include <modm/platform/usb/cdc_acm.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace modm::platform::otg;
+
+#define REQUIRE(condition) \
+	do { if (not (condition)) { std::fprintf(stderr, "%s:%d: REQUIRE(%s) failed\n", __FILE__, __LINE__, #condition); std::abort(); } } while(0)
+
+// ----------------------------------------------------------------------------
+/// Register file and FIFOs of the simulated OTG core.
+struct Model
+{
+	std::map<uint32_t, uint32_t> registers;
+	/// receive FIFO entries: status word and payload words
+	std::deque<std::pair<uint32_t, std::vector<uint32_t>>> rx;
+	std::vector<uint32_t> popped;
+	std::size_t poppedIndex{0};
+	std::vector<uint8_t> tx[4];
+	/// transmit FIFO depths in words, as configured by the driver
+	static constexpr uint32_t depth[4]{16, 128, 16, 16};
+
+	uint32_t&
+	operator[](uint32_t offset)
+	{ return registers[offset]; }
+} model;
+
+struct Registers
+{
+	static uint32_t
+	read(uint32_t offset)
+	{
+		if (offset == GRSTCTL) return GRSTCTL_AHBIDL;
+		if (offset == GINTSTS)
+		{
+			uint32_t value = model[GINTSTS];
+			if (not model.rx.empty()) value |= GINT_RXFLVL;
+			const uint32_t daint = read(DAINT);
+			if (daint & 0xffff) value |= GINT_IEPINT;
+			if (daint >> 16) value |= GINT_OEPINT;
+			return value;
+		}
+		if (offset == DAINT)
+		{
+			uint32_t daint = 0;
+			for (uint32_t ep = 0; ep < 4; ep++)
+			{
+				const uint32_t mask = model[DIEPMSK] | (((model[DIEPEMPMSK] >> ep) & 1) << 7);
+				if (read(DIEPINT(ep)) & mask) daint |= 1ul << ep;
+				if (model[DOEPINT(ep)] & model[DOEPMSK]) daint |= 1ul << (16 + ep);
+			}
+			return daint;
+		}
+		if (offset == GRXSTSP)
+		{
+			REQUIRE(not model.rx.empty());
+			const auto [status, words] = model.rx.front();
+			model.rx.pop_front();
+			model.popped = words;
+			model.poppedIndex = 0;
+			// the core raises the completion flags once the status is popped
+			const uint32_t ep = status & 0xf, packet = (status >> 17) & 0xf;
+			if (packet == 4) model[DOEPINT(0)] |= DOEPINT_STUP;
+			if (packet == 3)
+			{
+				model[DOEPINT(ep)] |= EPINT_XFRC;
+				model[DOEPCTL(ep)] &= ~EPCTL_EPENA;
+			}
+			return status;
+		}
+		if (offset == FIFO(0))
+		{
+			REQUIRE(model.poppedIndex < model.popped.size());
+			return model.popped[model.poppedIndex++];
+		}
+		for (uint32_t ep = 0; ep < 4; ep++)
+		{
+			if (offset == DIEPINT(ep))
+				return model[offset] | (model.tx[ep].empty() ? uint32_t(DIEPINT_TXFE) : 0);
+			if (offset == DTXFSTS(ep))
+				return Model::depth[ep] - (model.tx[ep].size() + 3) / 4;
+		}
+		return model[offset];
+	}
+
+	static void
+	write(uint32_t offset, uint32_t value)
+	{
+		if (offset == GINTSTS) { model[offset] &= ~value; return; }
+		if (offset == GRSTCTL)
+		{
+			if (value & GRSTCTL_TXFFLSH) for (auto &fifo : model.tx) fifo.clear();
+			if (value & GRSTCTL_RXFFLSH) model.rx.clear();
+			return;
+		}
+		for (uint32_t ep = 0; ep < 4; ep++)
+		{
+			if (offset == DIEPINT(ep) or offset == DOEPINT(ep)) { model[offset] &= ~value; return; }
+			if (offset == FIFO(ep))
+			{
+				for (int byte = 0; byte < 4; byte++) model.tx[ep].push_back(value >> (8 * byte));
+				REQUIRE(model.tx[ep].size() <= Model::depth[ep] * 4);
+				return;
+			}
+			// the set/clear bits are write only
+			if (offset == DIEPCTL(ep) or offset == DOEPCTL(ep))
+			{
+				if (value & EPCTL_CNAK) value &= ~(EPCTL_CNAK | EPCTL_SNAK);
+				value &= ~EPCTL_SD0PID;
+			}
+		}
+		model[offset] = value;
+	}
+
+	static void delay() {}
+	static void enableInterrupt() {}
+	static uint32_t serialNumber() { return 0x1234'ABCD; }
+	struct Lock { Lock() {} ~Lock() {} };
+};
+
+using Device = modm::platform::CdcAcmDevice<Registers, 2048, 512>;
+
+static void
+interrupt()
+{
+	for (int ii = 0; ii < 100 and (Registers::read(GINTSTS) & Registers::read(GINTMSK)); ii++)
+		Device::handleInterrupt();
+}
+
+// ----------------------------------------------------------------------------
+// Host side
+constexpr int Nak = -1;
+constexpr int Stall = -2;
+
+/// IN token, returns the packet size or Nak/Stall.
+static int
+in(uint32_t ep, std::vector<uint8_t> &packet)
+{
+	interrupt();
+	uint32_t &control = model[DIEPCTL(ep)];
+	if (control & EPCTL_STALL) return Stall;
+	if (not (control & EPCTL_EPENA)) return Nak;
+	uint32_t &tsiz = model[DIEPTSIZ(ep)];
+	uint32_t size = tsiz & 0x7ffff, packets = (tsiz >> 19) & 0x3ff;
+	const uint32_t length = std::min<uint32_t>(size, 64);
+	// FIFO underrun
+	if (model.tx[ep].size() < length) return Nak;
+	packet.assign(model.tx[ep].begin(), model.tx[ep].begin() + length);
+	model.tx[ep].erase(model.tx[ep].begin(), model.tx[ep].begin() + (length + 3) / 4 * 4);
+	size -= length;
+	packets--;
+	tsiz = (packets << 19) | size;
+	if (packets == 0)
+	{
+		REQUIRE(size == 0);
+		control &= ~EPCTL_EPENA;
+		model[DIEPINT(ep)] |= EPINT_XFRC;
+	}
+	interrupt();
+	return length;
+}
+
+static std::vector<uint32_t>
+words(const uint8_t *data, std::size_t length)
+{
+	std::vector<uint32_t> words;
+	for (std::size_t ii = 0; ii < length; ii += 4)
+	{
+		uint32_t word = 0;
+		std::memcpy(&word, data + ii, std::min<std::size_t>(4, length - ii));
+		words.push_back(word);
+	}
+	return words;
+}
+
+/// OUT token, returns false on NAK or STALL.
+static bool
+out(uint32_t ep, const uint8_t *data, std::size_t length)
+{
+	interrupt();
+	uint32_t &control = model[DOEPCTL(ep)];
+	if (control & EPCTL_STALL) return false;
+	if (not (control & EPCTL_EPENA)) return false;
+	uint32_t &tsiz = model[DOEPTSIZ(ep)];
+	uint32_t size = tsiz & 0x7ffff, packets = (tsiz >> 19) & 0x3ff;
+	REQUIRE(packets > 0);
+	model.rx.push_back({ep | (uint32_t(length) << 4) | (2u << 17), words(data, length)});
+	packets--;
+	size -= std::min<uint32_t>(size, length);
+	tsiz = (tsiz & ~(0x3ffu << 19) & ~0x7ffffu) | (packets << 19) | size;
+	if (packets == 0 or length < 64) model.rx.push_back({ep | (3u << 17), {}});
+	interrupt();
+	return true;
+}
+
+static void
+setup(const std::vector<uint8_t> &request)
+{
+	// a SETUP token clears the stall of the control endpoint
+	model[DIEPCTL(0)] &= ~EPCTL_STALL;
+	model[DOEPCTL(0)] &= ~EPCTL_STALL;
+	model.rx.push_back({0 | (8u << 4) | (6u << 17), words(request.data(), 8)});
+	model.rx.push_back({0 | (4u << 17), {}});
+	interrupt();
+}
+
+/// Control read with data stage, returns an empty vector if stalled.
+static std::vector<uint8_t>
+controlIn(const std::vector<uint8_t> &request, bool stall = false)
+{
+	setup(request);
+	const std::size_t length = request[6] | request[7] << 8;
+	std::vector<uint8_t> data, packet;
+	while (true)
+	{
+		const int result = in(0, packet);
+		if (result == Stall) { REQUIRE(stall); return {}; }
+		REQUIRE(result >= 0);
+		data.insert(data.end(), packet.begin(), packet.end());
+		if (result < 64 or data.size() == length) break;
+	}
+	REQUIRE(not stall);
+	// status stage
+	REQUIRE(out(0, nullptr, 0));
+	return data;
+}
+
+/// Control write with optional data stage.
+static void
+controlOut(const std::vector<uint8_t> &request, const std::vector<uint8_t> &data = {}, bool stall = false)
+{
+	setup(request);
+	if (not data.empty()) REQUIRE(out(0, data.data(), data.size()));
+	std::vector<uint8_t> packet;
+	const int result = in(0, packet);
+	REQUIRE(result == (stall ? Stall : 0));
+}
+
+// ----------------------------------------------------------------------------
+static void
+enumeration()
+{
+	Device::initialize();
+	REQUIRE(not (model[DCTL] & DCTL_SDIS));
+	model[GINTSTS] |= GINT_USBRST;
+	interrupt();
+	model[GINTSTS] |= GINT_ENUMDNE;
+	interrupt();
+
+	const auto device = controlIn({0x80, 6, 0, 1, 0, 0, 64, 0});
+	REQUIRE(device.size() == 18 and device[0] == 18);
+	controlOut({0x00, 5, 7, 0, 0, 0, 0, 0});
+	REQUIRE(((model[DCFG] >> 4) & 0x7f) == 7);
+
+	// configuration descriptor: header only, everything, exact length
+	REQUIRE(controlIn({0x80, 6, 0, 2, 0, 0, 9, 0}).size() == 9);
+	const auto configuration = controlIn({0x80, 6, 0, 2, 0, 0, 0xff, 0});
+	REQUIRE(configuration.size() == 75 and configuration[2] == 75);
+	REQUIRE(controlIn({0x80, 6, 0, 2, 0, 0, 75, 0}).size() == 75);
+
+	// languages, product and serial number derived from the unique ID
+	REQUIRE(controlIn({0x80, 6, 0, 3, 0, 0, 0xff, 0}).size() == 4);
+	const auto product = controlIn({0x80, 6, 2, 3, 9, 4, 0xff, 0});
+	REQUIRE(product.size() == 2 + 2 * 16 and product[2] == 'V');
+	const auto serial = controlIn({0x80, 6, 3, 3, 9, 4, 0xff, 0});
+	REQUIRE(serial.size() == 18 and serial[2] == '1' and serial[16] == 'D');
+
+	// full speed only device, unknown string
+	controlIn({0x80, 6, 0, 6, 0, 0, 10, 0}, true);
+	controlIn({0x80, 6, 9, 3, 9, 4, 0xff, 0}, true);
+
+	controlOut({0x00, 9, 1, 0, 0, 0, 0, 0});
+	REQUIRE(Device::isConfigured());
+	const auto current = controlIn({0x80, 8, 0, 0, 0, 0, 1, 0});
+	REQUIRE(current.size() == 1 and current[0] == 1);
+
+	// class requests
+	controlOut({0x21, 0x20, 0, 0, 0, 0, 7, 0}, {0x00, 0x10, 0x0e, 0x00, 0, 0, 8});
+	REQUIRE(Device::getLineCoding().baudrate == 921600);
+	const auto coding = controlIn({0xa1, 0x21, 0, 0, 0, 0, 7, 0});
+	REQUIRE(coding.size() == 7 and coding[2] == 0x0e);
+	REQUIRE(not Device::isTerminalConnected());
+	controlOut({0x21, 0x22, 3, 0, 0, 0, 0, 0});
+	REQUIRE(Device::isTerminalConnected());
+	controlOut({0x21, 0x7f, 0, 0, 0, 0, 0, 0}, {}, true);
+
+	// halt and resume the data IN endpoint
+	controlOut({0x02, 3, 0, 0, 0x81, 0, 0, 0});
+	REQUIRE(model[DIEPCTL(1)] & EPCTL_STALL);
+	controlOut({0x02, 1, 0, 0, 0x81, 0, 0, 0});
+	REQUIRE(not (model[DIEPCTL(1)] & EPCTL_STALL));
+	std::printf("enumeration: ok\n");
+}
+
+static void
+bulkIn(std::mt19937 &random)
+{
+	// the application writes random chunks while the host polls irregularly
+	constexpr std::size_t Total = 300'000;
+	std::vector<uint8_t> sent, received, packet;
+	std::size_t zlps = 0;
+	const auto poll = [&]
+	{
+		const int result = in(1, packet);
+		if (result < 0) return false;
+		received.insert(received.end(), packet.begin(), packet.end());
+		if (result == 0) zlps++;
+		return true;
+	};
+	for (std::size_t iteration = 0; received.size() < Total; iteration++)
+	{
+		REQUIRE(iteration < 300'000);
+		if (sent.size() < Total)
+		{
+			uint8_t buffer[300];
+			const std::size_t length = std::min<std::size_t>(random() % 300 + 1, Total - sent.size());
+			for (std::size_t ii = 0; ii < length; ii++) buffer[ii] = random();
+			const std::size_t written = Device::write(buffer, length);
+			sent.insert(sent.end(), buffer, buffer + written);
+			// full packets that end a transfer need a zero length packet
+			if (random() % 7 == 0)
+			{
+				for (std::size_t ii = 0; ii < 64; ii++) buffer[ii] = random();
+				const std::size_t written = Device::write(buffer, 64);
+				sent.insert(sent.end(), buffer, buffer + written);
+			}
+		}
+		for (int polls = random() % 6; polls; polls--) poll();
+	}
+	while (not Device::isWriteFinished()) poll();
+	REQUIRE(received == sent);
+	std::printf("bulk in: %zu bytes, %zu zero length packets\n", received.size(), zlps);
+
+	// a transfer of full packets is terminated with a zero length packet
+	const uint8_t block[128]{1};
+	REQUIRE(Device::write(block, sizeof(block)) == sizeof(block));
+	std::vector<int> packets;
+	for (int result; (result = in(1, packet)) != Nak; ) packets.push_back(result);
+	REQUIRE((packets == std::vector<int>{64, 64, 0}));
+}
+
+static void
+bulkOut(std::mt19937 &random)
+{
+	// the application reads slowly, so the endpoint must NAK when full
+	std::vector<uint8_t> sent, received;
+	std::size_t naks = 0;
+	while (sent.size() < 200'000)
+	{
+		uint8_t buffer[64];
+		const std::size_t length = random() % 65;
+		for (std::size_t ii = 0; ii < length; ii++) buffer[ii] = random();
+		if (out(1, buffer, length)) sent.insert(sent.end(), buffer, buffer + length);
+		else naks++;
+		if (random() % 3 == 0)
+		{
+			uint8_t data[100];
+			const std::size_t length = Device::read(data, random() % 100);
+			received.insert(received.end(), data, data + length);
+		}
+		REQUIRE(Device::receiveBufferSize() <= 512);
+	}
+	uint8_t data[600];
+	while (const std::size_t length = Device::read(data, sizeof(data)))
+		received.insert(received.end(), data, data + length);
+	REQUIRE(received == sent);
+	std::printf("bulk out: %zu bytes, %zu NAKs\n", received.size(), naks);
+}
+
+static void
+resetDuringTransfer()
+{
+	Device::write(reinterpret_cast<const uint8_t*>("hello"), 5);
+	model[GINTSTS] |= GINT_USBRST;
+	interrupt();
+	REQUIRE(not Device::isConfigured());
+	controlOut({0x00, 9, 1, 0, 0, 0, 0, 0});
+	REQUIRE(Device::isConfigured());
+
+	// the buffered data is sent after the configuration
+	std::vector<uint8_t> received, packet;
+	while (in(1, packet) >= 0) received.insert(received.end(), packet.begin(), packet.end());
+	REQUIRE(received == std::vector<uint8_t>({'h', 'e', 'l', 'l', 'o'}));
+	std::printf("reset: ok\n");
+}
+
+int
+main()
+{
+	std::mt19937 random(1);
+	enumeration();
+	bulkIn(random);
+	bulkOut(random);
+	resetDuringTransfer();
+	std::printf("OK\n");
+	return 0;
+}